@@ -6,6 +6,125 @@
 #include "TimerManager.h"
 #include "Kismet/GameplayStatics.h"
 
+namespace
+{
+    // Fixed part of the system prompt. Sent ahead of a cache checkpoint, so any
+    // change here should be rare and deliberate.
+    const TCHAR* const StableSystemPrompt =
+        TEXT("You are a friendly and knowledgeable restaurant concierge assistant. ")
+        TEXT("Your role is to help users discover great dining experiences by providing personalized restaurant recommendations. ")
+        TEXT("Guidelines:\n")
+        TEXT("- Be conversational, warm, and enthusiastic about food and dining\n")
+        TEXT("- Provide specific details about restaurants including cuisine type, price range, ratings, and hours\n")
+        TEXT("- Ask clarifying questions to better understand user preferences\n")
+        TEXT("- Keep responses under 30 seconds when spoken\n")
+        TEXT("- If you don't have specific information, acknowledge it and offer to help in other ways\n");
+
+    // Text models served through the Converse API, all of which accept cachePoint
+    // blocks. The service skips checkpoints whose prefix is below its minimum length,
+    // so marking a short prefix is harmless.
+    const TCHAR* const ConverseModels[] =
+    {
+        TEXT("amazon.nova-micro"),
+        TEXT("amazon.nova-lite"),
+        TEXT("amazon.nova-pro"),
+        TEXT("amazon.nova-premier"),
+        TEXT("anthropic.claude-3-5-haiku"),
+        TEXT("anthropic.claude-3-7-sonnet"),
+        TEXT("anthropic.claude-sonnet-4"),
+        TEXT("anthropic.claude-opus-4"),
+    };
+
+    bool IsConverseModel(const FString& ModelId)
+    {
+        for (const TCHAR* Model : ConverseModels)
+        {
+            if (ModelId.Contains(Model))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Appends Value escaped for use inside a JSON string, without the quotes
+    void AppendJsonEscaped(FString& Out, const FString& Value)
+    {
+        const TCHAR* Chars = *Value;
+        int32 RunStart = 0;
+        for (int32 i = 0; i < Value.Len(); i++)
+        {
+            const TCHAR Char = Chars[i];
+            if (Char != TEXT('"') && Char != TEXT('\\') && Char >= 0x20)
+            {
+                continue;
+            }
+            
+            Out.AppendChars(Chars + RunStart, i - RunStart);
+            RunStart = i + 1;
+            switch (Char)
+            {
+            case TEXT('"'):  Out += TEXT("\\\""); break;
+            case TEXT('\\'): Out += TEXT("\\\\"); break;
+            case TEXT('\n'): Out += TEXT("\\n"); break;
+            case TEXT('\r'): Out += TEXT("\\r"); break;
+            case TEXT('\t'): Out += TEXT("\\t"); break;
+            default:         Out += FString::Printf(TEXT("\\u%04x"), static_cast<uint32>(Char)); break;
+            }
+        }
+        Out.AppendChars(Chars + RunStart, Value.Len() - RunStart);
+    }
+
+    // Appends Value as a quoted JSON string
+    void AppendJsonString(FString& Out, const FString& Value)
+    {
+        Out += TEXT("\"");
+        AppendJsonEscaped(Out, Value);
+        Out += TEXT("\"");
+    }
+
+    // Concatenated text blocks of the message in a Converse response
+    FString GetConverseOutputText(const FJsonObject& Response)
+    {
+        FString Text;
+        const TSharedPtr<FJsonObject>* Output = nullptr;
+        const TSharedPtr<FJsonObject>* Message = nullptr;
+        const TArray<TSharedPtr<FJsonValue>>* Content = nullptr;
+        if (!Response.TryGetObjectField(TEXT("output"), Output)
+            || !(*Output)->TryGetObjectField(TEXT("message"), Message)
+            || !(*Message)->TryGetArrayField(TEXT("content"), Content))
+        {
+            return Text;
+        }
+        
+        for (const TSharedPtr<FJsonValue>& Block : *Content)
+        {
+            const TSharedPtr<FJsonObject>* BlockObject = nullptr;
+            FString BlockText;
+            if (Block->TryGetObject(BlockObject) && (*BlockObject)->TryGetStringField(TEXT("text"), BlockText))
+            {
+                Text += BlockText;
+            }
+        }
+        return Text;
+    }
+
+    // Upper limit of MaxContextRestaurants
+    constexpr int32 MaxRenderedRestaurants = 50;
+
+    // One line per restaurant, fields the packer leaves out or the restaurant lacks
+    // take their separator with them. The location is already in the prompt.
+    FRestaurantContextTemplateSource MakeContextTemplate()
+    {
+        FRestaurantContextTemplateSource Template;
+        Template.ListHeader = TEXT("Restaurants, best match first:\n");
+        Template.Entry = TEXT("{Index}. {Name}[ | {Cuisines}][ | {Price}][ | {Rating}/5[ ({Reviews} reviews)]][ | {Distance}]")
+            TEXT("[ | today {HoursToday}][ | {Phone}][ | {Services}][ | {Address}]\n");
+        Template.Version = 2;
+        return Template;
+    }
+}
+
 ABedrockAudioManager::ABedrockAudioManager()
 {
     PrimaryActorTick.bCanEverTick = true;
@@ -13,6 +132,10 @@ ABedrockAudioManager::ABedrockAudioManager()
     // Create audio output component
     AudioOutputComponent = CreateDefaultSubobject<UAudioComponent>(TEXT("AudioOutputComponent"));
     RootComponent = AudioOutputComponent;
+    
+    ContextRenderer = MakeUnique<FRestaurantContextRenderer>(MakeContextTemplate(), MaxRenderedRestaurants);
+    Conversation = MakeShared<FConciergeConversationMemory, ESPMode::ThreadSafe>();
+    ResponseCache = MakeUnique<FConciergeResponseCache>();
 }
 
 void ABedrockAudioManager::BeginPlay()
@@ -20,6 +143,13 @@ void ABedrockAudioManager::BeginPlay()
     Super::BeginPlay();
     
     InitializeAudioCapture();
+    Conversation->Configure(MaxHistoryTurns, MaxHistoryTokens, MaxSummaryTokens);
+    
+    FConciergeResponseCache::FSettings CacheSettings;
+    CacheSettings.MaxEntries = MaxCachedResponses;
+    CacheSettings.TimeToLiveSeconds = ResponseCacheTTLSeconds;
+    CacheSettings.MinSimilarity = ResponseCacheMinSimilarity;
+    ResponseCache->Configure(CacheSettings);
     
     UE_LOG(LogTemp, Log, TEXT("BedrockAudioManager initialized"));
 }
@@ -104,6 +234,12 @@ void ABedrockAudioManager::ProcessSpeechInput(const TArray<uint8>& AudioData)
         return;
     }
     
+    // The transcript, if any, comes back with the response
+    ResetConversationIfIdle();
+    PendingUserText.Reset();
+    PendingContextHash = ComputeResponseContextHash();
+    PendingResultsHash = ResultsHash;
+    
     // Convert audio to required format
     TArray<uint8> ProcessedAudio = ConvertAudioToFormat(AudioData);
     FString AudioBase64 = EncodeAudioToBase64(ProcessedAudio);
@@ -125,6 +261,16 @@ void ABedrockAudioManager::ProcessTextInput(const FString& InputText)
     
     UE_LOG(LogTemp, Log, TEXT("Processing text input: %s"), *InputText);
     
+    ResetConversationIfIdle();
+    PendingUserText = InputText;
+    PendingContextHash = ComputeResponseContextHash();
+    PendingResultsHash = ResultsHash;
+    
+    if (TryAnswerFromCache(InputText))
+    {
+        return;
+    }
+    
     if (bUseMockBedrock)
     {
         ProcessMockBedrock(InputText);
@@ -144,6 +290,14 @@ void ABedrockAudioManager::ProcessMockBedrock(const FString& InputText)
     {
         FString MockResponse = GenerateMockResponse(InputText);
         
+        // Recorded before handlers run, they may already ask the next question.
+        // Results that changed meanwhile emptied the cache, the answer is stale for it.
+        Conversation->AddTurn(InputText, MockResponse);
+        if (bUseResponseCache && ResultsHash == PendingResultsHash)
+        {
+            ResponseCache->Add(InputText, PendingContextHash, MockResponse, nullptr);
+        }
+        
         // Broadcast text response
         OnSpeechProcessed.Broadcast(MockResponse);
         
@@ -213,24 +367,50 @@ void ABedrockAudioManager::SetRestaurantContext(const FString& Location, const T
     CurrentLocation = Location;
     CurrentRestaurants = Restaurants;
     
-    // Build context string for Bedrock
-    RestaurantContext = TEXT("Current location: ") + Location + TEXT("\n\n");
+    // A full list replaces whatever progressive session was being assembled
+    DeltaSessionId = INDEX_NONE;
+    DeltaRestaurants.Empty();
+    
+    OnRestaurantsChanged();
+    
+    UE_LOG(LogTemp, Log, TEXT("Restaurant context updated: %d restaurants in %s"), Restaurants.Num(), *Location);
+}
+
+void ABedrockAudioManager::ApplyRestaurantDelta(const FString& Location, const FRestaurantResultDelta& Delta)
+{
+    if (Delta.SessionId != DeltaSessionId)
+    {
+        DeltaSessionId = Delta.SessionId;
+        DeltaRestaurants.Empty();
+    }
     
-    if (Restaurants.Num() > 0)
+    for (const TArray<FRestaurantDeltaEntry>* Entries : { &Delta.Added, &Delta.Updated })
     {
-        RestaurantContext += TEXT("Available restaurants:\n");
-        
-        for (int32 i = 0; i < FMath::Min(Restaurants.Num(), 10); i++)
+        for (const FRestaurantDeltaEntry& Entry : *Entries)
         {
-            const FRestaurantData& Restaurant = Restaurants[i];
-            RestaurantContext += FString::Printf(TEXT("%d. %s - %s cuisine, %s price range, %.1f stars\n"), 
-                i + 1, *Restaurant.Name, 
-                Restaurant.CuisineTypes.Num() > 0 ? *Restaurant.CuisineTypes[0] : TEXT("Various"),
-                *Restaurant.PriceLevel, Restaurant.Rating);
+            DeltaRestaurants.Add(Entry.ResultId, Entry.Restaurant);
         }
     }
     
-    UE_LOG(LogTemp, Log, TEXT("Restaurant context updated: %d restaurants in %s"), Restaurants.Num(), *Location);
+    for (int32 RemovedId : Delta.RemovedIds)
+    {
+        DeltaRestaurants.Remove(RemovedId);
+    }
+    
+    CurrentLocation = Location;
+    CurrentRestaurants.Reset(Delta.RankedIds.Num());
+    for (int32 ResultId : Delta.RankedIds)
+    {
+        if (const FRestaurantData* Restaurant = DeltaRestaurants.Find(ResultId))
+        {
+            CurrentRestaurants.Add(*Restaurant);
+        }
+    }
+    
+    OnRestaurantsChanged();
+    
+    UE_LOG(LogTemp, Log, TEXT("Restaurant context delta applied: %d restaurants in %s%s"),
+        CurrentRestaurants.Num(), *Location, Delta.bFinal ? TEXT(" (final)") : TEXT(""));
 }
 
 void ABedrockAudioManager::UpdateUserPreferences(const TArray<FString>& Preferences)
@@ -239,59 +419,231 @@ void ABedrockAudioManager::UpdateUserPreferences(const TArray<FString>& Preferen
     UE_LOG(LogTemp, Log, TEXT("User preferences updated: %s"), *FString::Join(Preferences, TEXT(", ")));
 }
 
+void ABedrockAudioManager::ResetConversation()
+{
+    Conversation->Reset();
+    UE_LOG(LogTemp, Log, TEXT("Conversation reset"));
+}
+
+uint32 ABedrockAudioManager::ComputeResponseContextHash() const
+{
+    // The results are left out, a change there drops the whole cache instead
+    uint32 Hash = HashCombine(GetTypeHash(BedrockModelId), GetTypeHash(CurrentLocation));
+    for (const FString& Preference : UserPreferences)
+    {
+        Hash = HashCombine(Hash, GetTypeHash(Preference));
+    }
+    
+    // Follow-ups mean something else after a different conversation
+    Hash = HashCombine(Hash, GetTypeHash(Conversation->GetSummary()));
+    for (int32 i = 0; i < Conversation->Num(); i++)
+    {
+        const FConciergeConversationMemory::FTurn& Turn = Conversation->GetTurn(i);
+        Hash = HashCombine(Hash, HashCombine(GetTypeHash(Turn.UserText), GetTypeHash(Turn.AssistantText)));
+    }
+    
+    // "Open now" and "open late" answers expire with the quarter hour the open slots are kept in
+    const int64 QuarterHour = FDateTime::UtcNow().GetTicks() / (ETimespan::TicksPerMinute * FRestaurantOpenHours::SlotMinutes);
+    Hash = HashCombine(Hash, GetTypeHash(QuarterHour));
+    
+    return Hash;
+}
+
+void ABedrockAudioManager::OnRestaurantsChanged()
+{
+    // Fields the concierge may quote, in list order
+    uint32 Hash = GetTypeHash(CurrentRestaurants.Num());
+    for (const FRestaurantData& Restaurant : CurrentRestaurants)
+    {
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.Name));
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.GooglePlaceId));
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.YelpBusinessId));
+        Hash = HashCombine(Hash, GetTypeHash(FMath::RoundToInt(Restaurant.Rating * 10.0f)));
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.PriceLevel));
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.PhoneNumber));
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.ReviewCount));
+        Hash = HashCombine(Hash, FCrc::StrCrc32(FRestaurantContextRenderer::GetTodayHours(Restaurant.Hours)));
+        Hash = HashCombine(Hash, GetTypeHash(FMath::RoundToInt(Restaurant.DistanceFromUser / 10.0f)));
+    }
+    
+    // A re-broadcast of the same results keeps the answers
+    if (Hash != ResultsHash)
+    {
+        ResultsHash = Hash;
+        ResponseCache->Invalidate();
+    }
+}
+
+bool ABedrockAudioManager::TryAnswerFromCache(const FString& InputText)
+{
+    if (!bUseResponseCache)
+    {
+        return false;
+    }
+    
+    const FConciergeResponseCache::FResponse* Cached = ResponseCache->Find(InputText, PendingContextHash);
+    if (!Cached)
+    {
+        return false;
+    }
+    
+    // Copied first, handlers may change the context and with it the cache
+    const FString ResponseText = Cached->Text;
+    USoundWave* AudioResponse = Cached->Audio;
+    
+    UE_LOG(LogTemp, Log, TEXT("Answered from the response cache: %s"), *InputText);
+    
+    bIsProcessing = false;
+    Conversation->AddTurn(InputText, ResponseText);
+    OnSpeechProcessed.Broadcast(ResponseText);
+    if (AudioResponse)
+    {
+        OnAudioResponseReady.Broadcast(AudioResponse);
+    }
+    return true;
+}
+
+void ABedrockAudioManager::ResetConversationIfIdle()
+{
+    if (ConversationIdleResetSeconds > 0.0f && Conversation->GetSecondsSinceLastTurn() > ConversationIdleResetSeconds)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Conversation idle, starting a new one"));
+        Conversation->Reset();
+    }
+}
+
 void ABedrockAudioManager::SetBedrockConfiguration(const FString& Region, const FString& ModelId)
 {
     BedrockRegion = Region;
     BedrockModelId = ModelId;
+    RequestPrefix.Reset();
     UE_LOG(LogTemp, Log, TEXT("Bedrock configuration updated: %s in %s"), *ModelId, *Region);
 }
 
 FString ABedrockAudioManager::BuildBedrockRequestBody(const FString& InputText, const FString& AudioBase64)
 {
-    TSharedPtr<FJsonObject> RequestObject = MakeShareable(new FJsonObject);
+    // Converse takes no audio, speech always goes through the model's own invoke format
+    const bool bConverse = AudioBase64.IsEmpty() && IsConverseModel(BedrockModelId);
+    if (RequestPrefix.IsEmpty() || bConverse != bConverseRequest)
+    {
+        BuildRequestPrefix(bConverse);
+    }
+    
+    const FString SystemSuffix = BuildSystemPrompt(InputText);
+    
+    // The prefix is copied as is, only the per-turn values are escaped
+    FString OutputString;
+    OutputString.Reserve(RequestPrefix.Len() + SystemSuffix.Len() + Conversation->GetTurnTokens() * 4 + InputText.Len() + AudioBase64.Len() + 128);
+    OutputString += RequestPrefix;
+    
+    if (bConverse)
+    {
+        if (!SystemSuffix.IsEmpty())
+        {
+            OutputString += TEXT(",{\"text\":");
+            AppendJsonString(OutputString, SystemSuffix);
+            OutputString += TEXT("}");
+        }
+        
+        // Earlier turns oldest first, then the question
+        OutputString += TEXT("],\"messages\":[");
+        for (int32 i = 0; i < Conversation->Num(); i++)
+        {
+            const FConciergeConversationMemory::FTurn& Turn = Conversation->GetTurn(i);
+            OutputString += TEXT("{\"role\":\"user\",\"content\":[{\"text\":");
+            AppendJsonString(OutputString, Turn.UserText);
+            OutputString += TEXT("}]},{\"role\":\"assistant\",\"content\":[{\"text\":");
+            AppendJsonString(OutputString, Turn.AssistantText);
+            OutputString += TEXT("}]},");
+        }
+        OutputString += TEXT("{\"role\":\"user\",\"content\":[{\"text\":");
+        AppendJsonString(OutputString, InputText);
+        OutputString += TEXT("}]}]}");
+        return OutputString;
+    }
     
-    // Model configuration
-    RequestObject->SetStringField(TEXT("modelId"), BedrockModelId);
+    // The invoke format has no message list, earlier turns continue the system prompt
+    if (!SystemSuffix.IsEmpty())
+    {
+        OutputString += TEXT("\\n");
+        AppendJsonEscaped(OutputString, SystemSuffix);
+    }
     
-    // System prompt
-    FString SystemPrompt = BuildSystemPrompt();
-    RequestObject->SetStringField(TEXT("systemPrompt"), SystemPrompt);
+    if (Conversation->Num() > 0)
+    {
+        OutputString += TEXT("\\nRecent conversation:");
+        for (int32 i = 0; i < Conversation->Num(); i++)
+        {
+            const FConciergeConversationMemory::FTurn& Turn = Conversation->GetTurn(i);
+            OutputString += TEXT("\\nUser: ");
+            AppendJsonEscaped(OutputString, Turn.UserText);
+            OutputString += TEXT("\\nConcierge: ");
+            AppendJsonEscaped(OutputString, Turn.AssistantText);
+        }
+    }
+    OutputString += TEXT("\"");
     
     // Input data
     if (!InputText.IsEmpty())
     {
-        RequestObject->SetStringField(TEXT("inputText"), InputText);
+        OutputString += TEXT(",\"inputText\":");
+        AppendJsonString(OutputString, InputText);
     }
     
     if (!AudioBase64.IsEmpty())
     {
-        RequestObject->SetStringField(TEXT("inputAudio"), AudioBase64);
+        // Base64 needs no escaping
+        OutputString += TEXT(",\"inputAudio\":\"");
+        OutputString += AudioBase64;
+        OutputString += TEXT("\"");
     }
     
-    // Response configuration
-    TSharedPtr<FJsonObject> ResponseConfig = MakeShareable(new FJsonObject);
-    ResponseConfig->SetBoolField(TEXT("includeAudio"), true);
-    ResponseConfig->SetBoolField(TEXT("includeText"), true);
-    RequestObject->SetObjectField(TEXT("responseConfig"), ResponseConfig);
-    
-    FString OutputString;
-    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
-    FJsonSerializer::Serialize(RequestObject.ToSharedRef(), Writer);
-    
+    OutputString += TEXT("}");
     return OutputString;
 }
 
-FString ABedrockAudioManager::BuildSystemPrompt()
+void ABedrockAudioManager::BuildRequestPrefix(bool bConverse)
 {
-    FString SystemPrompt = TEXT("You are a friendly and knowledgeable restaurant concierge assistant. ");
-    SystemPrompt += TEXT("Your role is to help users discover great dining experiences by providing personalized restaurant recommendations. ");
+    // Everything that stays the same from turn to turn, ending where the per-turn
+    // part of the system prompt follows. For Converse that is inside the open
+    // "system" array:
+    // {"system":[{"text":<instructions>},{"cachePoint":..}
+    // and for invoke inside the open "systemPrompt" string:
+    // {"modelId":..,"responseConfig":{..},"systemPrompt":"<instructions>
+    RequestPrefix.Reset();
+    bConverseRequest = bConverse;
+    
+    if (bConverse)
+    {
+        // Instructions first so the service can reuse their processing
+        RequestPrefix += TEXT("{\"system\":[{\"text\":");
+        AppendJsonString(RequestPrefix, StableSystemPrompt);
+        RequestPrefix += TEXT("}");
+        
+        if (bUsePromptCaching)
+        {
+            RequestPrefix += TEXT(",{\"cachePoint\":{\"type\":\"default\"}}");
+        }
+    }
+    else
+    {
+        RequestPrefix += TEXT("{\"modelId\":");
+        AppendJsonString(RequestPrefix, BedrockModelId);
+        
+        // Response configuration
+        RequestPrefix += TEXT(",\"responseConfig\":{\"includeAudio\":true,\"includeText\":true}");
+        
+        RequestPrefix += TEXT(",\"systemPrompt\":\"");
+        AppendJsonEscaped(RequestPrefix, StableSystemPrompt);
+    }
     
-    SystemPrompt += TEXT("Guidelines:\n");
-    SystemPrompt += TEXT("- Be conversational, warm, and enthusiastic about food and dining\n");
-    SystemPrompt += TEXT("- Provide specific details about restaurants including cuisine type, price range, ratings, and hours\n");
-    SystemPrompt += TEXT("- Ask clarifying questions to better understand user preferences\n");
-    SystemPrompt += TEXT("- Keep responses under 30 seconds when spoken\n");
-    SystemPrompt += TEXT("- If you don't have specific information, acknowledge it and offer to help in other ways\n\n");
+    StablePromptTokens = FRestaurantContextPacker::EstimateTokens(StableSystemPrompt);
+}
+
+FString ABedrockAudioManager::BuildSystemPrompt(const FString& Question)
+{
+    // Only what changes between turns, the instructions are in RequestPrefix
+    FString SystemPrompt;
     
     if (!CurrentLocation.IsEmpty())
     {
@@ -303,11 +655,26 @@ FString ABedrockAudioManager::BuildSystemPrompt()
         SystemPrompt += TEXT("User preferences: ") + FString::Join(UserPreferences, TEXT(", ")) + TEXT("\n");
     }
     
-    if (!RestaurantContext.IsEmpty())
+    if (!Conversation->GetSummary().IsEmpty())
+    {
+        SystemPrompt += TEXT("Earlier in this conversation:\n") + Conversation->GetSummary() + TEXT("\n");
+    }
+    
+    // Restaurants get whatever the instructions, the history and the question leave of the budget
+    FRestaurantContextPacker Packer;
+    Packer.MaxRestaurants = MaxContextRestaurants;
+    const int32 RestaurantBudget = MaxPromptTokens - StablePromptTokens - Conversation->GetTurnTokens()
+        - FRestaurantContextPacker::EstimateTokens(SystemPrompt) - FRestaurantContextPacker::EstimateTokens(Question);
+    const FRestaurantContextPacker::FResult Packed = Packer.Pack(*ContextRenderer, CurrentLocation, CurrentRestaurants, Question, RestaurantBudget);
+    
+    if (!Packed.Text.IsEmpty())
     {
-        SystemPrompt += TEXT("\n") + RestaurantContext;
+        SystemPrompt += TEXT("\n") + Packed.Text;
     }
     
+    UE_LOG(LogTemp, Verbose, TEXT("System prompt lists %d of %d restaurants in about %d of %d tokens"),
+        Packed.NumRestaurants, CurrentRestaurants.Num(), Packed.EstimatedTokens, RestaurantBudget);
+    
     return SystemPrompt;
 }
 
@@ -328,8 +695,8 @@ void ABedrockAudioManager::SendBedrockRequest(const FString& RequestBody)
     Request->OnProcessRequestComplete().BindUObject(this, &ABedrockAudioManager::OnBedrockResponse);
     
     // AWS Bedrock endpoint (would need proper AWS SDK integration)
-    FString URL = FString::Printf(TEXT("https://bedrock-runtime.%s.amazonaws.com/model/%s/invoke"), 
-        *BedrockRegion, *BedrockModelId);
+    FString URL = FString::Printf(TEXT("https://bedrock-runtime.%s.amazonaws.com/model/%s/%s"), 
+        *BedrockRegion, *BedrockModelId, bConverseRequest ? TEXT("converse") : TEXT("invoke"));
     
     Request->SetURL(URL);
     Request->SetVerb("POST");
@@ -372,24 +739,56 @@ void ABedrockAudioManager::ProcessBedrockResponse(const FString& ResponseBody)
         return;
     }
     
+    // Taken before any handler runs, a handler may already send the next question
+    FString UserText = PendingUserText;
+    const uint32 ContextHash = PendingContextHash;
+    const bool bResultsChanged = ResultsHash != PendingResultsHash;
+    
     // Extract text response
     FString ResponseText;
-    if (JsonObject->TryGetStringField(TEXT("outputText"), ResponseText))
+    if (bConverseRequest)
     {
-        OnSpeechProcessed.Broadcast(ResponseText);
+        ResponseText = GetConverseOutputText(*JsonObject);
+    }
+    else
+    {
+        JsonObject->TryGetStringField(TEXT("outputText"), ResponseText);
     }
     
     // Extract audio response
     FString AudioBase64;
+    USoundWave* AudioResponse = nullptr;
     if (JsonObject->TryGetStringField(TEXT("outputAudio"), AudioBase64))
     {
-        USoundWave* AudioResponse = DecodeAudioFromBase64(AudioBase64);
-        if (AudioResponse)
+        AudioResponse = DecodeAudioFromBase64(AudioBase64);
+    }
+    
+    // Speech input is only known as text through the transcript
+    if (UserText.IsEmpty())
+    {
+        JsonObject->TryGetStringField(TEXT("inputTranscript"), UserText);
+    }
+    if (!UserText.IsEmpty() && !ResponseText.IsEmpty())
+    {
+        Conversation->AddTurn(UserText, ResponseText);
+        
+        // Results that changed in flight emptied the cache, the answer is stale for it
+        if (bUseResponseCache && !bResultsChanged)
         {
-            OnAudioResponseReady.Broadcast(AudioResponse);
+            ResponseCache->Add(UserText, ContextHash, ResponseText, AudioResponse);
         }
     }
     
+    if (!ResponseText.IsEmpty())
+    {
+        OnSpeechProcessed.Broadcast(ResponseText);
+    }
+    
+    if (AudioResponse)
+    {
+        OnAudioResponseReady.Broadcast(AudioResponse);
+    }
+    
     UE_LOG(LogTemp, Log, TEXT("Bedrock response processed successfully"));
 }
 
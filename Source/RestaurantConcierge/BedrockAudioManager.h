@@ -5,6 +5,10 @@
 #include "Components/AudioComponent.h"
 #include "Sound/SoundWave.h"
 #include "RestaurantData.h"
+#include "RestaurantContextRenderer.h"
+#include "RestaurantContextPacker.h"
+#include "ConciergeConversationMemory.h"
+#include "ConciergeResponseCache.h"
 #include "BedrockAudioManager.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSpeechProcessed, const FString&, ResponseText);
@@ -37,9 +41,17 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Context")
     void SetRestaurantContext(const FString& Location, const TArray<FRestaurantData>& Restaurants);
 
+    // Progressive search results: updates the context from a delta
+    UFUNCTION(BlueprintCallable, Category = "Context")
+    void ApplyRestaurantDelta(const FString& Location, const FRestaurantResultDelta& Delta);
+
     UFUNCTION(BlueprintCallable, Category = "Context")
     void UpdateUserPreferences(const TArray<FString>& Preferences);
 
+    // Forgets earlier turns, e.g. when the next guest steps up to the kiosk
+    UFUNCTION(BlueprintCallable, Category = "Context")
+    void ResetConversation();
+
     UFUNCTION(BlueprintCallable, Category = "Configuration")
     void SetBedrockConfiguration(const FString& Region, const FString& ModelId);
 
@@ -64,6 +76,47 @@ private:
     UPROPERTY(EditAnywhere, Category = "Bedrock Configuration", meta = (AllowPrivateAccess = "true"))
     FString BedrockModelId = "amazon.nova-sonic-v1:0";
 
+    // Token budget for the system prompt, the conversation history and the user's question
+    // together. Restaurants get what the rest leaves; prompt size drives time to first token.
+    UPROPERTY(EditAnywhere, Category = "Bedrock Configuration", meta = (AllowPrivateAccess = "true", ClampMin = "256"))
+    int32 MaxPromptTokens = 1600;
+
+    UPROPERTY(EditAnywhere, Category = "Bedrock Configuration", meta = (AllowPrivateAccess = "true", ClampMin = "1", ClampMax = "50"))
+    int32 MaxContextRestaurants = 20;
+
+    // Mark the end of the fixed instructions as a prompt cache checkpoint, for models on the Converse API
+    UPROPERTY(EditAnywhere, Category = "Bedrock Configuration", meta = (AllowPrivateAccess = "true"))
+    bool bUsePromptCaching = true;
+
+    // Recent turns sent along with each question, the oldest beyond either limit are
+    // folded into a summary of at most MaxSummaryTokens
+    UPROPERTY(EditAnywhere, Category = "Conversation", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+    int32 MaxHistoryTurns = 6;
+
+    UPROPERTY(EditAnywhere, Category = "Conversation", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+    int32 MaxHistoryTokens = 400;
+
+    UPROPERTY(EditAnywhere, Category = "Conversation", meta = (AllowPrivateAccess = "true", ClampMin = "0"))
+    int32 MaxSummaryTokens = 120;
+
+    // A question after this long without one starts a new conversation. 0 keeps it forever.
+    UPROPERTY(EditAnywhere, Category = "Conversation", meta = (AllowPrivateAccess = "true", ClampMin = "0"))
+    float ConversationIdleResetSeconds = 120.0f;
+
+    // Answer repeated questions against the same results without a Bedrock round trip
+    UPROPERTY(EditAnywhere, Category = "Response Cache", meta = (AllowPrivateAccess = "true"))
+    bool bUseResponseCache = true;
+
+    UPROPERTY(EditAnywhere, Category = "Response Cache", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+    int32 MaxCachedResponses = 128;
+
+    UPROPERTY(EditAnywhere, Category = "Response Cache", meta = (AllowPrivateAccess = "true", ClampMin = "0"))
+    float ResponseCacheTTLSeconds = 600.0f;
+
+    // How similar a differently worded question must be to reuse an answer, 0 for exact intents only
+    UPROPERTY(EditAnywhere, Category = "Response Cache", meta = (AllowPrivateAccess = "true", ClampMin = "0", ClampMax = "1"))
+    float ResponseCacheMinSimilarity = 0.85f;
+
     UPROPERTY(EditAnywhere, Category = "Audio Configuration", meta = (AllowPrivateAccess = "true"))
     int32 SampleRate = 16000;
 
@@ -93,8 +146,33 @@ private:
     UPROPERTY()
     TArray<FString> UserPreferences;
 
-    UPROPERTY()
-    FString RestaurantContext;
+    // Restaurants of the progressive session being applied
+    int32 DeltaSessionId = INDEX_NONE;
+    TMap<int32, FRestaurantData> DeltaRestaurants;
+
+    // Restaurant part of the system prompt, packed per question into the token budget
+    TUniquePtr<FRestaurantContextRenderer> ContextRenderer;
+
+    TSharedPtr<FConciergeConversationMemory, ESPMode::ThreadSafe> Conversation;
+
+    // The question awaiting an answer, recorded with it as one turn. Empty for speech input.
+    FString PendingUserText;
+
+    // Answers keyed by intent and ResponseContextHash, dropped whenever the results change
+    TUniquePtr<FConciergeResponseCache> ResponseCache;
+    uint32 PendingContextHash = 0;
+    uint32 ResultsHash = 0;
+
+    // ResultsHash when the question was asked, an answer is only cached if it still matches
+    uint32 PendingResultsHash = 0;
+
+    // Serialized start of every request body up to the per-turn system prompt,
+    // rebuilt when the model or the API it was built for changes
+    FString RequestPrefix;
+    int32 StablePromptTokens = 0;
+
+    // RequestPrefix, and so the request in flight, uses Converse rather than invoke
+    bool bConverseRequest = false;
 
     // Audio processing
     UPROPERTY()
@@ -126,14 +204,23 @@ private:
 
     // Request building
     FString BuildBedrockRequestBody(const FString& InputText = "", const FString& AudioBase64 = "");
-    FString BuildSystemPrompt();
+    void BuildRequestPrefix(bool bConverse);
+
+    // The part of the system prompt that changes between turns
+    FString BuildSystemPrompt(const FString& Question);
     FString BuildRestaurantPrompt(const FString& UserInput);
 
     // Response processing
     void ProcessBedrockResponse(const FString& ResponseBody);
     void HandleBedrockError(const FString& ErrorType, const FString& ErrorMessage);
 
+    // Everything besides the results and the question that an answer depends on
+    uint32 ComputeResponseContextHash() const;
+    void OnRestaurantsChanged();
+    bool TryAnswerFromCache(const FString& InputText);
+
     // Utility methods
+    void ResetConversationIfIdle();
     void InitializeAudioCapture();
     void CleanupAudioCapture();
     void ResetAudioBuffer();
@@ -0,0 +1,191 @@
+#include "ConciergeConversationMemory.h"
+#include "RestaurantContextPacker.h"
+#include "Async/Async.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+    // Words kept of each side of a summarized turn
+    constexpr int32 MaxGistWords = 20;
+
+    void ClipToTokens(FString& Text, int32 MaxTokens)
+    {
+        if (FRestaurantContextPacker::EstimateTokens(Text) <= MaxTokens)
+        {
+            return;
+        }
+
+        // About four characters per token in prose
+        Text.LeftInline(FMath::Max(MaxTokens * 4 - 3, 0), /*bAllowShrinking*/ false);
+        Text += TEXT("...");
+    }
+
+    // First sentence of Text, at most MaxWords long
+    FString GetGist(const FString& Text, int32 MaxWords)
+    {
+        int32 Words = 0;
+        bool bInWord = false;
+        int32 End = Text.Len();
+
+        for (int32 i = 0; i < Text.Len(); i++)
+        {
+            const TCHAR Char = Text[i];
+            if (Char == TEXT('.') || Char == TEXT('?') || Char == TEXT('!'))
+            {
+                End = i + 1;
+                break;
+            }
+            if (FChar::IsWhitespace(Char))
+            {
+                bInWord = false;
+            }
+            else if (!bInWord)
+            {
+                bInWord = true;
+                if (++Words > MaxWords)
+                {
+                    End = i;
+                    break;
+                }
+            }
+        }
+
+        return Text.Left(End).TrimStartAndEnd();
+    }
+}
+
+FConciergeConversationMemory::FConciergeConversationMemory()
+{
+    Ring.SetNum(8);
+}
+
+void FConciergeConversationMemory::Configure(int32 InMaxTurns, int32 InMaxTurnTokens, int32 InMaxSummaryTokens)
+{
+    Reset();
+    Ring.SetNum(FMath::Max(InMaxTurns, 1));
+    MaxTurnTokens = FMath::Max(InMaxTurnTokens, 1);
+    MaxSummaryTokens = FMath::Max(InMaxSummaryTokens, 0);
+}
+
+void FConciergeConversationMemory::AddTurn(const FString& UserText, const FString& AssistantText)
+{
+    FTurn Turn;
+    Turn.UserText = UserText;
+    Turn.AssistantText = AssistantText;
+    ClipToTokens(Turn.UserText, MaxTurnTokens / 2);
+    ClipToTokens(Turn.AssistantText, MaxTurnTokens / 2);
+    Turn.Tokens = FRestaurantContextPacker::EstimateTokens(Turn.UserText) + FRestaurantContextPacker::EstimateTokens(Turn.AssistantText);
+
+    // Oldest turns make room, whether the ring is full or the token budget is
+    while (Count > 0 && (Count == Ring.Num() || TurnTokens + Turn.Tokens > MaxTurnTokens))
+    {
+        FTurn& Oldest = Ring[First];
+        TurnTokens -= Oldest.Tokens;
+        PendingEvicted.Add(MoveTemp(Oldest));
+        Oldest = FTurn();
+        First = (First + 1) % Ring.Num();
+        Count--;
+    }
+
+    TurnTokens += Turn.Tokens;
+    Ring[(First + Count) % Ring.Num()] = MoveTemp(Turn);
+    Count++;
+    LastTurnTime = FPlatformTime::Seconds();
+
+    if (MaxSummaryTokens > 0)
+    {
+        StartSummary();
+    }
+    else
+    {
+        PendingEvicted.Reset();
+    }
+}
+
+void FConciergeConversationMemory::Reset()
+{
+    for (FTurn& Turn : Ring)
+    {
+        Turn = FTurn();
+    }
+    First = 0;
+    Count = 0;
+    TurnTokens = 0;
+    Summary.Empty();
+    SummaryTokens = 0;
+    PendingEvicted.Reset();
+    bSummarizing = false;
+    Generation++;
+}
+
+double FConciergeConversationMemory::GetSecondsSinceLastTurn() const
+{
+    return Count > 0 || !Summary.IsEmpty() ? FPlatformTime::Seconds() - LastTurnTime : 0.0;
+}
+
+FString FConciergeConversationMemory::Summarize(const FString& PreviousSummary, const TArray<FTurn>& Turns, int32 MaxTokens)
+{
+    TArray<FString> Lines;
+    PreviousSummary.ParseIntoArrayLines(Lines);
+
+    for (const FTurn& Turn : Turns)
+    {
+        Lines.Add(FString::Printf(TEXT("- Guest: %s Concierge: %s"), *GetGist(Turn.UserText, MaxGistWords), *GetGist(Turn.AssistantText, MaxGistWords)));
+    }
+
+    // The oldest lines give way
+    int32 Tokens = 0;
+    int32 FirstKept = Lines.Num();
+    while (FirstKept > 0)
+    {
+        const int32 LineTokens = FRestaurantContextPacker::EstimateTokens(Lines[FirstKept - 1]);
+        if (Tokens + LineTokens > MaxTokens)
+        {
+            break;
+        }
+        Tokens += LineTokens;
+        FirstKept--;
+    }
+    Lines.RemoveAt(0, FirstKept);
+
+    return FString::Join(Lines, TEXT("\n"));
+}
+
+void FConciergeConversationMemory::StartSummary()
+{
+    if (bSummarizing || PendingEvicted.IsEmpty())
+    {
+        return;
+    }
+
+    bSummarizing = true;
+    TWeakPtr<FConciergeConversationMemory, ESPMode::ThreadSafe> WeakThis = AsShared();
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Previous = Summary, Turns = MoveTemp(PendingEvicted), MaxTokens = MaxSummaryTokens, SummaryGeneration = Generation]()
+    {
+        FString NewSummary = Summarize(Previous, Turns, MaxTokens);
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, NewSummary = MoveTemp(NewSummary), SummaryGeneration]() mutable
+        {
+            if (TSharedPtr<FConciergeConversationMemory, ESPMode::ThreadSafe> This = WeakThis.Pin())
+            {
+                This->OnSummarized(MoveTemp(NewSummary), SummaryGeneration);
+            }
+        });
+    });
+    PendingEvicted.Reset();
+}
+
+void FConciergeConversationMemory::OnSummarized(FString&& NewSummary, uint32 SummaryGeneration)
+{
+    if (SummaryGeneration != Generation)
+    {
+        return;
+    }
+
+    Summary = MoveTemp(NewSummary);
+    SummaryTokens = FRestaurantContextPacker::EstimateTokens(Summary);
+    bSummarizing = false;
+
+    // Turns evicted while this one was running
+    StartSummary();
+}
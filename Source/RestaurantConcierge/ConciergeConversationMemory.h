@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Recent turns of one concierge conversation, bounded in both turns and tokens so
+// a kiosk session of any length sends a prompt of the same size. Turns live in a
+// fixed ring; the oldest are evicted when either limit is reached and folded into
+// a short rolling summary on a worker thread, so a follow-up can still refer to
+// something said a while ago. Game thread only, apart from the summarization.
+class RESTAURANTCONCIERGE_API FConciergeConversationMemory : public TSharedFromThis<FConciergeConversationMemory, ESPMode::ThreadSafe>
+{
+public:
+    struct FTurn
+    {
+        FString UserText;
+        FString AssistantText;
+
+        // Estimated prompt tokens of both texts
+        int32 Tokens = 0;
+    };
+
+    FConciergeConversationMemory();
+
+    // Drops everything remembered so far
+    void Configure(int32 InMaxTurns, int32 InMaxTurnTokens, int32 InMaxSummaryTokens);
+
+    // Texts longer than the turn budget are clipped
+    void AddTurn(const FString& UserText, const FString& AssistantText);
+
+    // Forgets the conversation, e.g. when the next guest steps up
+    void Reset();
+
+    // Oldest first
+    int32 Num() const { return Count; }
+    const FTurn& GetTurn(int32 Index) const { return Ring[(First + Index) % Ring.Num()]; }
+
+    const FString& GetSummary() const { return Summary; }
+
+    int32 GetTurnTokens() const { return TurnTokens; }
+    int32 GetSummaryTokens() const { return SummaryTokens; }
+
+    double GetSecondsSinceLastTurn() const;
+
+    // Appends the gist of Turns to PreviousSummary and drops its oldest lines beyond MaxTokens. Safe on worker threads.
+    static FString Summarize(const FString& PreviousSummary, const TArray<FTurn>& Turns, int32 MaxTokens);
+
+private:
+    void StartSummary();
+    void OnSummarized(FString&& NewSummary, uint32 SummaryGeneration);
+
+    TArray<FTurn> Ring;
+    int32 First = 0;
+    int32 Count = 0;
+    int32 TurnTokens = 0;
+    int32 MaxTurnTokens = 400;
+    int32 MaxSummaryTokens = 120;
+    double LastTurnTime = 0.0;
+
+    FString Summary;
+    int32 SummaryTokens = 0;
+
+    // Evicted turns waiting for the summary in flight to finish
+    TArray<FTurn> PendingEvicted;
+    bool bSummarizing = false;
+
+    // Bumped by Reset so a summary of the previous conversation is discarded
+    uint32 Generation = 0;
+};
@@ -0,0 +1,252 @@
+#include "ConciergeResponseCache.h"
+#include "Sound/SoundWave.h"
+#include "Misc/Crc.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+    // Words that do not change what is being asked
+    const TCHAR* const FillerWords[] =
+    {
+        TEXT("a"), TEXT("an"), TEXT("the"), TEXT("is"), TEXT("are"), TEXT("am"), TEXT("was"), TEXT("be"), TEXT("to"), TEXT("of"),
+        TEXT("for"), TEXT("in"), TEXT("on"), TEXT("at"), TEXT("it"), TEXT("me"), TEXT("my"), TEXT("i"), TEXT("im"), TEXT("you"),
+        TEXT("your"), TEXT("we"), TEXT("us"), TEXT("our"), TEXT("what"), TEXT("whats"), TEXT("which"), TEXT("who"), TEXT("how"),
+        TEXT("can"), TEXT("could"), TEXT("would"), TEXT("should"), TEXT("will"), TEXT("do"), TEXT("does"), TEXT("did"), TEXT("any"),
+        TEXT("anything"), TEXT("something"), TEXT("some"), TEXT("there"), TEXT("theres"), TEXT("here"), TEXT("please"), TEXT("tell"),
+        TEXT("show"), TEXT("find"), TEXT("give"), TEXT("get"), TEXT("know"), TEXT("like"), TEXT("want"), TEXT("looking"), TEXT("look"),
+        TEXT("let"), TEXT("lets"), TEXT("need"), TEXT("recommend"), TEXT("suggest"), TEXT("hi"), TEXT("hey"), TEXT("hello"),
+        TEXT("ok"), TEXT("okay"), TEXT("so"), TEXT("just"), TEXT("and"), TEXT("or"), TEXT("with"), TEXT("that"), TEXT("this"),
+        TEXT("one"), TEXT("place"), TEXT("places"), TEXT("spot"), TEXT("spots"), TEXT("restaurant"), TEXT("restaurants"),
+    };
+
+    bool IsFiller(const FString& Word)
+    {
+        static const TSet<FString> Filler = []()
+        {
+            TSet<FString> Words;
+            for (const TCHAR* FillerWord : FillerWords)
+            {
+                Words.Add(FillerWord);
+            }
+            return Words;
+        }();
+        return Filler.Contains(Word);
+    }
+
+    // Longer words only contribute their start
+    constexpr int32 MaxWordChars = 62;
+
+    void AddFeature(const TCHAR* Chars, int32 Len, uint32 Seed, float Weight, float* Embedding, int32 Size)
+    {
+        const uint32 Hash = FCrc::MemCrc32(Chars, Len * sizeof(TCHAR), Seed);
+        Embedding[Hash % Size] += (Hash & 0x80000000u) ? -Weight : Weight;
+    }
+}
+
+void FConciergeResponseCache::Configure(const FSettings& InSettings)
+{
+    Settings = InSettings;
+    Settings.MaxEntries = FMath::Max(Settings.MaxEntries, 1);
+    Entries.Reset();
+}
+
+const FConciergeResponseCache::FResponse* FConciergeResponseCache::Find(const FString& Question, uint32 ContextHash)
+{
+    if (Entries.IsEmpty())
+    {
+        return nullptr;
+    }
+
+    RemoveExpired(FPlatformTime::Seconds());
+
+    const FString Intent = NormalizeIntent(Question);
+    if (Intent.IsEmpty())
+    {
+        return nullptr;
+    }
+
+    FEntry* Match = Entries.FindByPredicate([&Intent, ContextHash](const FEntry& Entry)
+    {
+        return Entry.ContextHash == ContextHash && Entry.Intent.Equals(Intent, ESearchCase::CaseSensitive);
+    });
+
+    if (!Match && Settings.MinSimilarity > 0.0f)
+    {
+        float Embedding[EmbeddingSize];
+        Embed(Intent, Embedding);
+
+        float BestSimilarity = Settings.MinSimilarity;
+        for (FEntry& Entry : Entries)
+        {
+            if (Entry.ContextHash != ContextHash)
+            {
+                continue;
+            }
+
+            float Similarity = 0.0f;
+            for (int32 i = 0; i < EmbeddingSize; i++)
+            {
+                Similarity += Embedding[i] * Entry.Embedding[i];
+            }
+            if (Similarity >= BestSimilarity)
+            {
+                BestSimilarity = Similarity;
+                Match = &Entry;
+            }
+        }
+
+        if (Match)
+        {
+            UE_LOG(LogTemp, Verbose, TEXT("Response cache: \"%s\" matched \"%s\" at %.2f"), *Intent, *Match->Intent, BestSimilarity);
+        }
+    }
+
+    if (!Match)
+    {
+        return nullptr;
+    }
+
+    Match->LastUse = ++UseCounter;
+    return &Match->Response;
+}
+
+void FConciergeResponseCache::Add(const FString& Question, uint32 ContextHash, const FString& Text, USoundWave* Audio)
+{
+    FString Intent = NormalizeIntent(Question);
+    if (Intent.IsEmpty() || Text.IsEmpty())
+    {
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    RemoveExpired(Now);
+
+    FEntry* Entry = Entries.FindByPredicate([&Intent, ContextHash](const FEntry& Existing)
+    {
+        return Existing.ContextHash == ContextHash && Existing.Intent.Equals(Intent, ESearchCase::CaseSensitive);
+    });
+
+    if (!Entry)
+    {
+        if (Entries.Num() >= Settings.MaxEntries)
+        {
+            int32 Oldest = 0;
+            for (int32 i = 1; i < Entries.Num(); i++)
+            {
+                if (Entries[i].LastUse < Entries[Oldest].LastUse)
+                {
+                    Oldest = i;
+                }
+            }
+            Entries.RemoveAtSwap(Oldest, 1, /*bAllowShrinking*/ false);
+        }
+
+        Entry = &Entries.AddDefaulted_GetRef();
+        Entry->Intent = MoveTemp(Intent);
+        Entry->ContextHash = ContextHash;
+        Embed(Entry->Intent, Entry->Embedding);
+    }
+
+    Entry->Response.Text = Text;
+    Entry->Response.Audio = Audio;
+    Entry->CreatedAt = Now;
+    Entry->LastUse = ++UseCounter;
+}
+
+void FConciergeResponseCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    for (FEntry& Entry : Entries)
+    {
+        Collector.AddReferencedObject(Entry.Response.Audio);
+    }
+}
+
+FString FConciergeResponseCache::NormalizeIntent(const FString& Question)
+{
+    TArray<FString> Words;
+    FString Word;
+
+    auto FlushWord = [&Words, &Word]()
+    {
+        if (!Word.IsEmpty() && !IsFiller(Word))
+        {
+            // "hours" and "hour", "reviews" and "review"
+            if (Word.Len() > 3 && Word.EndsWith(TEXT("s"), ESearchCase::CaseSensitive) && !Word.EndsWith(TEXT("ss"), ESearchCase::CaseSensitive))
+            {
+                Word.LeftChopInline(1, /*bAllowShrinking*/ false);
+            }
+            Words.AddUnique(Word);
+        }
+        Word.Reset();
+    };
+
+    for (TCHAR Char : Question)
+    {
+        if (FChar::IsAlnum(Char))
+        {
+            Word.AppendChar(FChar::ToLower(Char));
+        }
+        else if (Char != TEXT('\''))
+        {
+            // An apostrophe joins "what's" into "whats"
+            FlushWord();
+        }
+    }
+    FlushWord();
+
+    Words.Sort();
+    return FString::Join(Words, TEXT(" "));
+}
+
+void FConciergeResponseCache::Embed(const FString& Intent, float (&OutEmbedding)[EmbeddingSize])
+{
+    FMemory::Memzero(OutEmbedding);
+
+    // Whole words carry most of the weight, trigrams catch variants of the same word
+    TCHAR Padded[MaxWordChars + 2];
+    int32 Start = 0;
+    while (Start < Intent.Len())
+    {
+        int32 End = Start;
+        while (End < Intent.Len() && Intent[End] != TEXT(' '))
+        {
+            End++;
+        }
+
+        const int32 Len = FMath::Min(End - Start, MaxWordChars);
+        AddFeature(*Intent + Start, Len, 0, 1.0f, OutEmbedding, EmbeddingSize);
+
+        Padded[0] = TEXT('<');
+        FMemory::Memcpy(Padded + 1, *Intent + Start, Len * sizeof(TCHAR));
+        Padded[Len + 1] = TEXT('>');
+        for (int32 i = 0; i + 3 <= Len + 2; i++)
+        {
+            AddFeature(Padded + i, 3, 1, 0.5f, OutEmbedding, EmbeddingSize);
+        }
+
+        Start = End + 1;
+    }
+
+    float SquaredLength = 0.0f;
+    for (float Value : OutEmbedding)
+    {
+        SquaredLength += Value * Value;
+    }
+    if (SquaredLength > 0.0f)
+    {
+        const float Scale = FMath::InvSqrt(SquaredLength);
+        for (float& Value : OutEmbedding)
+        {
+            Value *= Scale;
+        }
+    }
+}
+
+void FConciergeResponseCache::RemoveExpired(double Now)
+{
+    const double OldestAllowed = Now - Settings.TimeToLiveSeconds;
+    Entries.RemoveAllSwap([OldestAllowed](const FEntry& Entry)
+    {
+        return Entry.CreatedAt < OldestAllowed;
+    }, /*bAllowShrinking*/ false);
+}
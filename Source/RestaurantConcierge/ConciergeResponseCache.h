@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+
+class USoundWave;
+
+// Answers to questions already asked against the same context. A question is
+// reduced to its intent (lowercased content words, sorted, so "What's good
+// nearby?" and "anything good nearby" match) and looked up together with a hash
+// of everything else the answer depends on. Optionally, a question whose intent
+// differs is still served when its hashed n-gram embedding is close enough to a
+// cached one. Entries expire after a TTL and all go when the results change.
+class RESTAURANTCONCIERGE_API FConciergeResponseCache : public FGCObject
+{
+public:
+    struct FSettings
+    {
+        int32 MaxEntries = 128;
+        float TimeToLiveSeconds = 600.0f;
+
+        // Cosine similarity an embedding needs to count as the same question, 0 disables approximate matching
+        float MinSimilarity = 0.85f;
+    };
+
+    struct FResponse
+    {
+        FString Text;
+        TObjectPtr<USoundWave> Audio;
+    };
+
+    void Configure(const FSettings& InSettings);
+
+    // Null on a miss. The pointer is valid until the next call into the cache.
+    const FResponse* Find(const FString& Question, uint32 ContextHash);
+
+    void Add(const FString& Question, uint32 ContextHash, const FString& Text, USoundWave* Audio);
+
+    // Everything cached so far was answered from a context that no longer applies
+    void Invalidate() { Entries.Reset(); }
+
+    int32 Num() const { return Entries.Num(); }
+
+    // FGCObject
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+    virtual FString GetReferencerName() const override { return TEXT("FConciergeResponseCache"); }
+
+    // Lowercased words minus filler, crudely singularized, sorted and deduplicated
+    static FString NormalizeIntent(const FString& Question);
+
+private:
+    static constexpr int32 EmbeddingSize = 128;
+
+    struct FEntry
+    {
+        FString Intent;
+        uint32 ContextHash = 0;
+        float Embedding[EmbeddingSize] = {};
+        FResponse Response;
+        double CreatedAt = 0.0;
+        uint64 LastUse = 0;
+    };
+
+    // Signed feature hashing of the intent's words and character trigrams, L2 normalized
+    static void Embed(const FString& Intent, float (&OutEmbedding)[EmbeddingSize]);
+
+    void RemoveExpired(double Now);
+
+    FSettings Settings;
+
+    // Few enough that a scan beats maintaining an index
+    TArray<FEntry> Entries;
+    uint64 UseCounter = 0;
+};
@@ -0,0 +1,357 @@
+#include "RestaurantCacheStore.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Misc/Crc.h"
+
+namespace
+{
+    // Magic, Version, NumClasses, NumEntries, IndexCrc, HeaderCrc, IndexBytes
+    constexpr int64 HeaderBytes = 6 * sizeof(uint32) + sizeof(uint64);
+    constexpr int64 HeaderCrcOffset = 5 * sizeof(uint32);
+
+    // One index entry, see SerializeEntry. Archives write bools as four bytes.
+    constexpr int64 EntryBytes = sizeof(uint32) * 2 + sizeof(uint64) + sizeof(int64) + sizeof(double) * 2 + sizeof(float) + sizeof(uint32) + sizeof(uint64) * 2;
+
+    // Smallest serialized query class, an empty string's length
+    constexpr int64 MinClassBytes = sizeof(int32);
+
+    // Upper bound used to reject corrupt counts before allocating
+    constexpr int32 MaxRestaurantsPerTile = 100000;
+
+    // Every header field but the checksum itself
+    uint32 ComputeHeaderCrc(const uint8* Header)
+    {
+        const uint32 Crc = FCrc::MemCrc32(Header, HeaderCrcOffset);
+        return FCrc::MemCrc32(Header + HeaderCrcOffset + sizeof(uint32), HeaderBytes - HeaderCrcOffset - sizeof(uint32), Crc);
+    }
+
+    void SerializeRestaurant(FArchive& Ar, FRestaurantData& Restaurant)
+    {
+        Ar << Restaurant.Name;
+        Ar << Restaurant.Address;
+        Ar << Restaurant.Location;
+        Ar << Restaurant.CuisineTypes;
+        Ar << Restaurant.PriceLevel;
+        Ar << Restaurant.Rating;
+        Ar << Restaurant.ReviewCount;
+        Ar << Restaurant.Hours.WeeklyHours;
+        Ar << Restaurant.Hours.bOpen24Hours;
+        Ar << Restaurant.Hours.bTemporarilyClosed;
+        Ar << Restaurant.Hours.UtcOffsetMinutes;
+        Ar << Restaurant.Hours.bHasUtcOffset;
+        Ar << Restaurant.Hours.OpenSlots.OpenNowObservedAt;
+        Ar << Restaurant.Hours.OpenSlots.bOpenNow;
+        Ar << Restaurant.PhotoURLs;
+        Ar << Restaurant.PhoneNumber;
+        Ar << Restaurant.Website;
+        Ar << Restaurant.bAcceptsReservations;
+        Ar << Restaurant.bTakeout;
+        Ar << Restaurant.bDelivery;
+        Ar << Restaurant.GooglePlaceId;
+        Ar << Restaurant.YelpBusinessId;
+    }
+
+    void WritePayload(const TArray<FRestaurantData>& Restaurants, TArray<uint8>& OutPayload)
+    {
+        FMemoryWriter Writer(OutPayload);
+        int32 Num = Restaurants.Num();
+        Writer << Num;
+        for (const FRestaurantData& Restaurant : Restaurants)
+        {
+            // Saving archives only read from the struct
+            SerializeRestaurant(Writer, const_cast<FRestaurantData&>(Restaurant));
+        }
+    }
+}
+
+FRestaurantCacheStore::FRestaurantCacheStore(const FString& InFilePath)
+    : FilePath(InFilePath)
+{
+}
+
+FRestaurantCacheStore::~FRestaurantCacheStore()
+{
+    Close();
+}
+
+bool FRestaurantCacheStore::Open()
+{
+    Close();
+
+    if (!IFileManager::Get().FileExists(*FilePath))
+    {
+        return false;
+    }
+
+    MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+    if (MappedFile.IsValid())
+    {
+        MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    }
+
+    if (!MappedRegion.IsValid() || !ReadIndex(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize()))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Discarding unreadable restaurant cache file %s"), *FilePath);
+        Invalidate();
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Restaurant cache file mapped: %d tiles"), Entries.Num());
+    return true;
+}
+
+void FRestaurantCacheStore::Close()
+{
+    // The region must be released before its file handle
+    MappedRegion.Reset();
+    MappedFile.Reset();
+
+    QueryClasses.Empty();
+    Entries.Empty();
+    EntryLookup.Empty();
+}
+
+bool FRestaurantCacheStore::ReadIndex(const uint8* Data, int64 Size)
+{
+    if (Size < HeaderBytes)
+    {
+        return false;
+    }
+
+    FMemoryReaderView HeaderReader(TArrayView<const uint8>(Data, HeaderBytes));
+    uint32 FileMagic = 0, FileVersion = 0, NumClasses = 0, NumEntries = 0, IndexCrc = 0, HeaderCrc = 0;
+    uint64 IndexBytes = 0;
+    HeaderReader << FileMagic << FileVersion << NumClasses << NumEntries << IndexCrc << HeaderCrc << IndexBytes;
+
+    if (FileMagic != Magic || FileVersion != Version || HeaderCrc != ComputeHeaderCrc(Data) ||
+        IndexBytes > static_cast<uint64>(Size - HeaderBytes) || IndexBytes > MAX_int32)
+    {
+        return false;
+    }
+
+    // The counts have to fit in the index before anything is allocated for them
+    if (NumClasses * static_cast<uint64>(MinClassBytes) + NumEntries * static_cast<uint64>(EntryBytes) > IndexBytes)
+    {
+        return false;
+    }
+
+    const TArrayView<const uint8> IndexView(Data + HeaderBytes, static_cast<int32>(IndexBytes));
+    if (FCrc::MemCrc32(IndexView.GetData(), IndexView.Num()) != IndexCrc)
+    {
+        return false;
+    }
+
+    FMemoryReaderView Reader(IndexView);
+
+    QueryClasses.SetNum(NumClasses);
+    for (FString& QueryClass : QueryClasses)
+    {
+        Reader << QueryClass;
+    }
+
+    // Payloads follow the index. Offsets are checked without adding them to sizes, which could wrap.
+    const int64 PayloadStart = HeaderBytes + static_cast<int64>(IndexBytes);
+    Entries.SetNum(NumEntries);
+    for (int32 i = 0; i < Entries.Num(); i++)
+    {
+        FEntry& Entry = Entries[i];
+        SerializeEntry(Reader, Entry);
+
+        if (Reader.IsError() || Entry.ClassIndex >= NumClasses || Entry.Offset > static_cast<uint64>(Size) || Entry.Size > MAX_int32)
+        {
+            return false;
+        }
+
+        const int64 Offset = static_cast<int64>(Entry.Offset);
+        if (Offset < PayloadStart || static_cast<int64>(Entry.Size) > Size - Offset)
+        {
+            return false;
+        }
+
+        EntryLookup.FindOrAdd(QueryClasses[Entry.ClassIndex]).Add(Entry.Key, i);
+    }
+
+    return !Reader.IsError();
+}
+
+void FRestaurantCacheStore::SerializeEntry(FArchive& Ar, FEntry& Entry)
+{
+    Ar << Entry.ClassIndex << Entry.PayloadCrc << Entry.Key << Entry.CachedAtTicks;
+    Ar << Entry.Coverage.Center.X << Entry.Coverage.Center.Y << Entry.Coverage.RadiusMeters << Entry.Coverage.bFullTile;
+    Ar << Entry.Offset << Entry.Size;
+}
+
+TArrayView<const uint8> FRestaurantCacheStore::GetPayload(const FEntry& Entry) const
+{
+    return TArrayView<const uint8>(MappedRegion->GetMappedPtr() + Entry.Offset, static_cast<int32>(Entry.Size));
+}
+
+bool FRestaurantCacheStore::LoadTile(const FString& QueryClass, uint64 Key, FDateTime& OutCachedAt, FRestaurantTileCoverage& OutCoverage, TArray<FRestaurantData>& OutRestaurants) const
+{
+    const TMap<uint64, int32>* ClassEntries = EntryLookup.Find(QueryClass);
+    const int32* EntryIndex = ClassEntries ? ClassEntries->Find(Key) : nullptr;
+    if (!EntryIndex || !MappedRegion.IsValid())
+    {
+        return false;
+    }
+
+    const FEntry& Entry = Entries[*EntryIndex];
+    const TArrayView<const uint8> Payload = GetPayload(Entry);
+    if (FCrc::MemCrc32(Payload.GetData(), Payload.Num()) != Entry.PayloadCrc)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Restaurant cache tile failed its checksum, ignoring it"));
+        return false;
+    }
+
+    FMemoryReaderView Reader(Payload);
+    int32 Num = 0;
+    Reader << Num;
+    if (Num < 0 || Num > FMath::Min(MaxRestaurantsPerTile, Payload.Num()))
+    {
+        return false;
+    }
+
+    OutRestaurants.SetNum(Num);
+    for (FRestaurantData& Restaurant : OutRestaurants)
+    {
+        SerializeRestaurant(Reader, Restaurant);
+        Restaurant.Hours.RebuildOpenSlots();
+    }
+
+    if (Reader.IsError())
+    {
+        OutRestaurants.Reset();
+        return false;
+    }
+
+    OutCachedAt = FDateTime(Entry.CachedAtTicks);
+    OutCoverage = Entry.Coverage;
+    return true;
+}
+
+bool FRestaurantCacheStore::WriteFile(const TArray<FRestaurantPersistedTile>& Tiles, const FDateTime& OldestAllowed) const
+{
+    TArray<FString> NewClasses;
+    TArray<FEntry> NewEntries;
+    TArray<TArray<uint8>> Payloads;
+    TSet<TPair<FString, uint64>> Written;
+
+    auto AddEntry = [&](const FString& QueryClass, uint64 Key, int64 CachedAtTicks, const FRestaurantTileCoverage& Coverage, TArray<uint8>&& Payload)
+    {
+        FEntry& Entry = NewEntries.AddDefaulted_GetRef();
+        Entry.ClassIndex = NewClasses.AddUnique(QueryClass);
+        Entry.Key = Key;
+        Entry.CachedAtTicks = CachedAtTicks;
+        Entry.Coverage = Coverage;
+        Entry.Size = Payload.Num();
+        Entry.PayloadCrc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+        Payloads.Add(MoveTemp(Payload));
+        Written.Add(TPair<FString, uint64>(QueryClass, Key));
+    };
+
+    for (const FRestaurantPersistedTile& Tile : Tiles)
+    {
+        if (Tile.CachedAt >= OldestAllowed)
+        {
+            TArray<uint8> Payload;
+            WritePayload(Tile.Restaurants, Payload);
+            AddEntry(Tile.QueryClass, Tile.Key, Tile.CachedAt.GetTicks(), Tile.Coverage, MoveTemp(Payload));
+        }
+    }
+
+    // Tiles that were never faulted in are carried over byte for byte
+    if (MappedRegion.IsValid())
+    {
+        for (const FEntry& Entry : Entries)
+        {
+            const FString& QueryClass = QueryClasses[Entry.ClassIndex];
+            if (Entry.CachedAtTicks >= OldestAllowed.GetTicks() && !Written.Contains(TPair<FString, uint64>(QueryClass, Entry.Key)))
+            {
+                const TArrayView<const uint8> Payload = GetPayload(Entry);
+                AddEntry(QueryClass, Entry.Key, Entry.CachedAtTicks, Entry.Coverage, TArray<uint8>(Payload.GetData(), Payload.Num()));
+            }
+        }
+    }
+
+    // Payload offsets depend on the index size, so write the class table first to measure it
+    TArray<uint8> IndexBytes;
+    FMemoryWriter IndexWriter(IndexBytes);
+    for (FString& QueryClass : NewClasses)
+    {
+        IndexWriter << QueryClass;
+    }
+    uint64 Offset = HeaderBytes + IndexBytes.Num() + EntryBytes * NewEntries.Num();
+    for (FEntry& Entry : NewEntries)
+    {
+        Entry.Offset = Offset;
+        Offset += Entry.Size;
+        SerializeEntry(IndexWriter, Entry);
+    }
+
+    TArray<uint8> Header;
+    FMemoryWriter HeaderWriter(Header);
+    uint32 FileMagic = Magic, FileVersion = Version, HeaderCrc = 0;
+    uint32 NumClasses = NewClasses.Num(), NumEntries = NewEntries.Num();
+    uint32 IndexCrc = FCrc::MemCrc32(IndexBytes.GetData(), IndexBytes.Num());
+    uint64 IndexSize = IndexBytes.Num();
+    HeaderWriter << FileMagic << FileVersion << NumClasses << NumEntries << IndexCrc << HeaderCrc << IndexSize;
+    HeaderCrc = ComputeHeaderCrc(Header.GetData());
+    FMemory::Memcpy(Header.GetData() + HeaderCrcOffset, &HeaderCrc, sizeof(HeaderCrc));
+
+    const FString TempPath = GetTempPath();
+    TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempPath));
+    if (!Writer.IsValid())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Could not write restaurant cache file %s"), *TempPath);
+        return false;
+    }
+
+    Writer->Serialize(Header.GetData(), Header.Num());
+    Writer->Serialize(IndexBytes.GetData(), IndexBytes.Num());
+    for (TArray<uint8>& Payload : Payloads)
+    {
+        Writer->Serialize(Payload.GetData(), Payload.Num());
+    }
+
+    const bool bWriteOk = Writer->Close() && !Writer->IsError();
+    Writer.Reset();
+
+    if (!bWriteOk)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Could not write restaurant cache file %s"), *TempPath);
+        DiscardFile();
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Restaurant cache written: %d tiles"), NumEntries);
+    return true;
+}
+
+bool FRestaurantCacheStore::CommitFile()
+{
+    // The mapping has to go before the file underneath it can be replaced
+    Close();
+    if (!IFileManager::Get().Move(*FilePath, *GetTempPath(), true))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Failed to replace restaurant cache file %s"), *FilePath);
+        DiscardFile();
+        Open();
+        return false;
+    }
+
+    return Open();
+}
+
+void FRestaurantCacheStore::DiscardFile() const
+{
+    IFileManager::Get().Delete(*GetTempPath(), false, true, true);
+}
+
+void FRestaurantCacheStore::Invalidate()
+{
+    Close();
+    IFileManager::Get().Delete(*FilePath, false, true, true);
+}
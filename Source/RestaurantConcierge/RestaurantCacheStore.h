@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// Where a cached tile's restaurants are complete: the whole tile, or only the part
+// of it inside the circle of the search that filled it
+struct FRestaurantTileCoverage
+{
+    FVector2D Center = FVector2D::ZeroVector;
+    float RadiusMeters = 0.0f;
+    bool bFullTile = false;
+};
+
+// One cached tile as handed to FRestaurantCacheStore::Save
+struct FRestaurantPersistedTile
+{
+    FString QueryClass;
+    uint64 Key = 0;
+    FDateTime CachedAt; // UTC
+    FRestaurantTileCoverage Coverage;
+    TArray<FRestaurantData> Restaurants;
+};
+
+// Persistent, memory-mapped backing file for FRestaurantTileCache.
+//
+// Layout: header, query class table, tile index, then one serialized payload per
+// tile. Opening only maps the file and reads the index, so a warm start is
+// queryable immediately; payloads are decoded when a tile is first requested.
+// The header, the index and every payload carry a CRC, and files written by a
+// different format version are discarded. Timestamps are UTC.
+class RESTAURANTCONCIERGE_API FRestaurantCacheStore
+{
+public:
+    static constexpr uint32 Magic = 0x43545352; // "RSTC"
+    static constexpr uint32 Version = 5;
+
+    explicit FRestaurantCacheStore(const FString& InFilePath);
+    ~FRestaurantCacheStore();
+
+    // Maps the file and validates its header and index. A missing file is not an error.
+    bool Open();
+    void Close();
+
+    // Decodes a tile from the mapped file
+    bool LoadTile(const FString& QueryClass, uint64 Key, FDateTime& OutCachedAt, FRestaurantTileCoverage& OutCoverage, TArray<FRestaurantData>& OutRestaurants) const;
+
+    // Writes a new file next to the mapped one from the given tiles plus every mapped
+    // tile they don't replace, skipping tiles cached before OldestAllowed. May run on a
+    // worker thread while the game thread calls LoadTile; nothing else may be called
+    // until CommitFile or DiscardFile.
+    bool WriteFile(const TArray<FRestaurantPersistedTile>& Tiles, const FDateTime& OldestAllowed) const;
+
+    // Replaces the mapped file with the one WriteFile wrote and maps it
+    bool CommitFile();
+    void DiscardFile() const;
+
+    // Closes and deletes the file
+    void Invalidate();
+
+    int32 GetNumEntries() const { return Entries.Num(); }
+
+private:
+    struct FEntry
+    {
+        uint32 ClassIndex = 0;
+        uint32 PayloadCrc = 0;
+        uint64 Key = 0;
+        int64 CachedAtTicks = 0;
+        FRestaurantTileCoverage Coverage;
+        uint64 Offset = 0;
+        uint64 Size = 0;
+    };
+
+    static void SerializeEntry(FArchive& Ar, FEntry& Entry);
+
+    bool ReadIndex(const uint8* Data, int64 Size);
+    TArrayView<const uint8> GetPayload(const FEntry& Entry) const;
+    FString GetTempPath() const { return FilePath + TEXT(".tmp"); }
+
+    FString FilePath;
+
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+
+    TArray<FString> QueryClasses;
+    TArray<FEntry> Entries;
+
+    // Query class -> tile key -> index into Entries
+    TMap<FString, TMap<uint64, int32>> EntryLookup;
+};
@@ -0,0 +1,227 @@
+#include "RestaurantColumnStore.h"
+
+namespace
+{
+    const TCHAR* const DayNames[] =
+    {
+        TEXT("Monday"), TEXT("Tuesday"), TEXT("Wednesday"), TEXT("Thursday"), TEXT("Friday"), TEXT("Saturday"), TEXT("Sunday")
+    };
+}
+
+FRestaurantStringId FRestaurantStringPool::Intern(const FString& String)
+{
+    if (const FRestaurantStringId* Existing = Ids.Find(String))
+    {
+        return *Existing;
+    }
+
+    const FRestaurantStringId Id = Strings.Add(String);
+    Ids.Add(String, Id);
+
+    // Held once in the array and once as a map key
+    StringBytes += 2 * Strings[Id].GetAllocatedSize();
+    return Id;
+}
+
+SIZE_T FRestaurantStringPool::GetAllocatedSize() const
+{
+    return Strings.GetAllocatedSize() + Ids.GetAllocatedSize() + StringBytes;
+}
+
+void FRestaurantColumns::Reserve(int32 NumRows)
+{
+    Latitudes.Reserve(NumRows);
+    Longitudes.Reserve(NumRows);
+    Ratings.Reserve(NumRows);
+    ReviewCounts.Reserve(NumRows);
+    PriceLevels.Reserve(NumRows);
+    Flags.Reserve(NumRows);
+    Hours.Reserve(NumRows * DaysPerWeek);
+    OpenSlots.Reserve(NumRows);
+    UtcOffsetMinutes.Reserve(NumRows);
+    CuisineStarts.Reserve(NumRows + 1);
+    PhotoStarts.Reserve(NumRows + 1);
+    TextFields.Reserve(NumRows * NumTextFields);
+}
+
+FRestaurantColumns::FTextSpan FRestaurantColumns::AppendText(const FString& Text)
+{
+    FTextSpan Span;
+    Span.Offset = TextArena.Num();
+    Span.Len = Text.Len();
+    TextArena.Append(*Text, Text.Len());
+    return Span;
+}
+
+FString FRestaurantColumns::GetText(const FTextSpan& Span) const
+{
+    return FString(Span.Len, TextArena.GetData() + Span.Offset);
+}
+
+void FRestaurantColumns::Add(const FRestaurantData& Restaurant, FRestaurantStringPool& Pool)
+{
+    if (CuisineStarts.IsEmpty())
+    {
+        CuisineStarts.Add(0);
+        PhotoStarts.Add(0);
+    }
+
+    Latitudes.Add(Restaurant.Location.X);
+    Longitudes.Add(Restaurant.Location.Y);
+    Ratings.Add(Restaurant.Rating);
+    ReviewCounts.Add(Restaurant.ReviewCount);
+    PriceLevels.Add(Pool.Intern(Restaurant.PriceLevel));
+
+    uint8 RowFlags = 0;
+    RowFlags |= Restaurant.bAcceptsReservations ? AcceptsReservations : 0;
+    RowFlags |= Restaurant.bTakeout ? Takeout : 0;
+    RowFlags |= Restaurant.bDelivery ? Delivery : 0;
+    RowFlags |= Restaurant.Hours.bOpen24Hours ? Open24Hours : 0;
+    RowFlags |= Restaurant.Hours.bTemporarilyClosed ? TemporarilyClosed : 0;
+    RowFlags |= Restaurant.Hours.bHasUtcOffset ? HasUtcOffset : 0;
+    Flags.Add(RowFlags);
+
+    OpenSlots.Add(Restaurant.Hours.OpenSlots);
+    UtcOffsetMinutes.Add(static_cast<int16>(Restaurant.Hours.UtcOffsetMinutes));
+
+    for (const TCHAR* Day : DayNames)
+    {
+        const FString* DayHours = Restaurant.Hours.WeeklyHours.Find(Day);
+        Hours.Add(Pool.Intern(DayHours ? *DayHours : FString()));
+    }
+
+    for (const FString& Cuisine : Restaurant.CuisineTypes)
+    {
+        Cuisines.Add(Pool.Intern(Cuisine));
+    }
+    CuisineStarts.Add(Cuisines.Num());
+
+    for (const FString& PhotoURL : Restaurant.PhotoURLs)
+    {
+        Photos.Add(AppendText(PhotoURL));
+    }
+    PhotoStarts.Add(Photos.Num());
+
+    // Same order as ETextField
+    TextFields.Add(AppendText(Restaurant.Name));
+    TextFields.Add(AppendText(Restaurant.Address));
+    TextFields.Add(AppendText(Restaurant.PhoneNumber));
+    TextFields.Add(AppendText(Restaurant.Website));
+    TextFields.Add(AppendText(Restaurant.GooglePlaceId));
+    TextFields.Add(AppendText(Restaurant.YelpBusinessId));
+}
+
+void FRestaurantColumns::Shrink()
+{
+    Latitudes.Shrink();
+    Longitudes.Shrink();
+    Ratings.Shrink();
+    ReviewCounts.Shrink();
+    PriceLevels.Shrink();
+    Flags.Shrink();
+    Hours.Shrink();
+    OpenSlots.Shrink();
+    UtcOffsetMinutes.Shrink();
+    Cuisines.Shrink();
+    CuisineStarts.Shrink();
+    Photos.Shrink();
+    PhotoStarts.Shrink();
+    TextFields.Shrink();
+    TextArena.Shrink();
+}
+
+void FRestaurantColumns::ReinternStrings(const FRestaurantStringPool& Pool, FRestaurantStringPool& NewPool)
+{
+    for (FRestaurantStringId& Id : PriceLevels)
+    {
+        Id = NewPool.Intern(Pool.Get(Id));
+    }
+    for (FRestaurantStringId& Id : Hours)
+    {
+        Id = NewPool.Intern(Pool.Get(Id));
+    }
+    for (FRestaurantStringId& Id : Cuisines)
+    {
+        Id = NewPool.Intern(Pool.Get(Id));
+    }
+}
+
+bool FRestaurantColumns::IsOpenAt(int32 Row, const FDateTime& UtcTime, int32 FallbackUtcOffsetMinutes) const
+{
+    const FRestaurantOpenHours& RowSlots = OpenSlots[Row];
+    if (!RowSlots.bKnown)
+    {
+        return RowSlots.IsOpenNearObservation(UtcTime);
+    }
+
+    int32 Day = 0, MinuteOfDay = 0;
+    const int32 Offset = (Flags[Row] & HasUtcOffset) ? UtcOffsetMinutes[Row] : FallbackUtcOffsetMinutes;
+    FRestaurantOpenHours::ToLocal(UtcTime, Offset, Day, MinuteOfDay);
+    return RowSlots.IsOpenAtLocal(Day, MinuteOfDay);
+}
+
+void FRestaurantColumns::Materialize(int32 Row, const FRestaurantStringPool& Pool, FRestaurantData& OutRestaurant) const
+{
+    const FTextSpan* Text = &TextFields[Row * NumTextFields];
+    OutRestaurant.Name = GetText(Text[Name]);
+    OutRestaurant.Address = GetText(Text[Address]);
+    OutRestaurant.PhoneNumber = GetText(Text[PhoneNumber]);
+    OutRestaurant.Website = GetText(Text[Website]);
+    OutRestaurant.GooglePlaceId = GetText(Text[GooglePlaceId]);
+    OutRestaurant.YelpBusinessId = GetText(Text[YelpBusinessId]);
+
+    OutRestaurant.Location = GetLocation(Row);
+    OutRestaurant.Rating = Ratings[Row];
+    OutRestaurant.ReviewCount = ReviewCounts[Row];
+    OutRestaurant.PriceLevel = Pool.Get(PriceLevels[Row]);
+
+    const uint8 RowFlags = Flags[Row];
+    OutRestaurant.bAcceptsReservations = (RowFlags & AcceptsReservations) != 0;
+    OutRestaurant.bTakeout = (RowFlags & Takeout) != 0;
+    OutRestaurant.bDelivery = (RowFlags & Delivery) != 0;
+    OutRestaurant.Hours.bOpen24Hours = (RowFlags & Open24Hours) != 0;
+    OutRestaurant.Hours.bTemporarilyClosed = (RowFlags & TemporarilyClosed) != 0;
+    OutRestaurant.Hours.bHasUtcOffset = (RowFlags & HasUtcOffset) != 0;
+    OutRestaurant.Hours.UtcOffsetMinutes = UtcOffsetMinutes[Row];
+    OutRestaurant.Hours.OpenSlots = OpenSlots[Row];
+
+    for (int32 Day = 0; Day < DaysPerWeek; Day++)
+    {
+        // Empty marks a day the row never had
+        const FString& DayHours = Pool.Get(Hours[Row * DaysPerWeek + Day]);
+        if (!DayHours.IsEmpty())
+        {
+            OutRestaurant.Hours.WeeklyHours.Add(DayNames[Day], DayHours);
+        }
+    }
+
+    OutRestaurant.CuisineTypes.Reset(CuisineStarts[Row + 1] - CuisineStarts[Row]);
+    for (int32 i = CuisineStarts[Row]; i < CuisineStarts[Row + 1]; i++)
+    {
+        OutRestaurant.CuisineTypes.Add(Pool.Get(Cuisines[i]));
+    }
+
+    OutRestaurant.PhotoURLs.Reset(PhotoStarts[Row + 1] - PhotoStarts[Row]);
+    for (int32 i = PhotoStarts[Row]; i < PhotoStarts[Row + 1]; i++)
+    {
+        OutRestaurant.PhotoURLs.Add(GetText(Photos[i]));
+    }
+}
+
+void FRestaurantColumns::MaterializeAll(const FRestaurantStringPool& Pool, TArray<FRestaurantData>& OutRestaurants) const
+{
+    OutRestaurants.Reserve(OutRestaurants.Num() + Num());
+    for (int32 Row = 0; Row < Num(); Row++)
+    {
+        Materialize(Row, Pool, OutRestaurants.AddDefaulted_GetRef());
+    }
+}
+
+SIZE_T FRestaurantColumns::GetAllocatedSize() const
+{
+    return Latitudes.GetAllocatedSize() + Longitudes.GetAllocatedSize() + Ratings.GetAllocatedSize() +
+        ReviewCounts.GetAllocatedSize() + PriceLevels.GetAllocatedSize() + Flags.GetAllocatedSize() +
+        Hours.GetAllocatedSize() + OpenSlots.GetAllocatedSize() + UtcOffsetMinutes.GetAllocatedSize() + Cuisines.GetAllocatedSize() + CuisineStarts.GetAllocatedSize() +
+        Photos.GetAllocatedSize() + PhotoStarts.GetAllocatedSize() + TextFields.GetAllocatedSize() +
+        TextArena.GetAllocatedSize();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+// Interned id of a pooled string
+using FRestaurantStringId = uint32;
+
+// Interns the short, highly repetitive strings of restaurant rows (cuisines,
+// price levels, opening hours text) so every row stores a 4 byte id instead of
+// an FString. Ids stay valid for the lifetime of the pool; strings nobody refers
+// to anymore are only dropped by moving the users to a new pool (ReinternStrings).
+class RESTAURANTCONCIERGE_API FRestaurantStringPool
+{
+public:
+    FRestaurantStringId Intern(const FString& String);
+    const FString& Get(FRestaurantStringId Id) const { return Strings[Id]; }
+
+    int32 Num() const { return Strings.Num(); }
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    TArray<FString> Strings;
+    TMap<FString, FRestaurantStringId> Ids;
+
+    // Heap bytes of the interned strings, kept up to date by Intern
+    SIZE_T StringBytes = 0;
+};
+
+// Struct-of-arrays storage for a batch of restaurants. Numeric fields live in
+// their own columns, pooled strings as ids, flags in a bitfield and free text
+// (names, addresses, ids, URLs) in one character arena, so a block of N rows
+// costs a fixed number of allocations instead of dozens per row.
+// FRestaurantData is only materialized when a row leaves the store.
+class RESTAURANTCONCIERGE_API FRestaurantColumns
+{
+public:
+    int32 Num() const { return Latitudes.Num(); }
+
+    void Reserve(int32 NumRows);
+    void Add(const FRestaurantData& Restaurant, FRestaurantStringPool& Pool);
+
+    // Releases the slack left by Add, call once the block is complete
+    void Shrink();
+
+    // Moves every pooled string id from Pool to NewPool
+    void ReinternStrings(const FRestaurantStringPool& Pool, FRestaurantStringPool& NewPool);
+
+    FVector2D GetLocation(int32 Row) const { return FVector2D(Latitudes[Row], Longitudes[Row]); }
+    const double* GetLatitudes() const { return Latitudes.GetData(); }
+    const double* GetLongitudes() const { return Longitudes.GetData(); }
+
+    // Same rule as FOperatingHours::IsOpenAt, without materializing the row
+    bool IsOpenAt(int32 Row, const FDateTime& UtcTime, int32 FallbackUtcOffsetMinutes) const;
+
+    void Materialize(int32 Row, const FRestaurantStringPool& Pool, FRestaurantData& OutRestaurant) const;
+    void MaterializeAll(const FRestaurantStringPool& Pool, TArray<FRestaurantData>& OutRestaurants) const;
+
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    enum EFlags : uint8
+    {
+        AcceptsReservations = 1 << 0,
+        Takeout = 1 << 1,
+        Delivery = 1 << 2,
+        Open24Hours = 1 << 3,
+        TemporarilyClosed = 1 << 4,
+        HasUtcOffset = 1 << 5,
+    };
+
+    enum ETextField
+    {
+        Name,
+        Address,
+        PhoneNumber,
+        Website,
+        GooglePlaceId,
+        YelpBusinessId,
+        NumTextFields
+    };
+
+    struct FTextSpan
+    {
+        int32 Offset = 0;
+        int32 Len = 0;
+    };
+
+    static constexpr int32 DaysPerWeek = 7;
+
+    FTextSpan AppendText(const FString& Text);
+    FString GetText(const FTextSpan& Span) const;
+
+    TArray<double> Latitudes;
+    TArray<double> Longitudes;
+    TArray<float> Ratings;
+    TArray<int32> ReviewCounts;
+    TArray<FRestaurantStringId> PriceLevels;
+    TArray<uint8> Flags;
+
+    // DaysPerWeek entries per row, Monday first
+    TArray<FRestaurantStringId> Hours;
+    TArray<FRestaurantOpenHours> OpenSlots;
+    TArray<int16> UtcOffsetMinutes;
+
+    // Variable length lists: row i owns [Starts[i], Starts[i + 1])
+    TArray<FRestaurantStringId> Cuisines;
+    TArray<int32> CuisineStarts;
+    TArray<FTextSpan> Photos;
+    TArray<int32> PhotoStarts;
+
+    // NumTextFields spans per row into TextArena
+    TArray<FTextSpan> TextFields;
+    TArray<TCHAR> TextArena;
+};
@@ -27,7 +27,8 @@ public class RestaurantConcierge : ModuleRules
             "Json",
             "JsonUtilities",
             "AudioMixer",
-            "AudioCapture"
+            "AudioCapture",
+            "ImageWrapper"
         });
 
         // AWS SDK integration (will be added when available)
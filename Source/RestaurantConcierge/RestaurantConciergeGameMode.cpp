@@ -137,6 +137,8 @@ void ARestaurantConciergeGameMode::SetupSystemBindings()
     if (RestaurantDataManager && BedrockAudioManager)
     {
         RestaurantDataManager->OnRestaurantsFound.AddDynamic(this, &ARestaurantConciergeGameMode::OnRestaurantsFound);
+        RestaurantDataManager->OnSearchRevalidated.AddDynamic(this, &ARestaurantConciergeGameMode::OnRestaurantsRevalidated);
+        RestaurantDataManager->OnSearchResultsDelta.AddDynamic(this, &ARestaurantConciergeGameMode::OnRestaurantsDelta);
         RestaurantDataManager->OnAPIError.AddDynamic(this, &ARestaurantConciergeGameMode::OnRestaurantAPIError);
     }
     
@@ -195,8 +197,9 @@ void ARestaurantConciergeGameMode::OnRestaurantsFound(const TArray<FRestaurantDa
 {
     UE_LOG(LogTemp, Log, TEXT("GameMode: Received %d restaurants"), Restaurants.Num());
     
-    // Update Bedrock context with new restaurant data
-    if (BedrockAudioManager)
+    // Update Bedrock context with new restaurant data, unless the deltas already did
+    const bool bAppliedAsDeltas = RestaurantDataManager && DeltaAppliedSessionId == RestaurantDataManager->GetLatestSessionId();
+    if (BedrockAudioManager && !bAppliedAsDeltas)
     {
         BedrockAudioManager->SetRestaurantContext(DefaultLocation, Restaurants);
     }
@@ -208,6 +211,40 @@ void ARestaurantConciergeGameMode::OnRestaurantsFound(const TArray<FRestaurantDa
     }
 }
 
+UFUNCTION()
+void ARestaurantConciergeGameMode::OnRestaurantsRevalidated(int32 SessionId, const TArray<FRestaurantData>& Restaurants)
+{
+    // Only the search the conversation is currently about matters
+    if (!RestaurantDataManager || SessionId != RestaurantDataManager->GetLatestSessionId())
+    {
+        return;
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("GameMode: Refreshed results for search %d (%d restaurants)"), SessionId, Restaurants.Num());
+    
+    if (BedrockAudioManager)
+    {
+        BedrockAudioManager->SetRestaurantContext(DefaultLocation, Restaurants);
+    }
+}
+
+UFUNCTION()
+void ARestaurantConciergeGameMode::OnRestaurantsDelta(const FRestaurantResultDelta& Delta)
+{
+    if (!RestaurantDataManager || Delta.SessionId != RestaurantDataManager->GetLatestSessionId())
+    {
+        return;
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("GameMode: Search %d update (%d new, %d changed)"), Delta.SessionId, Delta.Added.Num(), Delta.Updated.Num());
+    
+    if (BedrockAudioManager)
+    {
+        BedrockAudioManager->ApplyRestaurantDelta(DefaultLocation, Delta);
+        DeltaAppliedSessionId = Delta.SessionId;
+    }
+}
+
 UFUNCTION()
 void ARestaurantConciergeGameMode::OnRestaurantAPIError(const FString& APIName, const FString& ErrorMessage)
 {
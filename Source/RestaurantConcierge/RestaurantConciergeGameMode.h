@@ -58,10 +58,19 @@ private:
     void SetupSystemBindings();
     void LoadConfiguration();
 
+    // Latest search whose results already reached Bedrock through deltas
+    int32 DeltaAppliedSessionId = INDEX_NONE;
+
     // Event handlers
     UFUNCTION()
     void OnRestaurantsFound(const TArray<FRestaurantData>& Restaurants);
 
+    UFUNCTION()
+    void OnRestaurantsRevalidated(int32 SessionId, const TArray<FRestaurantData>& Restaurants);
+
+    UFUNCTION()
+    void OnRestaurantsDelta(const FRestaurantResultDelta& Delta);
+
     UFUNCTION()
     void OnRestaurantAPIError(const FString& APIName, const FString& ErrorMessage);
 
@@ -0,0 +1,217 @@
+#include "RestaurantContextPacker.h"
+#include "RestaurantContextRenderer.h"
+#include "Misc/StringBuilder.h"
+
+namespace
+{
+    using EField = ERestaurantContextField;
+
+    constexpr uint32 Bit(EField Field)
+    {
+        return FRestaurantContextRenderer::FieldBit(Field);
+    }
+
+    // Always sent, never dropped
+    constexpr uint32 EssentialFields = Bit(EField::Location) | Bit(EField::Index) | Bit(EField::Name);
+
+    // Enough to compare restaurants when the question gives nothing more specific away
+    constexpr uint32 GeneralFields = EssentialFields | Bit(EField::Cuisine) | Bit(EField::Cuisines) | Bit(EField::Price) | Bit(EField::Rating) | Bit(EField::Distance);
+
+    // Order in which fields go when restaurants do not fit, unless the question asked for them
+    constexpr EField DropOrder[] =
+    {
+        EField::Address,
+        EField::Phone,
+        EField::Services,
+        EField::Reviews,
+        EField::HoursToday,
+        EField::Distance,
+        EField::Cuisines,
+        EField::Price,
+        EField::Rating,
+        EField::Cuisine,
+    };
+    constexpr int32 NumDropOrder = UE_ARRAY_COUNT(DropOrder);
+
+    struct FQuestionTopic
+    {
+        const TCHAR* const* Keywords;
+        int32 NumKeywords;
+        uint32 Fields;
+    };
+
+    const TCHAR* const HoursKeywords[] = { TEXT("open"), TEXT("hour"), TEXT("close"), TEXT("tonight"), TEXT("late"), TEXT("when") };
+    const TCHAR* const ContactKeywords[] = { TEXT("phone"), TEXT("call"), TEXT("number"), TEXT("contact") };
+    const TCHAR* const PlaceKeywords[] = { TEXT("where"), TEXT("address"), TEXT("far"), TEXT("near"), TEXT("walk"), TEXT("distance"), TEXT("direction"), TEXT("get there") };
+    const TCHAR* const ReviewKeywords[] = { TEXT("review"), TEXT("popular"), TEXT("best"), TEXT("rated"), TEXT("rating") };
+    const TCHAR* const ServiceKeywords[] = { TEXT("deliver"), TEXT("takeout"), TEXT("take out"), TEXT("pick up"), TEXT("reserv"), TEXT("book") };
+
+    const FQuestionTopic Topics[] =
+    {
+        { HoursKeywords, UE_ARRAY_COUNT(HoursKeywords), Bit(EField::HoursToday) },
+        { ContactKeywords, UE_ARRAY_COUNT(ContactKeywords), Bit(EField::Phone) },
+        { PlaceKeywords, UE_ARRAY_COUNT(PlaceKeywords), Bit(EField::Address) | Bit(EField::Distance) },
+        { ReviewKeywords, UE_ARRAY_COUNT(ReviewKeywords), Bit(EField::Rating) | Bit(EField::Reviews) },
+        { ServiceKeywords, UE_ARRAY_COUNT(ServiceKeywords), Bit(EField::Services) | Bit(EField::Phone) },
+    };
+
+    // Names this short match too many unrelated words
+    constexpr int32 MinMentionedNameLength = 4;
+
+    int32 GetRelevance(const FRestaurantData& Restaurant, const FString& Question)
+    {
+        if (Question.IsEmpty())
+        {
+            return 0;
+        }
+        if (Restaurant.Name.Len() >= MinMentionedNameLength && Question.Contains(Restaurant.Name, ESearchCase::IgnoreCase))
+        {
+            return 2;
+        }
+        for (const FString& Cuisine : Restaurant.CuisineTypes)
+        {
+            if (Cuisine.Len() >= MinMentionedNameLength && Question.Contains(Cuisine, ESearchCase::IgnoreCase))
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+}
+
+FRestaurantContextPacker::FResult FRestaurantContextPacker::Pack(FRestaurantContextRenderer& Renderer, const FString& Location, const TArray<FRestaurantData>& Ranked,
+    const FString& Question, int32 MaxTokens) const
+{
+    FResult Result;
+
+    // Relevance first, rank within the same relevance
+    TArray<TPair<int32, int32>, TInlineAllocator<64>> Candidates;
+    for (int32 i = 0; i < Ranked.Num(); i++)
+    {
+        Candidates.Emplace(GetRelevance(Ranked[i], Question), i);
+    }
+    Candidates.StableSort([](const TPair<int32, int32>& A, const TPair<int32, int32>& B)
+    {
+        return A.Key > B.Key;
+    });
+    Candidates.SetNum(FMath::Min(Candidates.Num(), MaxRestaurants), /*bAllowShrinking*/ false);
+
+    uint32 Fields = SelectFields(Question);
+    const uint32 Asked = Fields & ~GeneralFields;
+    int32 DropIndex = 0;
+    TArray<int32, TInlineAllocator<32>> Selected;
+    TStringBuilder<512> Scratch;
+
+    while (true)
+    {
+        Scratch.Reset();
+        Renderer.RenderHeader(Location, true, Fields, Scratch);
+        int32 Tokens = EstimateTokens(Scratch.ToView());
+
+        Selected.Reset();
+        for (const TPair<int32, int32>& Candidate : Candidates)
+        {
+            Scratch.Reset();
+            Renderer.RenderEntry(Ranked[Candidate.Value], Selected.Num(), Fields, Scratch);
+            const int32 EntryTokens = EstimateTokens(Scratch.ToView());
+            if (Tokens + EntryTokens > MaxTokens)
+            {
+                break;
+            }
+            Tokens += EntryTokens;
+            Selected.Add(Candidate.Value);
+        }
+        Result.EstimatedTokens = Tokens;
+
+        if (Selected.Num() >= FMath::Min(MinRestaurants, Candidates.Num()))
+        {
+            break;
+        }
+
+        // Unasked fields go first, asked ones only once nothing else is left
+        uint32 Drop = 0;
+        for (; DropIndex < NumDropOrder * 2 && Drop == 0; DropIndex++)
+        {
+            const bool bAskedPass = DropIndex >= NumDropOrder;
+            const uint32 Field = Bit(DropOrder[DropIndex % NumDropOrder]);
+            if ((Fields & Field) != 0 && ((Asked & Field) != 0) == bAskedPass)
+            {
+                Drop = Field;
+            }
+        }
+        if (Drop == 0)
+        {
+            break;
+        }
+        Fields &= ~Drop;
+    }
+
+    if (Selected.IsEmpty())
+    {
+        Result.EstimatedTokens = 0;
+        return Result;
+    }
+
+    // Back into rank order, which is what the numbering tells the model
+    Selected.Sort();
+    TArray<const FRestaurantData*, TInlineAllocator<32>> Listed;
+    for (int32 Index : Selected)
+    {
+        Listed.Add(&Ranked[Index]);
+    }
+
+    Result.Text = Renderer.Render(Location, Listed, Fields);
+    Result.NumRestaurants = Selected.Num();
+    Result.Fields = Fields;
+    return Result;
+}
+
+int32 FRestaurantContextPacker::EstimateTokens(FStringView Text)
+{
+    int32 Tokens = 0;
+    int32 i = 0;
+    while (i < Text.Len())
+    {
+        const TCHAR Char = Text[i];
+        int32 RunEnd = i + 1;
+        if (FChar::IsAlpha(Char))
+        {
+            while (RunEnd < Text.Len() && FChar::IsAlpha(Text[RunEnd]))
+            {
+                RunEnd++;
+            }
+            Tokens += (RunEnd - i + 3) / 4;
+        }
+        else if (FChar::IsDigit(Char))
+        {
+            while (RunEnd < Text.Len() && FChar::IsDigit(Text[RunEnd]))
+            {
+                RunEnd++;
+            }
+            Tokens += (RunEnd - i + 2) / 3;
+        }
+        else if (!FChar::IsWhitespace(Char))
+        {
+            Tokens++;
+        }
+        i = RunEnd;
+    }
+    return Tokens;
+}
+
+uint32 FRestaurantContextPacker::SelectFields(const FString& Question)
+{
+    uint32 Fields = GeneralFields;
+    for (const FQuestionTopic& Topic : Topics)
+    {
+        for (int32 i = 0; i < Topic.NumKeywords; i++)
+        {
+            if (Question.Contains(Topic.Keywords[i], ESearchCase::IgnoreCase))
+            {
+                Fields |= Topic.Fields;
+                break;
+            }
+        }
+    }
+    return Fields;
+}
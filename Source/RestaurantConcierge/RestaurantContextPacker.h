@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+class FRestaurantContextRenderer;
+
+// Fits the restaurant part of a prompt into a token budget. Restaurants the
+// question names come first, then those serving a cuisine it mentions, then the
+// rest by rank. Fields are picked from what the question asks about; when too
+// few restaurants fit, the least relevant fields are dropped before restaurants
+// are. The renderer's template decides the encoding, so its cache still applies
+// whenever the question keeps to the same fields.
+class RESTAURANTCONCIERGE_API FRestaurantContextPacker
+{
+public:
+    struct FResult
+    {
+        FString Text;
+        int32 EstimatedTokens = 0;
+        int32 NumRestaurants = 0;
+        uint32 Fields = 0;
+    };
+
+    // Restaurants kept even at the cost of fields, as long as they fit at all
+    int32 MinRestaurants = 3;
+
+    // Upper bound regardless of budget
+    int32 MaxRestaurants = 20;
+
+    FResult Pack(FRestaurantContextRenderer& Renderer, const FString& Location, const TArray<FRestaurantData>& Ranked, const FString& Question, int32 MaxTokens) const;
+
+    // Rough count for BPE tokenizers on English text: a token per four letters of
+    // a word, per three digits and per symbol. Whitespace is folded into words.
+    static int32 EstimateTokens(FStringView Text);
+
+    // Fields worth including when answering Question, an empty question gets the general set
+    static uint32 SelectFields(const FString& Question);
+};
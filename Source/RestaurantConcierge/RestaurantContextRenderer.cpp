@@ -0,0 +1,466 @@
+#include "RestaurantContextRenderer.h"
+#include "RestaurantHours.h"
+#include "Misc/StringBuilder.h"
+#include "Misc/Crc.h"
+
+namespace
+{
+    // Renders kept per renderer, enough for a few result sets being flipped between
+    constexpr int32 MaxCachedRenders = 4;
+
+    // Covers ten detailed entries without the builder going to the heap
+    constexpr int32 InlineBuilderChars = 4096;
+
+    const TCHAR* const FieldNames[] =
+    {
+        TEXT("Location"),
+        TEXT("Index"),
+        TEXT("Name"),
+        TEXT("Cuisine"),
+        TEXT("Cuisines"),
+        TEXT("Price"),
+        TEXT("Rating"),
+        TEXT("Reviews"),
+        TEXT("Address"),
+        TEXT("HoursToday"),
+        TEXT("Phone"),
+        TEXT("Distance"),
+        TEXT("Services"),
+    };
+    static_assert(UE_ARRAY_COUNT(FieldNames) == static_cast<int32>(ERestaurantContextField::Count), "Every context field needs a name");
+
+    ERestaurantContextField FindField(FStringView Name)
+    {
+        for (int32 i = 0; i < UE_ARRAY_COUNT(FieldNames); i++)
+        {
+            if (Name.Equals(FieldNames[i], ESearchCase::CaseSensitive))
+            {
+                return static_cast<ERestaurantContextField>(i);
+            }
+        }
+        return ERestaurantContextField::Count;
+    }
+
+    const TCHAR* GetPrimaryCuisine(const FRestaurantData& Restaurant)
+    {
+        return Restaurant.CuisineTypes.Num() > 0 ? *Restaurant.CuisineTypes[0] : TEXT("Various");
+    }
+
+    uint32 GetServiceFlags(const FRestaurantData& Restaurant)
+    {
+        return (Restaurant.bAcceptsReservations ? 1u : 0u) | (Restaurant.bTakeout ? 2u : 0u) | (Restaurant.bDelivery ? 4u : 0u);
+    }
+
+    uint32 HashText(const TCHAR* Text)
+    {
+        // Case matters in the rendered text, unlike for GetTypeHash(FString)
+        return FCrc::StrCrc32(Text);
+    }
+
+    uint32 HashField(const FRestaurantData& Restaurant, ERestaurantContextField Field)
+    {
+        switch (Field)
+        {
+        case ERestaurantContextField::Name:
+            return HashText(*Restaurant.Name);
+        case ERestaurantContextField::Cuisine:
+            return HashText(GetPrimaryCuisine(Restaurant));
+        case ERestaurantContextField::Cuisines:
+        {
+            uint32 Hash = GetTypeHash(Restaurant.CuisineTypes.Num());
+            for (const FString& Cuisine : Restaurant.CuisineTypes)
+            {
+                Hash = HashCombine(Hash, HashText(*Cuisine));
+            }
+            return Hash;
+        }
+        case ERestaurantContextField::Price:
+            return HashText(*Restaurant.PriceLevel);
+        case ERestaurantContextField::Rating:
+            // Rendered with one decimal, finer changes do not show
+            return GetTypeHash(FMath::RoundToInt(Restaurant.Rating * 10.0f));
+        case ERestaurantContextField::Reviews:
+            return GetTypeHash(Restaurant.ReviewCount);
+        case ERestaurantContextField::Address:
+            return HashText(*Restaurant.Address);
+        case ERestaurantContextField::HoursToday:
+            // Covers the day changing as well as the hours
+            return HashCombine(GetTypeHash(Restaurant.Hours.OpenSlots.bKnown), HashText(FRestaurantContextRenderer::GetTodayHours(Restaurant.Hours)));
+        case ERestaurantContextField::Phone:
+            return HashText(*Restaurant.PhoneNumber);
+        case ERestaurantContextField::Distance:
+            // Rendered to ten meters at most
+            return GetTypeHash(FMath::RoundToInt(Restaurant.DistanceFromUser / 10.0f));
+        case ERestaurantContextField::Services:
+            return GetServiceFlags(Restaurant);
+        default:
+            return 0;
+        }
+    }
+
+    void AppendField(ERestaurantContextField Field, const FRestaurantData& Restaurant, int32 Index, FStringBuilderBase& Builder)
+    {
+        switch (Field)
+        {
+        case ERestaurantContextField::Index:
+            Builder.Appendf(TEXT("%d"), Index + 1);
+            break;
+        case ERestaurantContextField::Name:
+            Builder << Restaurant.Name;
+            break;
+        case ERestaurantContextField::Cuisine:
+            Builder << GetPrimaryCuisine(Restaurant);
+            break;
+        case ERestaurantContextField::Cuisines:
+            for (int32 i = 0; i < Restaurant.CuisineTypes.Num(); i++)
+            {
+                if (i > 0)
+                {
+                    Builder << TEXT(", ");
+                }
+                Builder << Restaurant.CuisineTypes[i];
+            }
+            break;
+        case ERestaurantContextField::Price:
+            Builder << Restaurant.PriceLevel;
+            break;
+        case ERestaurantContextField::Rating:
+            Builder.Appendf(TEXT("%.1f"), Restaurant.Rating);
+            break;
+        case ERestaurantContextField::Reviews:
+            Builder.Appendf(TEXT("%d"), Restaurant.ReviewCount);
+            break;
+        case ERestaurantContextField::Address:
+            Builder << Restaurant.Address;
+            break;
+        case ERestaurantContextField::HoursToday:
+            Builder << FRestaurantContextRenderer::GetTodayHours(Restaurant.Hours);
+            break;
+        case ERestaurantContextField::Phone:
+            Builder << Restaurant.PhoneNumber;
+            break;
+        case ERestaurantContextField::Distance:
+            if (Restaurant.DistanceFromUser < 1000.0f)
+            {
+                Builder.Appendf(TEXT("%dm"), FMath::RoundToInt(Restaurant.DistanceFromUser / 10.0f) * 10);
+            }
+            else
+            {
+                Builder.Appendf(TEXT("%.1fkm"), Restaurant.DistanceFromUser / 1000.0f);
+            }
+            break;
+        case ERestaurantContextField::Services:
+        {
+            const TCHAR* Separator = TEXT("");
+            if (Restaurant.bAcceptsReservations)
+            {
+                Builder << TEXT("reservations");
+                Separator = TEXT("/");
+            }
+            if (Restaurant.bTakeout)
+            {
+                Builder << Separator << TEXT("takeout");
+                Separator = TEXT("/");
+            }
+            if (Restaurant.bDelivery)
+            {
+                Builder << Separator << TEXT("delivery");
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+FRestaurantContextRenderer::FRestaurantContextRenderer(const FRestaurantContextTemplateSource& Source, int32 InMaxEntries)
+    : Version(Source.Version)
+    , MaxEntries(FMath::Max(InMaxEntries, 0))
+{
+    Compile(Source.Header, Header);
+    Compile(Source.ListHeader, ListHeader);
+    Compile(Source.Entry, Entry);
+}
+
+FString FRestaurantContextRenderer::Render(const FString& Location, TConstArrayView<FRestaurantData> Restaurants, uint32 Fields)
+{
+    TArray<const FRestaurantData*, TInlineAllocator<16>> Listed;
+    for (int32 i = 0; i < FMath::Min(Restaurants.Num(), MaxEntries); i++)
+    {
+        Listed.Add(&Restaurants[i]);
+    }
+    return Render(Location, Listed, Fields);
+}
+
+FString FRestaurantContextRenderer::Render(const FString& Location, TConstArrayView<const FRestaurantData*> Restaurants, uint32 Fields)
+{
+    const uint32 Key = ComputeKey(Location, Restaurants, Fields);
+    FString Text;
+    if (FindCached(Key, Text))
+    {
+        return Text;
+    }
+    return RenderUncached(Key, Location, Restaurants, Fields);
+}
+
+uint32 FRestaurantContextRenderer::ComputeSourceKey(const FString& Location, TConstArrayView<FRestaurantData> Sources, uint32 SourceSalt, uint32 Fields) const
+{
+    TArray<const FRestaurantData*, TInlineAllocator<16>> Listed;
+    for (int32 i = 0; i < FMath::Min(Sources.Num(), MaxEntries); i++)
+    {
+        Listed.Add(&Sources[i]);
+    }
+    return HashCombine(ComputeKey(Location, Listed, Fields), SourceSalt);
+}
+
+bool FRestaurantContextRenderer::FindCached(uint32 Key, FString& OutText)
+{
+    for (int32 i = 0; i < Cache.Num(); i++)
+    {
+        if (Cache[i].Key == Key)
+        {
+            if (i > 0)
+            {
+                FCachedRender Hit = MoveTemp(Cache[i]);
+                Cache.RemoveAt(i);
+                Cache.Insert(MoveTemp(Hit), 0);
+            }
+            OutText = Cache[0].Text;
+            return true;
+        }
+    }
+    return false;
+}
+
+FString FRestaurantContextRenderer::RenderAs(uint32 Key, const FString& Location, TConstArrayView<FRestaurantData> Restaurants, uint32 Fields)
+{
+    TArray<const FRestaurantData*, TInlineAllocator<16>> Listed;
+    for (int32 i = 0; i < FMath::Min(Restaurants.Num(), MaxEntries); i++)
+    {
+        Listed.Add(&Restaurants[i]);
+    }
+    return RenderUncached(Key, Location, Listed, Fields);
+}
+
+FString FRestaurantContextRenderer::RenderUncached(uint32 Key, const FString& Location, TConstArrayView<const FRestaurantData*> Restaurants, uint32 Fields)
+{
+    const int32 Count = FMath::Min(Restaurants.Num(), MaxEntries);
+    TStringBuilder<InlineBuilderChars> Builder;
+
+    RenderHeader(Location, Count > 0, Fields, Builder);
+    for (int32 i = 0; i < Count; i++)
+    {
+        RenderEntry(*Restaurants[i], i, Fields, Builder);
+    }
+
+    if (Cache.Num() >= MaxCachedRenders)
+    {
+        Cache.Pop();
+    }
+    FCachedRender& Rendered = Cache.InsertDefaulted_GetRef(0);
+    Rendered.Key = Key;
+    Rendered.Text = Builder.ToString();
+    return Rendered.Text;
+}
+
+void FRestaurantContextRenderer::RenderHeader(const FString& Location, bool bWithList, uint32 Fields, FStringBuilderBase& Builder) const
+{
+    RenderOps(Header, Location, nullptr, 0, Fields, Builder);
+    if (bWithList)
+    {
+        RenderOps(ListHeader, Location, nullptr, 0, Fields, Builder);
+    }
+}
+
+void FRestaurantContextRenderer::RenderEntry(const FRestaurantData& Restaurant, int32 Index, uint32 Fields, FStringBuilderBase& Builder) const
+{
+    RenderOps(Entry, FString(), &Restaurant, Index, Fields, Builder);
+}
+
+const TCHAR* FRestaurantContextRenderer::GetTodayHours(const FOperatingHours& Hours)
+{
+    if (Hours.bTemporarilyClosed)
+    {
+        return TEXT("Temporarily closed");
+    }
+    if (Hours.bOpen24Hours)
+    {
+        return TEXT("Open 24 hours");
+    }
+
+    if (!Hours.OpenSlots.bKnown)
+    {
+        return TEXT("Hours unknown");
+    }
+
+    int32 Day = 0, MinuteOfDay = 0;
+    const int32 UtcOffsetMinutes = Hours.bHasUtcOffset ? Hours.UtcOffsetMinutes : FRestaurantOpenHours::GetLocalUtcOffsetMinutes();
+    FRestaurantOpenHours::ToLocal(FDateTime::UtcNow(), UtcOffsetMinutes, Day, MinuteOfDay);
+
+    // Known hours only list the days the restaurant opens on
+    const FString* Today = Hours.WeeklyHours.Find(FRestaurantOpenHours::GetDayName(Day));
+    return Today ? **Today : TEXT("Closed");
+}
+
+void FRestaurantContextRenderer::Compile(const TCHAR* Text, FCompiled& Out)
+{
+    Out.Text = Text;
+    Out.Ops.Reset();
+
+    const TCHAR* Chars = *Out.Text;
+    const int32 Len = Out.Text.Len();
+    int32 LiteralStart = 0;
+    TArray<int32, TInlineAllocator<4>> OpenGroups;
+
+    auto FlushLiteral = [&Out, &LiteralStart](int32 End)
+    {
+        if (End > LiteralStart)
+        {
+            FOp& Op = Out.Ops.AddDefaulted_GetRef();
+            Op.Kind = EOp::Literal;
+            Op.Start = LiteralStart;
+            Op.Len = End - LiteralStart;
+        }
+    };
+
+    for (int32 i = 0; i < Len; i++)
+    {
+        if (Chars[i] == TEXT('{'))
+        {
+            int32 Close = i + 1;
+            while (Close < Len && Chars[Close] != TEXT('}'))
+            {
+                Close++;
+            }
+
+            const ERestaurantContextField Field = Close < Len ? FindField(FStringView(Chars + i + 1, Close - i - 1)) : ERestaurantContextField::Count;
+            if (Field == ERestaurantContextField::Count)
+            {
+                // Left in the text as is, the same way a typo would show up in the prompt
+                UE_LOG(LogTemp, Warning, TEXT("Unknown field in restaurant context template: %s"), Chars + i);
+                continue;
+            }
+
+            FlushLiteral(i);
+            FOp& Op = Out.Ops.AddDefaulted_GetRef();
+            Op.Kind = EOp::Field;
+            Op.Field = Field;
+            if (OpenGroups.Num() > 0)
+            {
+                Out.Ops[OpenGroups.Last()].RequiredFields |= FieldBit(Field);
+            }
+            UsedFields |= FieldBit(Field);
+
+            i = Close;
+            LiteralStart = Close + 1;
+        }
+        else if (Chars[i] == TEXT('['))
+        {
+            FlushLiteral(i);
+            OpenGroups.Add(Out.Ops.Num());
+            Out.Ops.AddDefaulted_GetRef().Kind = EOp::Group;
+            LiteralStart = i + 1;
+        }
+        else if (Chars[i] == TEXT(']') && OpenGroups.Num() > 0)
+        {
+            FlushLiteral(i);
+            Out.Ops[OpenGroups.Pop()].End = Out.Ops.Num();
+            LiteralStart = i + 1;
+        }
+    }
+    FlushLiteral(Len);
+
+    // An unclosed group runs to the end of the template
+    for (int32 GroupOp : OpenGroups)
+    {
+        Out.Ops[GroupOp].End = Out.Ops.Num();
+    }
+}
+
+void FRestaurantContextRenderer::RenderOps(const FCompiled& Compiled, const FString& Location, const FRestaurantData* Restaurant, int32 Index, uint32 Fields, FStringBuilderBase& Builder) const
+{
+    const uint32 Present = GetPresentFields(Location, Restaurant) & Fields;
+    const TCHAR* Text = *Compiled.Text;
+
+    for (int32 i = 0; i < Compiled.Ops.Num();)
+    {
+        const FOp& Op = Compiled.Ops[i];
+        switch (Op.Kind)
+        {
+        case EOp::Literal:
+            Builder.Append(Text + Op.Start, Op.Len);
+            break;
+        case EOp::Group:
+            if ((Op.RequiredFields & ~Present) != 0)
+            {
+                i = Op.End;
+                continue;
+            }
+            break;
+        case EOp::Field:
+            if ((Fields & FieldBit(Op.Field)) == 0)
+            {
+                break;
+            }
+            if (Op.Field == ERestaurantContextField::Location)
+            {
+                Builder << Location;
+            }
+            else if (Restaurant)
+            {
+                // Restaurant fields in the header have nothing to show
+                AppendField(Op.Field, *Restaurant, Index, Builder);
+            }
+            break;
+        }
+        i++;
+    }
+}
+
+uint32 FRestaurantContextRenderer::ComputeKey(const FString& Location, TConstArrayView<const FRestaurantData*> Restaurants, uint32 Fields) const
+{
+    const int32 Count = FMath::Min(Restaurants.Num(), MaxEntries);
+    const uint32 Rendered = UsedFields & Fields;
+    uint32 Key = HashCombine(GetTypeHash(Version), GetTypeHash(Count));
+    Key = HashCombine(Key, GetTypeHash(Rendered));
+    if (Rendered & FieldBit(ERestaurantContextField::Location))
+    {
+        Key = HashCombine(Key, HashText(*Location));
+    }
+
+    // Index follows from the order, which the combine already captures
+    const uint32 RestaurantFields = Rendered & ~(FieldBit(ERestaurantContextField::Location) | FieldBit(ERestaurantContextField::Index));
+    for (int32 i = 0; i < Count; i++)
+    {
+        for (uint32 Remaining = RestaurantFields; Remaining != 0; Remaining &= Remaining - 1)
+        {
+            const ERestaurantContextField Field = static_cast<ERestaurantContextField>(FMath::CountTrailingZeros(Remaining));
+            Key = HashCombine(Key, HashField(*Restaurants[i], Field));
+        }
+    }
+
+    return Key;
+}
+
+uint32 FRestaurantContextRenderer::GetPresentFields(const FString& Location, const FRestaurantData* Restaurant)
+{
+    uint32 Present = Location.IsEmpty() ? 0 : FieldBit(ERestaurantContextField::Location);
+    if (!Restaurant)
+    {
+        return Present;
+    }
+
+    Present |= FieldBit(ERestaurantContextField::Index) | FieldBit(ERestaurantContextField::Cuisine);
+    Present |= Restaurant->Name.IsEmpty() ? 0 : FieldBit(ERestaurantContextField::Name);
+    Present |= Restaurant->CuisineTypes.IsEmpty() ? 0 : FieldBit(ERestaurantContextField::Cuisines);
+    Present |= Restaurant->PriceLevel.IsEmpty() ? 0 : FieldBit(ERestaurantContextField::Price);
+    Present |= Restaurant->Rating > 0.0f ? FieldBit(ERestaurantContextField::Rating) : 0;
+    Present |= Restaurant->ReviewCount > 0 ? FieldBit(ERestaurantContextField::Reviews) : 0;
+    Present |= Restaurant->Address.IsEmpty() ? 0 : FieldBit(ERestaurantContextField::Address);
+    Present |= Restaurant->Hours.OpenSlots.bKnown ? FieldBit(ERestaurantContextField::HoursToday) : 0;
+    Present |= Restaurant->PhoneNumber.IsEmpty() ? 0 : FieldBit(ERestaurantContextField::Phone);
+    Present |= Restaurant->DistanceFromUser > 0.0f ? FieldBit(ERestaurantContextField::Distance) : 0;
+    Present |= GetServiceFlags(*Restaurant) != 0 ? FieldBit(ERestaurantContextField::Services) : 0;
+    return Present;
+}
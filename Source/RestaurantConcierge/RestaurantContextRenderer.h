@@ -0,0 +1,125 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+// Values a context template can insert. A template writes them as {Name}, e.g. {Rating}.
+enum class ERestaurantContextField : uint8
+{
+    Location,       // Search location given to Render
+    Index,          // 1-based position in the list
+    Name,
+    Cuisine,        // First cuisine, "Various" if none is known
+    Cuisines,       // All cuisines, comma separated
+    Price,
+    Rating,         // One decimal
+    Reviews,
+    Address,
+    HoursToday,     // Today's hours in the restaurant's local time
+    Phone,
+    Distance,       // From the user, "350m" or "1.2km"
+    Services,       // Reservations, takeout and delivery, slash separated
+    Count
+};
+
+// Text of a context template. Header is written once, ListHeader once before the
+// first restaurant (left out for an empty list) and Entry once per restaurant.
+// Text between [ and ] is left out when a field directly inside it has no value,
+// groups may nest. Bump Version whenever the text changes so cached renders of
+// the old text are not reused.
+struct FRestaurantContextTemplateSource
+{
+    const TCHAR* Header = TEXT("");
+    const TCHAR* ListHeader = TEXT("");
+    const TCHAR* Entry = TEXT("");
+    uint32 Version = 1;
+};
+
+// Renders restaurant lists into the text handed to the concierge model. The
+// template is compiled once into literal and field ops; a render walks the ops
+// and appends into a stack buffer, so there are no per-field temporaries. The
+// last few renders are kept by a hash of the template version, the field mask
+// and every field the template reads, so broadcasting the same results again
+// costs a hash over at most MaxEntries restaurants and a string copy.
+class RESTAURANTCONCIERGE_API FRestaurantContextRenderer
+{
+public:
+    static constexpr uint32 FieldBit(ERestaurantContextField Field) { return 1u << static_cast<uint32>(Field); }
+    static constexpr uint32 AllFields = (1u << static_cast<uint32>(ERestaurantContextField::Count)) - 1;
+
+    FRestaurantContextRenderer(const FRestaurantContextTemplateSource& Source, int32 InMaxEntries = 10);
+
+    // Renders the first MaxEntries restaurants. Fields left out of the mask are
+    // treated as having no value.
+    FString Render(const FString& Location, TConstArrayView<FRestaurantData> Restaurants, uint32 Fields = AllFields);
+    FString Render(const FString& Location, TConstArrayView<const FRestaurantData*> Restaurants, uint32 Fields = AllFields);
+
+    // For callers that derive the rendered rows from source rows: a key of the source
+    // rows and of everything else the derivation depends on (SourceSalt), so a cached
+    // render is found before deriving anything. RenderAs then caches under that key.
+    uint32 ComputeSourceKey(const FString& Location, TConstArrayView<FRestaurantData> Sources, uint32 SourceSalt, uint32 Fields = AllFields) const;
+    bool FindCached(uint32 Key, FString& OutText);
+    FString RenderAs(uint32 Key, const FString& Location, TConstArrayView<FRestaurantData> Restaurants, uint32 Fields = AllFields);
+
+    // Single parts of a render, for measuring before committing to a selection
+    void RenderHeader(const FString& Location, bool bWithList, uint32 Fields, FStringBuilderBase& Builder) const;
+    void RenderEntry(const FRestaurantData& Restaurant, int32 Index, uint32 Fields, FStringBuilderBase& Builder) const;
+
+    void ClearCache() { Cache.Reset(); }
+
+    // Today's hours in the restaurant's local time, pointing into Hours or at a literal
+    static const TCHAR* GetTodayHours(const FOperatingHours& Hours);
+
+private:
+    enum class EOp : uint8
+    {
+        Literal,
+        Field,
+        Group
+    };
+
+    struct FOp
+    {
+        EOp Kind = EOp::Literal;
+        ERestaurantContextField Field = ERestaurantContextField::Count;
+
+        // Literal: range in Text
+        int32 Start = 0;
+        int32 Len = 0;
+
+        // Group: first op after the group and the fields that must have a value
+        int32 End = 0;
+        uint32 RequiredFields = 0;
+    };
+
+    struct FCompiled
+    {
+        FString Text;
+        TArray<FOp> Ops;
+    };
+
+    struct FCachedRender
+    {
+        uint32 Key = 0;
+        FString Text;
+    };
+
+    void Compile(const TCHAR* Text, FCompiled& Out);
+    void RenderOps(const FCompiled& Compiled, const FString& Location, const FRestaurantData* Restaurant, int32 Index, uint32 Fields, FStringBuilderBase& Builder) const;
+    uint32 ComputeKey(const FString& Location, TConstArrayView<const FRestaurantData*> Restaurants, uint32 Fields) const;
+    FString RenderUncached(uint32 Key, const FString& Location, TConstArrayView<const FRestaurantData*> Restaurants, uint32 Fields);
+
+    static uint32 GetPresentFields(const FString& Location, const FRestaurantData* Restaurant);
+
+    FCompiled Header;
+    FCompiled ListHeader;
+    FCompiled Entry;
+    uint32 Version = 0;
+    int32 MaxEntries = 10;
+
+    // Every field any part of the template reads, only these go into the cache key
+    uint32 UsedFields = 0;
+
+    // Most recent first
+    TArray<FCachedRender, TInlineAllocator<4>> Cache;
+};
@@ -2,13 +2,17 @@
 
 #include "CoreMinimal.h"
 #include "Engine/DataTable.h"
+#include "RestaurantHours.h"
 #include "RestaurantData.generated.h"
 
+class UTexture2D;
+
 USTRUCT(BlueprintType)
 struct FOperatingHours
 {
     GENERATED_BODY()
 
+    // Only days a provider reported; a missing day is closed if OpenSlots.bKnown, unknown otherwise
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Hours")
     TMap<FString, FString> WeeklyHours; // "Monday" -> "9:00 AM - 10:00 PM"
 
@@ -18,15 +22,31 @@ struct FOperatingHours
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Hours")
     bool bTemporarilyClosed = false;
 
-    FOperatingHours()
+    // Offset of the restaurant's local time from UTC, when the provider reports it
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Hours")
+    int32 UtcOffsetMinutes = 0;
+
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Hours")
+    bool bHasUtcOffset = false;
+
+    // WeeklyHours in evaluable form, call RebuildOpenSlots after changing the fields above
+    FRestaurantOpenHours OpenSlots;
+
+    void RebuildOpenSlots();
+
+    // Hours that could not be parsed count as open, a filter should not hide them.
+    // FallbackUtcOffsetMinutes applies when the provider did not report an offset.
+    bool IsOpenAt(const FDateTime& UtcTime, int32 FallbackUtcOffsetMinutes) const;
+
+    // Heap bytes owned by this struct, not including sizeof(FOperatingHours)
+    SIZE_T GetAllocatedSize() const
     {
-        WeeklyHours.Add("Monday", "Closed");
-        WeeklyHours.Add("Tuesday", "Closed");
-        WeeklyHours.Add("Wednesday", "Closed");
-        WeeklyHours.Add("Thursday", "Closed");
-        WeeklyHours.Add("Friday", "Closed");
-        WeeklyHours.Add("Saturday", "Closed");
-        WeeklyHours.Add("Sunday", "Closed");
+        SIZE_T Size = WeeklyHours.GetAllocatedSize();
+        for (const TPair<FString, FString>& Day : WeeklyHours)
+        {
+            Size += Day.Key.GetAllocatedSize() + Day.Value.GetAllocatedSize();
+        }
+        return Size;
     }
 };
 
@@ -96,6 +116,28 @@ struct FRestaurantData : public FTableRowBase
         bDelivery = false;
         DistanceFromUser = 0.0f;
     }
+
+    // Heap bytes owned by this row, not including sizeof(FRestaurantData)
+    SIZE_T GetAllocatedSize() const
+    {
+        SIZE_T Size = Name.GetAllocatedSize() + Address.GetAllocatedSize() + PriceLevel.GetAllocatedSize() +
+            PhoneNumber.GetAllocatedSize() + Website.GetAllocatedSize() +
+            GooglePlaceId.GetAllocatedSize() + YelpBusinessId.GetAllocatedSize();
+
+        Size += CuisineTypes.GetAllocatedSize();
+        for (const FString& Cuisine : CuisineTypes)
+        {
+            Size += Cuisine.GetAllocatedSize();
+        }
+
+        Size += PhotoURLs.GetAllocatedSize();
+        for (const FString& PhotoURL : PhotoURLs)
+        {
+            Size += PhotoURL.GetAllocatedSize();
+        }
+
+        return Size + Hours.GetAllocatedSize();
+    }
 };
 
 USTRUCT(BlueprintType)
@@ -138,5 +180,133 @@ struct FSearchFilters
     }
 };
 
+// Weights of the relevance score. Each term is scaled to 0..1 before weighting.
+USTRUCT(BlueprintType)
+struct FRestaurantRankingWeights
+{
+    GENERATED_BODY()
+
+    // Rating, smoothed towards PriorRating for restaurants with few reviews
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ranking")
+    float Rating = 1.0f;
+
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ranking")
+    float Distance = 0.35f;
+
+    // Share of the requested cuisines the restaurant serves
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ranking")
+    float PreferenceMatch = 0.25f;
+
+    // A restaurant with this many reviews is scored halfway between its own rating and the prior
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ranking")
+    float PriorReviewCount = 25.0f;
+
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ranking")
+    float PriorRating = 3.8f;
+
+    // Distance at which the distance term has dropped to one half
+    UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ranking")
+    float DistanceHalfScoreMeters = 1000.0f;
+};
+
+USTRUCT(BlueprintType)
+struct FRestaurantCacheStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Cache")
+    int64 Hits = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Cache")
+    int64 Misses = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Cache")
+    int64 Evictions = 0; // Removed to stay within the byte budget
+
+    UPROPERTY(BlueprintReadOnly, Category = "Cache")
+    int64 Expirations = 0; // Removed after outliving the TTL
+
+    UPROPERTY(BlueprintReadOnly, Category = "Cache")
+    int32 NumEntries = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Cache")
+    int64 UsedBytes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Cache")
+    int64 BudgetBytes = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FRestaurantQuotaStatus
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Quota")
+    FString Provider;
+
+    // Requests that could go out right now without exceeding the rate limit
+    UPROPERTY(BlueprintReadOnly, Category = "Quota")
+    float RateTokens = 0.0f;
+
+    // Left of today's quota for the provider's key, -1 without a daily limit
+    UPROPERTY(BlueprintReadOnly, Category = "Quota")
+    int32 DailyRemaining = -1;
+
+    // The provider answered 429 and is not sent anything until the backoff ends
+    UPROPERTY(BlueprintReadOnly, Category = "Quota")
+    float BackoffSeconds = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Quota")
+    int32 QueuedRequests = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FRestaurantDeltaEntry
+{
+    GENERATED_BODY()
+
+    // Stable for the lifetime of the search, not across searches
+    UPROPERTY(BlueprintReadOnly, Category = "Search")
+    int32 ResultId = INDEX_NONE;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Search")
+    FRestaurantData Restaurant;
+};
+
+// Progressive delivery: one update to a search's results as another provider
+// answers. Applying every delta of a session in order reproduces its result list.
+USTRUCT(BlueprintType)
+struct FRestaurantResultDelta
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Search")
+    int32 SessionId = INDEX_NONE;
+
+    // Restaurants not delivered before
+    UPROPERTY(BlueprintReadOnly, Category = "Search")
+    TArray<FRestaurantDeltaEntry> Added;
+
+    // Delivered restaurants whose data changed, usually merged with another provider's record
+    UPROPERTY(BlueprintReadOnly, Category = "Search")
+    TArray<FRestaurantDeltaEntry> Updated;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Search")
+    TArray<int32> RemovedIds;
+
+    // Every current result, best first
+    UPROPERTY(BlueprintReadOnly, Category = "Search")
+    TArray<int32> RankedIds;
+
+    // The search is complete, OnSearchComplete follows with the same results
+    UPROPERTY(BlueprintReadOnly, Category = "Search")
+    bool bFinal = false;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnRestaurantsFound, const TArray<FRestaurantData>&, Restaurants);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnSearchComplete, int32, SessionId, const TArray<FRestaurantData>&, Restaurants);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSearchResultsDelta, const FRestaurantResultDelta&, Delta);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnRestaurantPhotoReady, const FString&, PhotoURL, UTexture2D*, Texture, bool, bFullResolution);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnRestaurantPhotoReleased, const FString&, PhotoURL, UTexture2D*, Texture);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnRestaurantDetailsReceived, const FRestaurantData&, Details);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAPIError, const FString&, APIName, const FString&, ErrorMessage);
\ No newline at end of file
@@ -1,12 +1,55 @@
 #include "RestaurantDataManager.h"
+#include "RestaurantGeo.h"
 #include "Json.h"
 #include "JsonObjectConverter.h"
+#include "Async/Async.h"
+#include "Misc/Paths.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
 
+namespace
+{
+    // Searches whose unfiltered results are kept for RefineSearch
+    constexpr int32 MaxRetainedResultSets = 8;
+
+    constexpr int32 MaxCachedDetails = 512;
+
+    // Search centers closer than this are the same query for coalescing
+    constexpr double SameQueryCenterMeters = 1.0;
+
+    FRestaurantContextTemplateSource MakeContextTemplate()
+    {
+        FRestaurantContextTemplateSource Template;
+        Template.Header = TEXT("Available restaurants in the area:\n\n");
+        Template.Entry = TEXT("{Index}. {Name}\n")
+            TEXT("[   Cuisine: {Cuisines}\n]")
+            TEXT("[   Price: {Price}\n]")
+            TEXT("[   Rating: {Rating}/5.0[ ({Reviews} reviews)]\n]")
+            TEXT("[   Address: {Address}\n]")
+            TEXT("[   Hours today: {HoursToday}\n]")
+            TEXT("[   Phone: {Phone}\n]")
+            TEXT("\n");
+        Template.Version = 1;
+        return Template;
+    }
+}
+
 ARestaurantDataManager::ARestaurantDataManager()
 {
     PrimaryActorTick.bCanEverTick = false;
+    
+    HttpClient = MakeShared<FRestaurantHttpClient>();
+    Scheduler = MakeShared<FRestaurantRequestScheduler>(HttpClient.ToSharedRef());
+    Photos = MakeShared<FRestaurantPhotoPipeline>(Scheduler.ToSharedRef(), HttpClient.ToSharedRef(), FPaths::ProjectSavedDir() / TEXT("Cache") / TEXT("Photos"));
+    GooglePlacesProvider = MakeShared<FGooglePlacesProvider>();
+    YelpProvider = MakeShared<FYelpProvider>();
+    RegisterProvider(GooglePlacesProvider.ToSharedRef());
+    RegisterProvider(YelpProvider.ToSharedRef());
+    
+    WeightedRanker = MakeShared<FWeightedRestaurantRanker>();
+    Ranker = WeightedRanker;
+    
+    ContextRenderer = MakeUnique<FRestaurantContextRenderer>(MakeContextTemplate());
 }
 
 void ARestaurantDataManager::BeginPlay()
@@ -15,543 +58,1488 @@ void ARestaurantDataManager::BeginPlay()
     
     // Initialize API keys from project settings or environment
     // These should be set via Blueprint or configuration
+    SetAPIKeys(GooglePlacesAPIKey, YelpAPIKey);
+    
+    GooglePlacesProvider->Policy.TimeoutSeconds = ProviderTimeoutSeconds;
+    GooglePlacesProvider->Policy.FirstByteTimeoutSeconds = ProviderFirstByteTimeoutSeconds;
+    GooglePlacesProvider->Policy.HedgeDelaySeconds = ProviderHedgeDelaySeconds;
+    YelpProvider->Policy.TimeoutSeconds = ProviderTimeoutSeconds;
+    YelpProvider->Policy.FirstByteTimeoutSeconds = ProviderFirstByteTimeoutSeconds;
+    YelpProvider->Policy.HedgeDelaySeconds = ProviderHedgeDelaySeconds;
+    WeightedRanker->Weights = RankingWeights;
+    
+    TileCache.SetLimits(static_cast<int64>(CacheBudgetMegabytes) * 1024 * 1024, FMath::Max(CacheMaxAgeMinutes, CacheStaleMaxAgeMinutes));
+    DetailsCache.SetLimits(MaxCachedDetails, DetailsCacheMaxAgeMinutes);
+    
+    FRestaurantPhotoPipeline::FSettings PhotoSettings;
+    PhotoSettings.PoolSize = PhotoPoolSize;
+    PhotoSettings.TextureSize = PhotoTextureSize;
+    PhotoSettings.MaxConcurrentDownloads = MaxConcurrentPhotoDownloads;
+    PhotoSettings.DiskBudgetBytes = static_cast<int64>(PhotoDiskCacheMegabytes) * 1024 * 1024;
+    Photos->Configure(PhotoSettings);
+    Photos->SetProviders(Providers);
+    Photos->OnLoaded.BindUObject(this, &ARestaurantDataManager::OnPhotoLoaded);
+    Photos->OnEvicted.BindUObject(this, &ARestaurantDataManager::OnPhotoEvicted);
+    Photos->TrimDiskCache();
+    
+    // Only the index is read here, tiles are decoded from the mapping on first use
+    if (bPersistCache)
+    {
+        CacheStore = MakeShared<FRestaurantCacheStore, ESPMode::ThreadSafe>(FPaths::ProjectSavedDir() / TEXT("Cache") / TEXT("RestaurantTiles.bin"));
+        CacheStore->Open();
+        TileCache.SetBackingStore(CacheStore.Get());
+    }
+    
+    // Expired tiles are dropped periodically so an idle kiosk releases them too
+    GetWorldTimerManager().SetTimer(CacheEvictionTimer, FTimerDelegate::CreateWeakLambda(this, [this]()
+    {
+        TileCache.EvictExpired();
+        SaveCache();
+        Photos->TrimDiskCache();
+    }), 300.0f, true);
+    
     UE_LOG(LogTemp, Log, TEXT("RestaurantDataManager initialized"));
 }
 
+void ARestaurantDataManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    GetWorldTimerManager().ClearTimer(CacheEvictionTimer);
+    
+    // Waits for a write still in flight, then writes what changed since
+    SaveCache(true);
+    TileCache.SetBackingStore(nullptr);
+    CacheStore.Reset();
+    
+    TArray<int32> SearchIds;
+    ActiveSessions.GetKeys(SearchIds);
+    for (int32 SearchId : SearchIds)
+    {
+        CancelProviderSearch(SearchId);
+    }
+    SessionSearches.Empty();
+    
+    for (const TPair<int32, TSharedPtr<FRestaurantSearchSession>>& Prefetch : PrefetchSessions)
+    {
+        for (FRestaurantProviderCall& Call : Prefetch.Value->ProviderCalls)
+        {
+            CancelProviderCall(Call);
+        }
+    }
+    PrefetchSessions.Empty();
+    
+    for (const TPair<FString, FDetailsFetch>& Fetch : DetailsInFlight)
+    {
+        Scheduler->Cancel(Fetch.Value.Request.ToSharedRef());
+    }
+    DetailsInFlight.Empty();
+    DetailsQueue.Empty();
+    Photos->CancelPending();
+    Photos->OnLoaded.Unbind();
+    Photos->OnEvicted.Unbind();
+    
+    Super::EndPlay(EndPlayReason);
+}
+
+void ARestaurantDataManager::RegisterProvider(TSharedRef<FRestaurantProvider> Provider)
+{
+    Providers.AddUnique(Provider);
+    Photos->SetProviders(Providers);
+}
+
+TArray<FRestaurantQuotaStatus> ARestaurantDataManager::GetProviderQuotas() const
+{
+    TArray<FRestaurantQuotaStatus> Status;
+    Scheduler->GetQuotaStatus(Providers, Status);
+    return Status;
+}
+
 void ARestaurantDataManager::SetAPIKeys(const FString& GooglePlacesKey, const FString& YelpKey)
 {
     GooglePlacesAPIKey = GooglePlacesKey;
     YelpAPIKey = YelpKey;
+    GooglePlacesProvider->SetAPIKey(GooglePlacesKey);
+    YelpProvider->SetAPIKey(YelpKey);
     
     UE_LOG(LogTemp, Log, TEXT("API keys configured"));
 }
 
-void ARestaurantDataManager::SearchRestaurants(FVector2D Location, const FSearchFilters& Filters)
+int32 ARestaurantDataManager::SearchRestaurants(FVector2D Location, const FSearchFilters& Filters)
 {
-    CurrentSearchLocation = Location;
-    CurrentFilters = Filters;
+    const int32 SessionId = NextSessionId++;
+    LatestSessionId = SessionId;
     
     // Check cache first
-    FString CacheKey = GenerateCacheKey(Location, Filters);
-    if (IsCacheValid(CacheKey))
+    TArray<FRestaurantData> CachedResults;
+    FTimespan CacheAge;
+    if (TileCache.Lookup(Location, Filters.MaxDistance, Filters, CacheStaleMaxAgeMinutes, CachedResults, &CacheAge))
     {
-        TArray<FRestaurantData> CachedResults = RestaurantCache[CacheKey];
-        OnRestaurantsFound.Broadcast(CachedResults);
-        return;
+        ApplyCachedDetails(CachedResults);
+        RetainResultSet(SessionId, MakeShared<FRestaurantResultSet>(Location, Filters, Filters.MaxDistance, CachedResults));
+        ApplyLocalFilters(CachedResults, Location, Filters);
+        RankResults(CachedResults, Filters);
+        CompleteSessionNextTick(SessionId, CachedResults);
+        
+        // Past the soft TTL: answer now, refresh in the background
+        if (CacheAge.GetTotalMinutes() >= CacheMaxAgeMinutes)
+        {
+            StartRevalidation(SessionId, Location, Filters, CachedResults);
+        }
+        return SessionId;
     }
     
-    // Reset completion flags
-    bGooglePlacesComplete = false;
-    bYelpComplete = false;
-    PendingRequests = 0;
+    FRestaurantSearchSubscriber Subscriber;
+    Subscriber.SessionId = SessionId;
+    Subscriber.Location = Location;
+    Subscriber.Filters = Filters;
     
-    // Start parallel API requests
-    if (!GooglePlacesAPIKey.IsEmpty())
-    {
-        SearchGooglePlaces(Location, Filters);
-    }
-    else
+    // Another caller already asked providers the same query
+    TSharedPtr<FRestaurantSearchSession> Session = FindInFlightSearch(Location, Filters);
+    if (Session.IsValid())
     {
-        bGooglePlacesComplete = true;
+        AttachToSearch(*Session, Subscriber);
+        UE_LOG(LogTemp, Log, TEXT("Search session %d joined in-flight search %d"), SessionId, Session->SessionId);
+        return SessionId;
     }
     
-    if (!YelpAPIKey.IsEmpty())
-    {
-        SearchYelp(Location, Filters);
-    }
-    else
+    Session = StartProviderSearch(SessionId, Location, Filters);
+    if (!Session.IsValid())
     {
-        bYelpComplete = true;
+        // No API keys configured, or every provider is failing
+        HandleAPIError("Configuration", "No search provider available");
+        CompleteSessionNextTick(SessionId, TArray<FRestaurantData>());
+        return SessionId;
     }
     
-    // If no API keys are configured, return empty results
-    if (GooglePlacesAPIKey.IsEmpty() && YelpAPIKey.IsEmpty())
-    {
-        HandleAPIError("Configuration", "No API keys configured");
-        OnRestaurantsFound.Broadcast(TArray<FRestaurantData>());
-    }
+    AttachToSearch(*Session, Subscriber);
+    
+    return SessionId;
 }
 
-void ARestaurantDataManager::SearchGooglePlaces(FVector2D Location, const FSearchFilters& Filters)
+int32 ARestaurantDataManager::RefineSearch(int32 SessionId, const FSearchFilters& Filters)
 {
-    FString URL = BuildGooglePlacesSearchURL(Location, Filters);
+    const TSharedPtr<const FRestaurantResultSet>* Found = ResultSets.Find(SessionId);
+    if (!Found || !(*Found)->CanAnswer(Filters))
+    {
+        return INDEX_NONE;
+    }
+    
+    const TSharedPtr<const FRestaurantResultSet> ResultSet = *Found;
+    const int32 RefinedId = NextSessionId++;
+    LatestSessionId = RefinedId;
+    
+    TArray<int32> Rows;
+    FRestaurantFilter(Filters, ResultSet->Location).Evaluate(ResultSet->Columns, Rows);
     
-    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
-    Request->OnProcessRequestComplete().BindUObject(this, &ARestaurantDataManager::OnGooglePlacesResponse);
-    Request->SetURL(URL);
-    Request->SetVerb("GET");
-    Request->SetHeader("Content-Type", "application/json");
+    TArray<FRestaurantData> Results;
+    Results.Reserve(Rows.Num());
+    for (int32 Row : Rows)
+    {
+        Results.Add(ResultSet->Rows[Row]);
+    }
+    ApplyCachedDetails(Results);
+    RankResults(Results, Filters);
     
-    PendingRequests++;
-    Request->ProcessRequest();
+    // The refinement can be refined again, from the same rows
+    RetainResultSet(RefinedId, ResultSet);
+    CompleteSessionNextTick(RefinedId, Results);
     
-    UE_LOG(LogTemp, Log, TEXT("Google Places request sent: %s"), *URL);
+    UE_LOG(LogTemp, Log, TEXT("Search session %d refined session %d locally"), RefinedId, SessionId);
+    return RefinedId;
 }
 
-void ARestaurantDataManager::SearchYelp(FVector2D Location, const FSearchFilters& Filters)
+void ARestaurantDataManager::RetainResultSet(int32 SessionId, TSharedPtr<const FRestaurantResultSet> ResultSet)
 {
-    FString URL = BuildYelpSearchURL(Location, Filters);
-    
-    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
-    Request->OnProcessRequestComplete().BindUObject(this, &ARestaurantDataManager::OnYelpResponse);
-    Request->SetURL(URL);
-    Request->SetVerb("GET");
-    Request->SetHeader("Content-Type", "application/json");
-    Request->SetHeader("Authorization", FString::Printf(TEXT("Bearer %s"), *YelpAPIKey));
+    ResultSets.Add(SessionId, MoveTemp(ResultSet));
     
-    PendingRequests++;
-    Request->ProcessRequest();
-    
-    UE_LOG(LogTemp, Log, TEXT("Yelp request sent: %s"), *URL);
+    // Session ids only grow, the smallest one is the oldest search
+    while (ResultSets.Num() > MaxRetainedResultSets)
+    {
+        int32 OldestId = MAX_int32;
+        for (const TPair<int32, TSharedPtr<const FRestaurantResultSet>>& Entry : ResultSets)
+        {
+            OldestId = FMath::Min(OldestId, Entry.Key);
+        }
+        ResultSets.Remove(OldestId);
+    }
 }
 
-FString ARestaurantDataManager::BuildGooglePlacesSearchURL(FVector2D Location, const FSearchFilters& Filters)
+TSharedPtr<FRestaurantSearchSession> ARestaurantDataManager::StartProviderSearch(int32 SessionId, FVector2D Location, const FSearchFilters& Filters)
 {
-    FString URL = GooglePlacesBaseURL + "nearbysearch/json?";
-    URL += FString::Printf(TEXT("location=%f,%f"), Location.X, Location.Y);
-    URL += FString::Printf(TEXT("&radius=%f"), Filters.MaxDistance);
-    URL += TEXT("&type=restaurant");
+    TArray<FRestaurantProviderCall> ProviderCalls;
+    bool bSkippedProvider = false;
+    for (const TSharedPtr<FRestaurantProvider>& Provider : Providers)
+    {
+        if (!Provider->IsConfigured())
+        {
+            continue;
+        }
+        
+        // A provider known to be down or out of quota would only hold the search until its deadline
+        if (!Scheduler->IsAvailable(*Provider, ERestaurantRequestPriority::Interactive))
+        {
+            UE_LOG(LogTemp, Log, TEXT("Skipping %s, it is unavailable"), *Provider->GetName());
+            bSkippedProvider = true;
+            continue;
+        }
+        
+        ProviderCalls.AddDefaulted_GetRef().Provider = Provider;
+    }
+    
+    if (ProviderCalls.IsEmpty())
+    {
+        return nullptr;
+    }
     
-    if (Filters.bOpenNow)
+    TSharedPtr<FRestaurantSearchSession> Session = MakeShared<FRestaurantSearchSession>();
+    Session->SessionId = SessionId;
+    Session->Location = Location;
+    Session->ProviderFilters = Filters;
+    Session->QueryClass = FRestaurantTileCache::GetQueryClass(Filters);
+    Session->CacheGeneration = CacheGeneration;
+    // Without the skipped provider the results are incomplete and must not be cached
+    Session->bPartial = bSkippedProvider;
+    Session->Resolver.Reset(Location);
+    Session->ProviderCalls = MoveTemp(ProviderCalls);
+    ActiveSessions.Add(SessionId, Session);
+    InFlightSearches.Add(Session->QueryClass, SessionId);
+    
+    // Start parallel API requests
+    for (int32 CallIndex = 0; CallIndex < Session->ProviderCalls.Num(); CallIndex++)
     {
-        URL += TEXT("&opennow=true");
+        SendProviderRequest(*Session, CallIndex);
     }
     
-    if (!Filters.CuisineTypes.IsEmpty())
+    // Slow providers must not hold the answer back indefinitely
+    if (SearchDeadlineSeconds > 0.0f)
     {
-        URL += TEXT("&keyword=") + FString::Join(Filters.CuisineTypes, TEXT("+"));
+        GetWorldTimerManager().SetTimer(Session->DeadlineTimer,
+            FTimerDelegate::CreateUObject(this, &ARestaurantDataManager::OnSearchDeadline, SessionId), SearchDeadlineSeconds, false);
     }
     
-    URL += TEXT("&key=") + GooglePlacesAPIKey;
+    UE_LOG(LogTemp, Log, TEXT("Search session %d started"), SessionId);
     
-    return URL;
+    return Session;
 }
 
-FString ARestaurantDataManager::BuildYelpSearchURL(FVector2D Location, const FSearchFilters& Filters)
+TSharedPtr<FRestaurantSearchSession> ARestaurantDataManager::FindInFlightSearch(FVector2D Location, const FSearchFilters& Filters) const
 {
-    FString URL = YelpBaseURL + "businesses/search?";
-    URL += FString::Printf(TEXT("latitude=%f&longitude=%f"), Location.X, Location.Y);
-    URL += FString::Printf(TEXT("&radius=%d"), FMath::RoundToInt(Filters.MaxDistance));
-    URL += TEXT("&categories=restaurants");
-    URL += TEXT("&limit=50");
+    // Only an identical query can share the answer. Providers cap their results and
+    // rank them by prominence around the center, so a larger or off-centre circle
+    // would hand a smaller one a truncated set of the wrong restaurants.
+    const FString QueryClass = FRestaurantTileCache::GetQueryClass(Filters);
     
-    if (Filters.bOpenNow)
+    for (auto It = InFlightSearches.CreateConstKeyIterator(QueryClass); It; ++It)
     {
-        URL += TEXT("&open_now=true");
+        TSharedPtr<FRestaurantSearchSession> Session = FindLiveSession(It.Value());
+        if (Session.IsValid() && Session->ProviderFilters.MaxDistance == Filters.MaxDistance &&
+            FRestaurantGeo::HaversineMeters(Session->Location, Location) <= SameQueryCenterMeters)
+        {
+            return Session;
+        }
     }
     
-    if (!Filters.CuisineTypes.IsEmpty())
+    return nullptr;
+}
+
+void ARestaurantDataManager::AttachToSearch(FRestaurantSearchSession& Session, const FRestaurantSearchSubscriber& Subscriber)
+{
+    Session.Subscribers.Add(Subscriber);
+    
+    // Revalidations report on a session that has already completed
+    if (!Subscriber.bRevalidation)
     {
-        URL += TEXT("&term=") + FString::Join(Filters.CuisineTypes, TEXT("+"));
+        SessionSearches.Add(Subscriber.SessionId, Session.SessionId);
     }
-    
-    return URL;
 }
 
-void ARestaurantDataManager::OnGooglePlacesResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+void ARestaurantDataManager::StartRevalidation(int32 StaleSessionId, FVector2D Location, const FSearchFilters& Filters, const TArray<FRestaurantData>& StaleResults)
 {
-    PendingRequests--;
-    bGooglePlacesComplete = true;
-    
-    TArray<FRestaurantData> GoogleResults;
+    FRestaurantSearchSubscriber Subscriber;
+    Subscriber.SessionId = StaleSessionId;
+    Subscriber.Location = Location;
+    Subscriber.Filters = Filters;
+    Subscriber.bRevalidation = true;
+    Subscriber.DeliveredFingerprint = ComputeResultFingerprint(StaleResults);
     
-    if (bWasSuccessful && Response.IsValid())
+    TSharedPtr<FRestaurantSearchSession> Session = FindInFlightSearch(Location, Filters);
+    if (!Session.IsValid())
     {
-        FString ResponseBody = Response->GetContentAsString();
-        GoogleResults = ParseGooglePlacesResponse(ResponseBody);
-        
-        UE_LOG(LogTemp, Log, TEXT("Google Places returned %d results"), GoogleResults.Num());
+        Session = StartProviderSearch(NextSessionId++, Location, Filters);
     }
-    else
+    
+    if (Session.IsValid())
     {
-        HandleAPIError("GooglePlaces", "Request failed");
+        AttachToSearch(*Session, Subscriber);
     }
+}
+
+uint32 ARestaurantDataManager::ComputeResultFingerprint(const TArray<FRestaurantData>& Restaurants) const
+{
+    // Only what the concierge would say differently counts: the leading entries,
+    // their order, rating and price
+    const int32 Count = FMath::Min(Restaurants.Num(), 10);
+    uint32 Hash = GetTypeHash(Count);
     
-    // Store results temporarily
-    if (!GoogleResults.IsEmpty())
+    for (int32 i = 0; i < Count; i++)
     {
-        for (FRestaurantData& Restaurant : GoogleResults)
-        {
-            CurrentRestaurants.Add(Restaurant);
-        }
+        const FRestaurantData& Restaurant = Restaurants[i];
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.GooglePlaceId));
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.YelpBusinessId));
+        Hash = HashCombine(Hash, GetTypeHash(FMath::RoundToInt(Restaurant.Rating * 10.0f)));
+        Hash = HashCombine(Hash, GetTypeHash(Restaurant.PriceLevel));
     }
     
-    // Check if all requests are complete
-    CheckRequestsComplete();
+    return Hash;
 }
 
-void ARestaurantDataManager::OnYelpResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+void ARestaurantDataManager::CancelSearch(int32 SessionId)
 {
-    PendingRequests--;
-    bYelpComplete = true;
+    int32 SearchId = INDEX_NONE;
+    if (!SessionSearches.RemoveAndCopyValue(SessionId, SearchId))
+    {
+        return;
+    }
     
-    TArray<FRestaurantData> YelpResults;
+    UE_LOG(LogTemp, Log, TEXT("Search session %d cancelled"), SessionId);
     
-    if (bWasSuccessful && Response.IsValid())
+    TSharedPtr<FRestaurantSearchSession>* Session = ActiveSessions.Find(SearchId);
+    if (!Session)
     {
-        FString ResponseBody = Response->GetContentAsString();
-        YelpResults = ParseYelpResponse(ResponseBody);
-        
-        UE_LOG(LogTemp, Log, TEXT("Yelp returned %d results"), YelpResults.Num());
+        return;
     }
-    else
+    
+    // The provider requests keep running as long as anyone else is attached
+    (*Session)->Subscribers.RemoveAll([SessionId](const FRestaurantSearchSubscriber& Subscriber)
+    {
+        return Subscriber.SessionId == SessionId && !Subscriber.bRevalidation;
+    });
+    
+    if ((*Session)->Subscribers.IsEmpty())
+    {
+        CancelProviderSearch(SearchId);
+    }
+}
+
+void ARestaurantDataManager::CancelProviderSearch(int32 SearchId)
+{
+    TSharedPtr<FRestaurantSearchSession> Session;
+    if (!ActiveSessions.RemoveAndCopyValue(SearchId, Session))
     {
-        HandleAPIError("Yelp", "Request failed");
+        return;
     }
     
-    // Merge with existing results
-    if (!YelpResults.IsEmpty())
+    InFlightSearches.RemoveSingle(Session->QueryClass, SearchId);
+    for (const FRestaurantSearchSubscriber& Subscriber : Session->Subscribers)
     {
-        for (const FRestaurantData& YelpRestaurant : YelpResults)
+        if (!Subscriber.bRevalidation)
         {
-            // Try to find matching restaurant in current results
-            bool bFound = false;
-            for (FRestaurantData& ExistingRestaurant : CurrentRestaurants)
-            {
-                if (ExistingRestaurant.Name.Equals(YelpRestaurant.Name, ESearchCase::IgnoreCase) ||
-                    FVector2D::Distance(ExistingRestaurant.Location, YelpRestaurant.Location) < 50.0f)
-                {
-                    MergeRestaurantData(ExistingRestaurant, YelpRestaurant);
-                    bFound = true;
-                    break;
-                }
-            }
-            
-            if (!bFound)
-            {
-                CurrentRestaurants.Add(YelpRestaurant);
-            }
+            SessionSearches.Remove(Subscriber.SessionId);
         }
     }
     
-    CheckRequestsComplete();
+    // Remove first so the completion callbacks fired by CancelRequest are treated as stale
+    Session->bCancelled = true;
+    GetWorldTimerManager().ClearTimer(Session->DeadlineTimer);
+    for (FRestaurantProviderCall& Call : Session->ProviderCalls)
+    {
+        CancelProviderCall(Call);
+    }
 }
 
-void ARestaurantDataManager::CheckRequestsComplete()
+void ARestaurantDataManager::CancelProviderCall(FRestaurantProviderCall& Call)
 {
-    if (bGooglePlacesComplete && bYelpComplete)
+    GetWorldTimerManager().ClearTimer(Call.HedgeTimer);
+    GetWorldTimerManager().ClearTimer(Call.RetryTimer);
+    GetWorldTimerManager().ClearTimer(Call.PageTimer);
+    Call.bPrefetching = false;
+    for (const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request : Call.Requests)
     {
-        // Sort results by relevance
-        SortByRelevance(CurrentRestaurants);
-        
-        // Cache results
-        FString CacheKey = GenerateCacheKey(CurrentSearchLocation, CurrentFilters);
-        RestaurantCache.Add(CacheKey, CurrentRestaurants);
-        CacheTimestamps.Add(CacheKey, FDateTime::Now());
-        
-        // Broadcast results
-        OnRestaurantsFound.Broadcast(CurrentRestaurants);
-        
-        UE_LOG(LogTemp, Log, TEXT("Search complete. Found %d restaurants"), CurrentRestaurants.Num());
+        Scheduler->Cancel(Request);
     }
+    Call.Requests.Empty();
 }
 
-TArray<FRestaurantData> ARestaurantDataManager::ParseGooglePlacesResponse(const FString& ResponseBody)
+TSharedPtr<FRestaurantSearchSession> ARestaurantDataManager::FindLiveSession(int32 SessionId) const
 {
-    TArray<FRestaurantData> Results;
-    
-    TSharedPtr<FJsonObject> JsonObject;
-    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseBody);
-    
-    if (FJsonSerializer::Deserialize(Reader, JsonObject))
+    const TSharedPtr<FRestaurantSearchSession>* Session = ActiveSessions.Find(SessionId);
+    if (!Session || (*Session)->bCancelled)
     {
-        const TArray<TSharedPtr<FJsonValue>>* ResultsArray;
-        if (JsonObject->TryGetArrayField(TEXT("results"), ResultsArray))
-        {
-            for (const auto& ResultValue : *ResultsArray)
-            {
-                TSharedPtr<FJsonObject> ResultObject = ResultValue->AsObject();
-                if (ResultObject.IsValid())
-                {
-                    FRestaurantData Restaurant;
-                    
-                    // Basic info
-                    ResultObject->TryGetStringField(TEXT("name"), Restaurant.Name);
-                    ResultObject->TryGetStringField(TEXT("vicinity"), Restaurant.Address);
-                    ResultObject->TryGetStringField(TEXT("place_id"), Restaurant.GooglePlaceId);
-                    
-                    // Location
-                    const TSharedPtr<FJsonObject>* GeometryObject;
-                    if (ResultObject->TryGetObjectField(TEXT("geometry"), GeometryObject))
-                    {
-                        const TSharedPtr<FJsonObject>* LocationObject;
-                        if ((*GeometryObject)->TryGetObjectField(TEXT("location"), LocationObject))
-                        {
-                            double Lat, Lng;
-                            if ((*LocationObject)->TryGetNumberField(TEXT("lat"), Lat) &&
-                                (*LocationObject)->TryGetNumberField(TEXT("lng"), Lng))
-                            {
-                                Restaurant.Location = FVector2D(Lat, Lng);
-                            }
-                        }
-                    }
-                    
-                    // Rating
-                    double Rating;
-                    if (ResultObject->TryGetNumberField(TEXT("rating"), Rating))
-                    {
-                        Restaurant.Rating = static_cast<float>(Rating);
-                    }
-                    
-                    // Price level
-                    int32 PriceLevel;
-                    if (ResultObject->TryGetNumberField(TEXT("price_level"), PriceLevel))
-                    {
-                        switch (PriceLevel)
-                        {
-                        case 1: Restaurant.PriceLevel = "$"; break;
-                        case 2: Restaurant.PriceLevel = "$$"; break;
-                        case 3: Restaurant.PriceLevel = "$$$"; break;
-                        case 4: Restaurant.PriceLevel = "$$$$"; break;
-                        default: Restaurant.PriceLevel = "N/A"; break;
-                        }
-                    }
-                    
-                    // Cuisine types
-                    const TArray<TSharedPtr<FJsonValue>>* TypesArray;
-                    if (ResultObject->TryGetArrayField(TEXT("types"), TypesArray))
-                    {
-                        for (const auto& TypeValue : *TypesArray)
-                        {
-                            FString Type = TypeValue->AsString();
-                            if (Type != "restaurant" && Type != "food" && Type != "establishment")
-                            {
-                                Restaurant.CuisineTypes.Add(Type);
-                            }
-                        }
-                    }
-                    
-                    Results.Add(Restaurant);
-                }
-            }
-        }
+        UE_LOG(LogTemp, Verbose, TEXT("Dropping stale response for search session %d"), SessionId);
+        return nullptr;
     }
     
-    return Results;
+    return *Session;
 }
 
-TArray<FRestaurantData> ARestaurantDataManager::ParseYelpResponse(const FString& ResponseBody)
+void ARestaurantDataManager::SendProviderRequest(FRestaurantSearchSession& Session, int32 CallIndex)
 {
-    TArray<FRestaurantData> Results;
+    FRestaurantProviderCall& Call = Session.ProviderCalls[CallIndex];
+    const FRestaurantProviderPolicy& Policy = Call.Provider->Policy;
+    
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = Call.Provider->CreateSearchRequest(Session.Location, Session.ProviderFilters, FString());
+    
+    Call.Requests.Add(Request);
+    Call.AttemptsInFlight++;
+    const int32 Attempt = ++Call.AttemptsSent;
+    Scheduler->Send(*Call.Provider, ERestaurantRequestPriority::Interactive, Request, Attempt > 1,
+        FHttpRequestCompleteDelegate::CreateUObject(this, &ARestaurantDataManager::OnProviderResponse, Session.SessionId, CallIndex));
     
-    TSharedPtr<FJsonObject> JsonObject;
-    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseBody);
+    UE_LOG(LogTemp, Log, TEXT("%s request sent for search session %d (attempt %d)"), *Call.Provider->GetName(), Session.SessionId, Attempt);
     
-    if (FJsonSerializer::Deserialize(Reader, JsonObject))
+    // Hedge: if this attempt is slow, race a second one against it
+    if (!Call.bComplete && Attempt < Policy.MaxAttempts && Policy.HedgeDelaySeconds > 0.0f)
     {
-        const TArray<TSharedPtr<FJsonValue>>* BusinessesArray;
-        if (JsonObject->TryGetArrayField(TEXT("businesses"), BusinessesArray))
-        {
-            for (const auto& BusinessValue : *BusinessesArray)
-            {
-                TSharedPtr<FJsonObject> BusinessObject = BusinessValue->AsObject();
-                if (BusinessObject.IsValid())
-                {
-                    FRestaurantData Restaurant;
-                    
-                    // Basic info
-                    BusinessObject->TryGetStringField(TEXT("name"), Restaurant.Name);
-                    BusinessObject->TryGetStringField(TEXT("id"), Restaurant.YelpBusinessId);
-                    BusinessObject->TryGetStringField(TEXT("phone"), Restaurant.PhoneNumber);
-                    BusinessObject->TryGetStringField(TEXT("url"), Restaurant.Website);
-                    
-                    // Location
-                    const TSharedPtr<FJsonObject>* CoordinatesObject;
-                    if (BusinessObject->TryGetObjectField(TEXT("coordinates"), CoordinatesObject))
-                    {
-                        double Lat, Lng;
-                        if ((*CoordinatesObject)->TryGetNumberField(TEXT("latitude"), Lat) &&
-                            (*CoordinatesObject)->TryGetNumberField(TEXT("longitude"), Lng))
-                        {
-                            Restaurant.Location = FVector2D(Lat, Lng);
-                        }
-                    }
-                    
-                    // Address
-                    const TSharedPtr<FJsonObject>* LocationObject;
-                    if (BusinessObject->TryGetObjectField(TEXT("location"), LocationObject))
-                    {
-                        FString Address;
-                        (*LocationObject)->TryGetStringField(TEXT("address1"), Address);
-                        Restaurant.Address = Address;
-                    }
-                    
-                    // Rating and reviews
-                    double Rating;
-                    if (BusinessObject->TryGetNumberField(TEXT("rating"), Rating))
-                    {
-                        Restaurant.Rating = static_cast<float>(Rating);
-                    }
-                    
-                    int32 ReviewCount;
-                    if (BusinessObject->TryGetNumberField(TEXT("review_count"), ReviewCount))
-                    {
-                        Restaurant.ReviewCount = ReviewCount;
-                    }
-                    
-                    // Price level
-                    FString Price;
-                    if (BusinessObject->TryGetStringField(TEXT("price"), Price))
-                    {
-                        Restaurant.PriceLevel = Price;
-                    }
-                    
-                    // Categories (cuisine types)
-                    const TArray<TSharedPtr<FJsonValue>>* CategoriesArray;
-                    if (BusinessObject->TryGetArrayField(TEXT("categories"), CategoriesArray))
-                    {
-                        for (const auto& CategoryValue : *CategoriesArray)
-                        {
-                            TSharedPtr<FJsonObject> CategoryObject = CategoryValue->AsObject();
-                            if (CategoryObject.IsValid())
-                            {
-                                FString Title;
-                                if (CategoryObject->TryGetStringField(TEXT("title"), Title))
-                                {
-                                    Restaurant.CuisineTypes.Add(Title);
-                                }
-                            }
-                        }
-                    }
-                    
-                    Results.Add(Restaurant);
-                }
-            }
-        }
+        GetWorldTimerManager().SetTimer(Call.HedgeTimer,
+            FTimerDelegate::CreateUObject(this, &ARestaurantDataManager::OnProviderHedge, Session.SessionId, CallIndex), Policy.HedgeDelaySeconds, false);
     }
-    
-    return Results;
 }
 
-void ARestaurantDataManager::MergeRestaurantData(FRestaurantData& Target, const FRestaurantData& Source)
+void ARestaurantDataManager::OnProviderHedge(int32 SessionId, int32 CallIndex)
 {
-    // Merge data from multiple sources, preferring more complete information
-    
-    if (Target.Rating == 0.0f && Source.Rating > 0.0f)
+    TSharedPtr<FRestaurantSearchSession> Session = FindLiveSession(SessionId);
+    if (!Session.IsValid())
     {
-        Target.Rating = Source.Rating;
+        return;
     }
     
-    if (Target.ReviewCount == 0 && Source.ReviewCount > 0)
+    const FRestaurantProviderCall& Call = Session->ProviderCalls[CallIndex];
+    if (Call.bResponded || Call.bComplete)
     {
-        Target.ReviewCount = Source.ReviewCount;
+        return;
     }
     
-    if (Target.PriceLevel.IsEmpty() && !Source.PriceLevel.IsEmpty())
+    // Hedges are extra load, a struggling provider does not get them
+    if (!HttpClient->TryRetry(Call.Provider->GetName()))
     {
-        Target.PriceLevel = Source.PriceLevel;
+        return;
     }
     
-    if (Target.PhoneNumber.IsEmpty() && !Source.PhoneNumber.IsEmpty())
+    UE_LOG(LogTemp, Log, TEXT("%s is slow to answer, sending a hedged request"), *Call.Provider->GetName());
+    SendProviderRequest(*Session, CallIndex);
+}
+
+void ARestaurantDataManager::OnProviderRetry(int32 SessionId, int32 CallIndex)
+{
+    TSharedPtr<FRestaurantSearchSession> Session = FindLiveSession(SessionId);
+    if (!Session.IsValid())
     {
-        Target.PhoneNumber = Source.PhoneNumber;
+        return;
     }
     
-    if (Target.Website.IsEmpty() && !Source.Website.IsEmpty())
+    const FRestaurantProviderCall& Call = Session->ProviderCalls[CallIndex];
+    if (!Call.bResponded && !Call.bComplete)
     {
-        Target.Website = Source.Website;
+        SendProviderRequest(*Session, CallIndex);
     }
-    
-    // Merge cuisine types
-    for (const FString& CuisineType : Source.CuisineTypes)
+}
+
+void ARestaurantDataManager::OnProviderResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, int32 SessionId, int32 CallIndex)
+{
+    TSharedPtr<FRestaurantSearchSession> Session = FindLiveSession(SessionId);
+    if (!Session.IsValid())
     {
-        Target.CuisineTypes.AddUnique(CuisineType);
+        return;
     }
     
-    // Store source IDs
-    if (!Source.YelpBusinessId.IsEmpty())
+    // Another attempt already won, or the deadline gave up on this provider
+    FRestaurantProviderCall& Call = Session->ProviderCalls[CallIndex];
+    if (Call.bResponded || Call.bComplete)
     {
-        Target.YelpBusinessId = Source.YelpBusinessId;
+        return;
     }
     
-    if (!Source.GooglePlaceId.IsEmpty())
+    Call.AttemptsInFlight--;
+    
+    const ERestaurantHttpResult Result = FRestaurantHttpClient::Classify(Response, bWasSuccessful);
+    if (Result != ERestaurantHttpResult::Success)
     {
-        Target.GooglePlaceId = Source.GooglePlaceId;
+        // A hedged attempt may still answer
+        if (Result == ERestaurantHttpResult::RetryableFailure && Call.AttemptsInFlight > 0)
+        {
+            return;
+        }
+        
+        // Back off before retrying, a provider that just failed is likely still busy
+        const FRestaurantProviderPolicy& Policy = Call.Provider->Policy;
+        if (Result == ERestaurantHttpResult::RetryableFailure && Call.AttemptsSent < Policy.MaxAttempts &&
+            HttpClient->TryRetry(Call.Provider->GetName()))
+        {
+            GetWorldTimerManager().ClearTimer(Call.HedgeTimer);
+            GetWorldTimerManager().SetTimer(Call.RetryTimer,
+                FTimerDelegate::CreateUObject(this, &ARestaurantDataManager::OnProviderRetry, SessionId, CallIndex),
+                FRestaurantHttpClient::GetRetryDelay(Policy, Call.AttemptsSent), false);
+            return;
+        }
+        
+        const FString Error = Response.IsValid() ? FString::Printf(TEXT("Request failed with HTTP %d"), Response->GetResponseCode()) : FString(TEXT("Request failed"));
+        HandleAPIError(Call.Provider->GetName(), Error);
+        Session->bPartial = true;
+        
+        // Attempts still in flight after a hard failure are not needed any more
+        for (const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Other : Call.Requests)
+        {
+            Scheduler->Cancel(Other);
+        }
+        Call.Requests.Empty();
+        GetWorldTimerManager().ClearTimer(Call.HedgeTimer);
+        OnProviderParsed(SessionId, CallIndex, false, TArray<FRestaurantData>(), FString());
+        return;
     }
-}
-
-void ARestaurantDataManager::SortByRelevance(TArray<FRestaurantData>& Restaurants)
-{
-    Restaurants.Sort([](const FRestaurantData& A, const FRestaurantData& B)
+    
+    // First answer wins, abort the attempts it raced against
+    Call.bResponded = true;
+    GetWorldTimerManager().ClearTimer(Call.HedgeTimer);
+    for (const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Other : Call.Requests)
     {
-        // Sort by rating first, then by review count
-        if (FMath::Abs(A.Rating - B.Rating) > 0.1f)
+        if (Request.Get() != &Other.Get())
         {
-            return A.Rating > B.Rating;
+            Scheduler->Cancel(Other);
         }
+    }
+    Call.Requests.Empty();
+    
+    // Parse the raw UTF-8 body on a worker thread, only the finished rows come back to the game thread
+    TWeakObjectPtr<ARestaurantDataManager> WeakThis(this);
+    TSharedPtr<FRestaurantProvider> Provider = Call.Provider;
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Provider, Response, SessionId, CallIndex]()
+    {
+        TArray<FRestaurantData> ProviderResults;
+        FString NextPageToken;
+        const bool bParsed = Provider->ParseSearchResponse(Response->GetContent(), FString(), ProviderResults, NextPageToken);
+        const bool bRateLimited = !bParsed && Provider->IsRateLimitResponse(Response->GetContent());
         
-        return A.ReviewCount > B.ReviewCount;
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Provider, SessionId, CallIndex, bParsed, bRateLimited, ProviderResults = MoveTemp(ProviderResults), NextPageToken = MoveTemp(NextPageToken)]()
+        {
+            if (ARestaurantDataManager* This = WeakThis.Get())
+            {
+                if (bRateLimited)
+                {
+                    This->Scheduler->ReportRateLimited(*Provider);
+                    This->HandleAPIError(Provider->GetName(), "Over query limit");
+                }
+                else if (!bParsed)
+                {
+                    This->HandleAPIError(Provider->GetName(), "Malformed or rejected response");
+                }
+                This->OnProviderParsed(SessionId, CallIndex, bParsed, ProviderResults, NextPageToken);
+            }
+        });
     });
 }
 
-FString ARestaurantDataManager::BuildRestaurantContext(const TArray<FRestaurantData>& Restaurants)
+void ARestaurantDataManager::OnProviderParsed(int32 SessionId, int32 CallIndex, bool bSucceeded, const TArray<FRestaurantData>& ProviderResults, const FString& NextPageToken)
 {
-    FString Context = TEXT("Available restaurants in the area:\n\n");
+    TSharedPtr<FRestaurantSearchSession> Session = FindLiveSession(SessionId);
+    if (!Session.IsValid())
+    {
+        return;
+    }
     
-    for (int32 i = 0; i < FMath::Min(Restaurants.Num(), 10); i++)
+    FRestaurantProviderCall& Call = Session->ProviderCalls[CallIndex];
+    if (Call.bComplete)
     {
-        const FRestaurantData& Restaurant = Restaurants[i];
-        
-        Context += FString::Printf(TEXT("%d. %s\n"), i + 1, *Restaurant.Name);
-        
-        if (!Restaurant.CuisineTypes.IsEmpty())
+        return;
+    }
+    Call.bComplete = true;
+    Call.bExhaustive = bSucceeded && ProviderResults.Num() < Call.Provider->GetPageSize() && NextPageToken.IsEmpty();
+    Call.PagesFetched = 1;
+    Call.NextPageToken = NextPageToken;
+    if (!bSucceeded)
+    {
+        Session->bPartial = true;
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("%s returned %d results"), *Call.Provider->GetName(), ProviderResults.Num());
+    
+    AddSessionResults(*Session, ProviderResults);
+    
+    // Check if all requests are complete
+    CheckRequestsComplete(SessionId);
+    
+    // Still waiting on other providers: let subscribers start with what is here
+    if (bProgressiveResults && !Session->bCancelled && ActiveSessions.Contains(SessionId))
+    {
+        // Indexed, a handler may cancel its search and detach from this session
+        for (int32 i = 0; i < Session->Subscribers.Num(); i++)
         {
-            Context += FString::Printf(TEXT("   Cuisine: %s\n"), *FString::Join(Restaurant.CuisineTypes, TEXT(", ")));
+            if (!Session->Subscribers[i].bRevalidation)
+            {
+                BroadcastDelta(*Session, Session->Subscribers[i], false);
+            }
         }
-        
-        if (!Restaurant.PriceLevel.IsEmpty())
+    }
+}
+
+void ARestaurantDataManager::OnSearchDeadline(int32 SessionId)
+{
+    TSharedPtr<FRestaurantSearchSession> Session = FindLiveSession(SessionId);
+    if (!Session.IsValid())
+    {
+        return;
+    }
+    
+    // Answer with what has been merged so far
+    for (FRestaurantProviderCall& Call : Session->ProviderCalls)
+    {
+        if (!Call.bComplete)
         {
-            Context += FString::Printf(TEXT("   Price: %s\n"), *Restaurant.PriceLevel);
+            UE_LOG(LogTemp, Warning, TEXT("%s missed the %.1fs deadline of search session %d"), *Call.Provider->GetName(), SearchDeadlineSeconds, SessionId);
+            Call.bComplete = true;
+            Session->bPartial = true;
+            CancelProviderCall(Call);
         }
-        
-        if (Restaurant.Rating > 0.0f)
+    }
+    
+    CheckRequestsComplete(SessionId);
+}
+
+void ARestaurantDataManager::AddSessionResults(FRestaurantSearchSession& Session, const TArray<FRestaurantData>& Results)
+{
+    // Providers may answer in any order, so every batch goes through the resolver
+    for (const FRestaurantData& Restaurant : Results)
+    {
+        const int32 MatchIndex = Session.Resolver.FindMatch(Restaurant);
+        if (MatchIndex != INDEX_NONE)
         {
-            Context += FString::Printf(TEXT("   Rating: %.1f/5.0"), Restaurant.Rating);
-            if (Restaurant.ReviewCount > 0)
-            {
-                Context += FString::Printf(TEXT(" (%d reviews)"), Restaurant.ReviewCount);
-            }
-            Context += TEXT("\n");
+            MergeRestaurantData(Session.Results[MatchIndex], Restaurant);
+            Session.Resolver.UpdateIds(Session.Results[MatchIndex], MatchIndex);
         }
-        
-        if (!Restaurant.Address.IsEmpty())
+        else
         {
-            Context += FString::Printf(TEXT("   Address: %s\n"), *Restaurant.Address);
+            const int32 NewIndex = Session.Results.Add(Restaurant);
+            Session.Resolver.Add(Restaurant, NewIndex);
         }
-        
-        Context += TEXT("\n");
     }
-    
-    return Context;
 }
 
-bool ARestaurantDataManager::IsCacheValid(const FString& CacheKey, float MaxAgeMinutes)
+void ARestaurantDataManager::StartPagePrefetch(TSharedRef<FRestaurantSearchSession> Session)
 {
-    if (!RestaurantCache.Contains(CacheKey) || !CacheTimestamps.Contains(CacheKey))
+    bool bAnyPages = false;
+    for (int32 CallIndex = 0; CallIndex < Session->ProviderCalls.Num(); CallIndex++)
     {
-        return false;
+        FRestaurantProviderCall& Call = Session->ProviderCalls[CallIndex];
+        if (!Call.NextPageToken.IsEmpty() && Call.PagesFetched < Call.Provider->Policy.MaxPages)
+        {
+            SchedulePageFetch(*Session, CallIndex, Call.Provider->GetPageTokenDelaySeconds());
+            bAnyPages = true;
+        }
     }
     
-    FDateTime CacheTime = CacheTimestamps[CacheKey];
-    FDateTime Now = FDateTime::Now();
-    FTimespan Age = Now - CacheTime;
-    
-    return Age.GetTotalMinutes() < MaxAgeMinutes;
+    // The finished search stays around, later pages are merged into its results
+    if (bAnyPages)
+    {
+        PrefetchSessions.Add(Session->SessionId, Session);
+    }
 }
 
-FString ARestaurantDataManager::GenerateCacheKey(FVector2D Location, const FSearchFilters& Filters)
+void ARestaurantDataManager::SchedulePageFetch(FRestaurantSearchSession& Session, int32 CallIndex, float DelaySeconds)
 {
-    return FString::Printf(TEXT("%.4f_%.4f_%s_%f_%f"), 
-        Location.X, Location.Y, 
-        *FString::Join(Filters.CuisineTypes, TEXT(",")),
-        Filters.MinRating, 
-        Filters.MaxDistance);
+    FRestaurantProviderCall& Call = Session.ProviderCalls[CallIndex];
+    Call.bPrefetching = true;
+    
+    // A zero rate would clear the timer instead of firing next tick
+    GetWorldTimerManager().SetTimer(Call.PageTimer,
+        FTimerDelegate::CreateUObject(this, &ARestaurantDataManager::FetchNextPage, Session.SessionId, CallIndex),
+        FMath::Max(DelaySeconds, PagePrefetchIntervalSeconds), false);
 }
 
-void ARestaurantDataManager::ClearCache()
+void ARestaurantDataManager::FetchNextPage(int32 SessionId, int32 CallIndex)
 {
-    RestaurantCache.Empty();
-    CacheTimestamps.Empty();
+    TSharedPtr<FRestaurantSearchSession>* Session = PrefetchSessions.Find(SessionId);
+    if (!Session)
+    {
+        return;
+    }
+    
+    // Prefetching is low priority: wait while searches someone is waiting on are in flight
+    if (!ActiveSessions.IsEmpty())
+    {
+        SchedulePageFetch(**Session, CallIndex, PagePrefetchIntervalSeconds);
+        return;
+    }
+    
+    FRestaurantProviderCall& Call = (*Session)->ProviderCalls[CallIndex];
+    if (!Scheduler->IsAvailable(*Call.Provider, ERestaurantRequestPriority::Prefetch))
+    {
+        OnProviderPageParsed(SessionId, CallIndex, false, TArray<FRestaurantData>(), FString());
+        return;
+    }
+    
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = Call.Provider->CreateSearchRequest((*Session)->Location, (*Session)->ProviderFilters, Call.NextPageToken);
+    Call.Requests.Add(Request);
+    Scheduler->Send(*Call.Provider, ERestaurantRequestPriority::Prefetch, Request, false,
+        FHttpRequestCompleteDelegate::CreateUObject(this, &ARestaurantDataManager::OnProviderPageResponse, SessionId, CallIndex));
+    
+    UE_LOG(LogTemp, Verbose, TEXT("%s page %d prefetch sent for search %d"), *Call.Provider->GetName(), Call.PagesFetched + 1, SessionId);
+}
+
+void ARestaurantDataManager::OnProviderPageResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, int32 SessionId, int32 CallIndex)
+{
+    TSharedPtr<FRestaurantSearchSession>* Session = PrefetchSessions.Find(SessionId);
+    if (!Session || !(*Session)->ProviderCalls[CallIndex].bPrefetching)
+    {
+        return;
+    }
+    
+    FRestaurantProviderCall& Call = (*Session)->ProviderCalls[CallIndex];
+    Call.Requests.Empty();
+    
+    // Nobody is waiting on a prefetch, a failed page just ends the pagination
+    if (FRestaurantHttpClient::Classify(Response, bWasSuccessful) != ERestaurantHttpResult::Success)
+    {
+        UE_LOG(LogTemp, Log, TEXT("%s page prefetch failed, stopping pagination"), *Call.Provider->GetName());
+        OnProviderPageParsed(SessionId, CallIndex, false, TArray<FRestaurantData>(), FString());
+        return;
+    }
+    
+    TWeakObjectPtr<ARestaurantDataManager> WeakThis(this);
+    TSharedPtr<FRestaurantProvider> Provider = Call.Provider;
+    const FString PageToken = Call.NextPageToken;
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Provider, Response, PageToken, SessionId, CallIndex]()
+    {
+        TArray<FRestaurantData> PageResults;
+        FString NextPageToken;
+        const bool bParsed = Provider->ParseSearchResponse(Response->GetContent(), PageToken, PageResults, NextPageToken);
+        const bool bRateLimited = !bParsed && Provider->IsRateLimitResponse(Response->GetContent());
+        if (!bParsed)
+        {
+            PageResults.Reset();
+            NextPageToken.Reset();
+        }
+        
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Provider, SessionId, CallIndex, bParsed, bRateLimited, PageResults = MoveTemp(PageResults), NextPageToken = MoveTemp(NextPageToken)]()
+        {
+            if (ARestaurantDataManager* This = WeakThis.Get())
+            {
+                if (bRateLimited)
+                {
+                    This->Scheduler->ReportRateLimited(*Provider);
+                }
+                This->OnProviderPageParsed(SessionId, CallIndex, bParsed, PageResults, NextPageToken);
+            }
+        });
+    });
+}
+
+void ARestaurantDataManager::OnProviderPageParsed(int32 SessionId, int32 CallIndex, bool bSucceeded, const TArray<FRestaurantData>& PageResults, const FString& NextPageToken)
+{
+    TSharedPtr<FRestaurantSearchSession> Session = PrefetchSessions.FindRef(SessionId);
+    if (!Session.IsValid() || !Session->ProviderCalls[CallIndex].bPrefetching)
+    {
+        return;
+    }
+    
+    FRestaurantProviderCall& Call = Session->ProviderCalls[CallIndex];
+    Call.PagesFetched++;
+    Call.NextPageToken = NextPageToken;
+    Call.bPrefetching = false;
+    Call.bExhaustive = bSucceeded && PageResults.Num() < Call.Provider->GetPageSize() && NextPageToken.IsEmpty();
+    
+    if (!PageResults.IsEmpty())
+    {
+        const int32 KnownResults = Session->Results.Num();
+        AddSessionResults(*Session, PageResults);
+        
+        UE_LOG(LogTemp, Log, TEXT("%s page %d added %d restaurants to search %d"),
+            *Call.Provider->GetName(), Call.PagesFetched, Session->Results.Num() - KnownResults, SessionId);
+        
+        UpdateCompletedSubscribers(*Session);
+    }
+    
+    // Each page extends the cached answer, the last one of every provider makes it complete
+    if (!Session->bPartial && Session->CacheGeneration == CacheGeneration)
+    {
+        StoreSessionResults(*Session);
+    }
+    
+    if (!Call.NextPageToken.IsEmpty() && Call.PagesFetched < Call.Provider->Policy.MaxPages)
+    {
+        SchedulePageFetch(*Session, CallIndex, Call.Provider->GetPageTokenDelaySeconds());
+    }
+    
+    const bool bStillPrefetching = Session->ProviderCalls.ContainsByPredicate([](const FRestaurantProviderCall& Other)
+    {
+        return Other.bPrefetching;
+    });
+    if (!bStillPrefetching)
+    {
+        PrefetchSessions.Remove(SessionId);
+    }
+}
+
+void ARestaurantDataManager::CheckRequestsComplete(int32 SessionId)
+{
+    TSharedPtr<FRestaurantSearchSession> Session = FindLiveSession(SessionId);
+    if (!Session.IsValid())
+    {
+        return;
+    }
+    
+    for (const FRestaurantProviderCall& Call : Session->ProviderCalls)
+    {
+        if (!Call.bComplete)
+        {
+            return;
+        }
+    }
+    
+    GetWorldTimerManager().ClearTimer(Session->DeadlineTimer);
+    ActiveSessions.Remove(SessionId);
+    InFlightSearches.RemoveSingle(Session->QueryClass, SessionId);
+    
+    // A refresh that came back empty most likely failed, keep serving the stale tiles
+    const bool bOnlyRevalidating = !Session->Subscribers.ContainsByPredicate([](const FRestaurantSearchSubscriber& Subscriber)
+    {
+        return !Subscriber.bRevalidation;
+    });
+    // Partial answers are delivered but not cached, so the next search asks every provider again.
+    // Neither is a search that was already running when the cache was cleared.
+    const bool bCacheable = Session->CacheGeneration == CacheGeneration;
+    if (!Session->bPartial && bCacheable && (!Session->Results.IsEmpty() || !bOnlyRevalidating))
+    {
+        // Cache the full superset, every subscriber narrows it down to what it asked for
+        StoreSessionResults(*Session);
+        StartPagePrefetch(Session.ToSharedRef());
+    }
+    
+    // Details fetched for earlier searches fill in hours and contacts before filtering
+    ApplyCachedDetails(Session->Results);
+    
+    for (FRestaurantSearchSubscriber& Subscriber : Session->Subscribers)
+    {
+        // Subscribers that saw partial results get the last changes as a delta too
+        if (!Subscriber.bRevalidation && !Subscriber.DeliveredHashes.IsEmpty())
+        {
+            BroadcastDelta(*Session, Subscriber, true);
+        }
+        
+        TArray<FRestaurantData> Results = Session->Results;
+        ApplyLocalFilters(Results, Subscriber.Location, Subscriber.Filters);
+        
+        RankResults(Results, Subscriber.Filters);
+        
+        if (!Subscriber.bRevalidation)
+        {
+            if (bCacheable)
+            {
+                // An attached subscriber may sit off-centre, its coverage shrinks accordingly
+                const float CoveredRadius = Session->ProviderFilters.MaxDistance - static_cast<float>(FRestaurantGeo::HaversineMeters(Session->Location, Subscriber.Location));
+                RetainResultSet(Subscriber.SessionId, MakeShared<FRestaurantResultSet>(Subscriber.Location, Subscriber.Filters, CoveredRadius, Session->Results));
+            }
+            
+            Subscriber.DeliveredFingerprint = ComputeResultFingerprint(Results);
+            SessionSearches.Remove(Subscriber.SessionId);
+            CompleteSession(Subscriber.SessionId, Results);
+        }
+        else if (Session->Results.IsEmpty() || Session->bPartial)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Background refresh for search session %d was incomplete, keeping the cached results"), Subscriber.SessionId);
+        }
+        else if (ComputeResultFingerprint(Results) != Subscriber.DeliveredFingerprint)
+        {
+            UE_LOG(LogTemp, Log, TEXT("Search session %d revalidated with changed results"), Subscriber.SessionId);
+            Subscriber.DeliveredFingerprint = ComputeResultFingerprint(Results);
+            OnSearchRevalidated.Broadcast(Subscriber.SessionId, Results);
+        }
+    }
+}
+
+void ARestaurantDataManager::StoreSessionResults(const FRestaurantSearchSession& Session)
+{
+    // Only complete results fill tiles, a capped answer only stands for its own circle
+    if (Session.IsExhaustive())
+    {
+        TileCache.Store(Session.Location, Session.ProviderFilters.MaxDistance, Session.ProviderFilters, Session.Results);
+    }
+    else
+    {
+        TileCache.StoreCapped(Session.Location, Session.ProviderFilters.MaxDistance, Session.ProviderFilters, Session.Results);
+    }
+}
+
+void ARestaurantDataManager::UpdateCompletedSubscribers(FRestaurantSearchSession& Session)
+{
+    // Later pages reach the callers of the search, not just the tile cache
+    ApplyCachedDetails(Session.Results);
+    const bool bRetain = Session.CacheGeneration == CacheGeneration;
+    
+    for (FRestaurantSearchSubscriber& Subscriber : Session.Subscribers)
+    {
+        TArray<FRestaurantData> Results = Session.Results;
+        ApplyLocalFilters(Results, Subscriber.Location, Subscriber.Filters);
+        RankResults(Results, Subscriber.Filters);
+        
+        if (bRetain && !Subscriber.bRevalidation)
+        {
+            const float CoveredRadius = Session.ProviderFilters.MaxDistance - static_cast<float>(FRestaurantGeo::HaversineMeters(Session.Location, Subscriber.Location));
+            RetainResultSet(Subscriber.SessionId, MakeShared<FRestaurantResultSet>(Subscriber.Location, Subscriber.Filters, CoveredRadius, Session.Results));
+        }
+        
+        const uint32 Fingerprint = ComputeResultFingerprint(Results);
+        if (Fingerprint != Subscriber.DeliveredFingerprint)
+        {
+            UE_LOG(LogTemp, Log, TEXT("Search session %d updated from prefetched pages"), Subscriber.SessionId);
+            Subscriber.DeliveredFingerprint = Fingerprint;
+            OnSearchRevalidated.Broadcast(Subscriber.SessionId, Results);
+        }
+    }
+}
+
+void ARestaurantDataManager::CompleteSession(int32 SessionId, const TArray<FRestaurantData>& Results)
+{
+    OnSearchComplete.Broadcast(SessionId, Results);
+    
+    // Older overlapping searches (prefetches, superseded refinements) only report through OnSearchComplete
+    if (SessionId == LatestSessionId)
+    {
+        OnRestaurantsFound.Broadcast(Results);
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("Search session %d complete. Found %d restaurants"), SessionId, Results.Num());
+    
+    PrefetchDetails(Results);
+    
+    // The cards of the top results show their first photo right away
+    for (int32 i = 0; i < FMath::Min(Results.Num(), PhotoPrefetchCount); i++)
+    {
+        if (!Results[i].PhotoURLs.IsEmpty())
+        {
+            Photos->Request(Results[i].PhotoURLs[0]);
+        }
+    }
+}
+
+void ARestaurantDataManager::BroadcastDelta(const FRestaurantSearchSession& Session, FRestaurantSearchSubscriber& Subscriber, bool bFinal)
+{
+    // Result ids are indices into the session results, which only ever grow
+    TArray<FRestaurantData> Candidates = Session.Results;
+    FRestaurantFilterColumns Columns;
+    Columns.Pack(Candidates, Subscriber.Location);
+    
+    TArray<int32> Ids;
+    FRestaurantFilter(Subscriber.Filters, Subscriber.Location).Evaluate(Columns, Ids);
+    
+    TArray<FRestaurantData> Rows;
+    Rows.Reserve(Ids.Num());
+    for (int32 ResultId : Ids)
+    {
+        Rows.Add(MoveTemp(Candidates[ResultId]));
+    }
+    
+    // Same ranking as the final list, so RankedIds does not reshuffle on completion
+    TArray<int32> Order;
+    Ranker->Rank(Rows, Subscriber.Filters, RankedResultCount, Order);
+    
+    FRestaurantResultDelta Delta;
+    Delta.SessionId = Subscriber.SessionId;
+    Delta.bFinal = bFinal;
+    
+    TSet<int32> Current;
+    for (int32 RowIndex : Order)
+    {
+        const int32 ResultId = Ids[RowIndex];
+        const uint32 Hash = ComputeRestaurantHash(Rows[RowIndex]);
+        Delta.RankedIds.Add(ResultId);
+        Current.Add(ResultId);
+        
+        uint32* DeliveredHash = Subscriber.DeliveredHashes.Find(ResultId);
+        if (!DeliveredHash || *DeliveredHash != Hash)
+        {
+            FRestaurantDeltaEntry& Entry = DeliveredHash ? Delta.Updated.AddDefaulted_GetRef() : Delta.Added.AddDefaulted_GetRef();
+            Entry.ResultId = ResultId;
+            Entry.Restaurant = Rows[RowIndex];
+            Subscriber.DeliveredHashes.Add(ResultId, Hash);
+        }
+    }
+    
+    for (auto It = Subscriber.DeliveredHashes.CreateIterator(); It; ++It)
+    {
+        if (!Current.Contains(It.Key()))
+        {
+            Delta.RemovedIds.Add(It.Key());
+            It.RemoveCurrent();
+        }
+    }
+    
+    if (!bFinal && Delta.Added.IsEmpty() && Delta.Updated.IsEmpty() && Delta.RemovedIds.IsEmpty())
+    {
+        return;
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("Search session %d delta: %d added, %d updated, %d removed"),
+        Subscriber.SessionId, Delta.Added.Num(), Delta.Updated.Num(), Delta.RemovedIds.Num());
+    OnSearchResultsDelta.Broadcast(Delta);
+}
+
+uint32 ARestaurantDataManager::ComputeRestaurantHash(const FRestaurantData& Restaurant)
+{
+    // Fields a merge can fill in or change
+    uint32 Hash = GetTypeHash(Restaurant.Name);
+    Hash = HashCombine(Hash, GetTypeHash(Restaurant.Rating));
+    Hash = HashCombine(Hash, GetTypeHash(Restaurant.ReviewCount));
+    Hash = HashCombine(Hash, GetTypeHash(Restaurant.PriceLevel));
+    Hash = HashCombine(Hash, GetTypeHash(Restaurant.PhoneNumber));
+    Hash = HashCombine(Hash, GetTypeHash(Restaurant.Website));
+    Hash = HashCombine(Hash, GetTypeHash(Restaurant.GooglePlaceId));
+    Hash = HashCombine(Hash, GetTypeHash(Restaurant.YelpBusinessId));
+    for (const FString& Cuisine : Restaurant.CuisineTypes)
+    {
+        Hash = HashCombine(Hash, GetTypeHash(Cuisine));
+    }
+    
+    return Hash;
+}
+
+void ARestaurantDataManager::CompleteSessionNextTick(int32 SessionId, const TArray<FRestaurantData>& Results)
+{
+    // Callers need the returned session id before its results can be matched up
+    TWeakObjectPtr<ARestaurantDataManager> WeakThis(this);
+    GetWorldTimerManager().SetTimerForNextTick([WeakThis, SessionId, Results]()
+    {
+        if (WeakThis.IsValid())
+        {
+            WeakThis->CompleteSession(SessionId, Results);
+        }
+    });
+}
+
+void ARestaurantDataManager::MergeRestaurantData(FRestaurantData& Target, const FRestaurantData& Source)
+{
+    // Merge data from multiple sources, preferring more complete information
+    
+    if (Target.Rating == 0.0f && Source.Rating > 0.0f)
+    {
+        Target.Rating = Source.Rating;
+    }
+    
+    if (Target.ReviewCount == 0 && Source.ReviewCount > 0)
+    {
+        Target.ReviewCount = Source.ReviewCount;
+    }
+    
+    if (Target.PriceLevel.IsEmpty() && !Source.PriceLevel.IsEmpty())
+    {
+        Target.PriceLevel = Source.PriceLevel;
+    }
+    
+    if (Target.PhoneNumber.IsEmpty() && !Source.PhoneNumber.IsEmpty())
+    {
+        Target.PhoneNumber = Source.PhoneNumber;
+    }
+    
+    if (Target.Website.IsEmpty() && !Source.Website.IsEmpty())
+    {
+        Target.Website = Source.Website;
+    }
+    
+    Target.bAcceptsReservations |= Source.bAcceptsReservations;
+    Target.bDelivery |= Source.bDelivery;
+    Target.bTakeout |= Source.bTakeout;
+    
+    if (!Target.Hours.OpenSlots.bKnown && Source.Hours.OpenSlots.bKnown)
+    {
+        Target.Hours = Source.Hours;
+    }
+    else if (!Target.Hours.OpenSlots.bKnown && Source.Hours.OpenSlots.OpenNowObservedAt > Target.Hours.OpenSlots.OpenNowObservedAt)
+    {
+        Target.Hours.OpenSlots.SetOpenNow(Source.Hours.OpenSlots.bOpenNow, Source.Hours.OpenSlots.OpenNowObservedAt);
+    }
+    
+    if (!Target.Hours.bHasUtcOffset && Source.Hours.bHasUtcOffset)
+    {
+        Target.Hours.UtcOffsetMinutes = Source.Hours.UtcOffsetMinutes;
+        Target.Hours.bHasUtcOffset = true;
+    }
+    
+    for (const FString& PhotoURL : Source.PhotoURLs)
+    {
+        Target.PhotoURLs.AddUnique(PhotoURL);
+    }
+    
+    // Merge cuisine types
+    for (const FString& CuisineType : Source.CuisineTypes)
+    {
+        Target.CuisineTypes.AddUnique(CuisineType);
+    }
+    
+    // Store source IDs
+    if (!Source.YelpBusinessId.IsEmpty())
+    {
+        Target.YelpBusinessId = Source.YelpBusinessId;
+    }
+    
+    if (!Source.GooglePlaceId.IsEmpty())
+    {
+        Target.GooglePlaceId = Source.GooglePlaceId;
+    }
+}
+
+void ARestaurantDataManager::RankResults(TArray<FRestaurantData>& Restaurants, const FSearchFilters& Filters)
+{
+    Ranker->RankInPlace(Restaurants, Filters, RankedResultCount);
+}
+
+TSharedPtr<FRestaurantProvider> ARestaurantDataManager::FindProvider(const FString& Name) const
+{
+    for (const TSharedPtr<FRestaurantProvider>& Provider : Providers)
+    {
+        if (Provider->GetName() == Name)
+        {
+            return Provider;
+        }
+    }
+    return nullptr;
+}
+
+void ARestaurantDataManager::GetRestaurantDetails(const FString& RestaurantId, const FString& APISource)
+{
+    TSharedPtr<FRestaurantProvider> Provider = FindProvider(APISource);
+    if (!Provider.IsValid() || !Provider->IsConfigured())
+    {
+        HandleAPIError(APISource, "No details provider available");
+        return;
+    }
+    
+    if (const FRestaurantData* Cached = DetailsCache.Find(FRestaurantDetailsCache::MakeKey(APISource, RestaurantId)))
+    {
+        // Same ordering as a fetched answer: never from inside the call
+        TWeakObjectPtr<ARestaurantDataManager> WeakThis(this);
+        GetWorldTimerManager().SetTimerForNextTick([WeakThis, Details = *Cached]()
+        {
+            if (WeakThis.IsValid())
+            {
+                WeakThis->OnRestaurantDetailsReceived.Broadcast(Details);
+            }
+        });
+        return;
+    }
+    
+    QueueDetailsFetch(Provider.ToSharedRef(), RestaurantId, true);
+}
+
+void ARestaurantDataManager::PrefetchDetails(const TArray<FRestaurantData>& Restaurants)
+{
+    for (int32 i = 0; i < FMath::Min(Restaurants.Num(), DetailsPrefetchCount); i++)
+    {
+        const FRestaurantData& Restaurant = Restaurants[i];
+        for (const TSharedPtr<FRestaurantProvider>& Provider : Providers)
+        {
+            const FString Id = Provider->GetDetailsId(Restaurant);
+            if (Id.IsEmpty() || !Provider->IsConfigured())
+            {
+                continue;
+            }
+            
+            // Also covers places whose details simply have no hours, those are not asked again
+            if (!DetailsCache.Find(FRestaurantDetailsCache::MakeKey(Provider->GetName(), Id)))
+            {
+                QueueDetailsFetch(Provider.ToSharedRef(), Id, false);
+            }
+            break;
+        }
+    }
+}
+
+void ARestaurantDataManager::QueueDetailsFetch(TSharedRef<FRestaurantProvider> Provider, const FString& Id, bool bRequested)
+{
+    const FString Key = FRestaurantDetailsCache::MakeKey(Provider->GetName(), Id);
+    
+    if (FDetailsFetch* InFlight = DetailsInFlight.Find(Key))
+    {
+        InFlight->bRequested |= bRequested;
+        return;
+    }
+    
+    // Explicit requests overtake prefetches still waiting for a slot
+    const int32 QueuedIndex = DetailsQueue.IndexOfByPredicate([&Key](const FDetailsFetch& Fetch) { return Fetch.Key == Key; });
+    if (QueuedIndex != INDEX_NONE)
+    {
+        if (bRequested && !DetailsQueue[QueuedIndex].bRequested)
+        {
+            FDetailsFetch Fetch = MoveTemp(DetailsQueue[QueuedIndex]);
+            Fetch.bRequested = true;
+            DetailsQueue.RemoveAt(QueuedIndex);
+            DetailsQueue.Insert(MoveTemp(Fetch), 0);
+        }
+        return;
+    }
+    
+    FDetailsFetch Fetch;
+    Fetch.Key = Key;
+    Fetch.Id = Id;
+    Fetch.Provider = Provider;
+    Fetch.bRequested = bRequested;
+    if (bRequested)
+    {
+        DetailsQueue.Insert(MoveTemp(Fetch), 0);
+    }
+    else
+    {
+        DetailsQueue.Add(MoveTemp(Fetch));
+    }
+    
+    PumpDetailsFetches();
+}
+
+void ARestaurantDataManager::PumpDetailsFetches()
+{
+    // Bounded so a page of prefetches cannot crowd out searches at the provider
+    while (DetailsInFlight.Num() < MaxConcurrentDetailsRequests && !DetailsQueue.IsEmpty())
+    {
+        FDetailsFetch Fetch = MoveTemp(DetailsQueue[0]);
+        DetailsQueue.RemoveAt(0);
+        
+        const TSharedPtr<FRestaurantProvider> Provider = Fetch.Provider;
+        Fetch.Request = Scheduler->IsAvailable(*Provider, ERestaurantRequestPriority::Details) ? Provider->CreateDetailsRequest(Fetch.Id) : nullptr;
+        if (!Fetch.Request.IsValid())
+        {
+            if (Fetch.bRequested)
+            {
+                HandleAPIError(Provider->GetName(), "Details unavailable");
+            }
+            continue;
+        }
+        
+        const TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = Fetch.Request.ToSharedRef();
+        const FString Key = Fetch.Key;
+        DetailsInFlight.Add(Key, MoveTemp(Fetch));
+        Scheduler->Send(*Provider, ERestaurantRequestPriority::Details, Request, false,
+            FHttpRequestCompleteDelegate::CreateUObject(this, &ARestaurantDataManager::OnRestaurantDetailsResponse, Key));
+    }
+}
+
+void ARestaurantDataManager::OnRestaurantDetailsResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, FString Key)
+{
+    FDetailsFetch Fetch;
+    if (!DetailsInFlight.RemoveAndCopyValue(Key, Fetch))
+    {
+        return;
+    }
+    
+    const FString ProviderName = Fetch.Provider->GetName();
+    if (FRestaurantHttpClient::Classify(Response, bWasSuccessful) != ERestaurantHttpResult::Success)
+    {
+        // Prefetches fail quietly, the restaurant just shows what the search returned
+        const FString Error = Response.IsValid() ? FString::Printf(TEXT("Details request failed with HTTP %d"), Response->GetResponseCode()) : FString(TEXT("Details request failed"));
+        if (Fetch.bRequested)
+        {
+            HandleAPIError(ProviderName, Error);
+        }
+        else
+        {
+            UE_LOG(LogTemp, Log, TEXT("%s %s"), *ProviderName, *Error);
+        }
+        PumpDetailsFetches();
+        return;
+    }
+    
+    TWeakObjectPtr<ARestaurantDataManager> WeakThis(this);
+    TSharedPtr<FRestaurantProvider> Provider = Fetch.Provider;
+    const bool bRequested = Fetch.bRequested;
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Provider, Response, Key, ProviderName, bRequested]()
+    {
+        FRestaurantData Details;
+        const bool bParsed = Provider->ParseDetailsResponse(Response->GetContent(), Details);
+        
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Key, ProviderName, bRequested, bParsed, Details = MoveTemp(Details)]()
+        {
+            if (ARestaurantDataManager* This = WeakThis.Get())
+            {
+                This->OnRestaurantDetailsParsed(Key, ProviderName, bRequested, bParsed, Details);
+            }
+        });
+    });
+    
+    PumpDetailsFetches();
+}
+
+void ARestaurantDataManager::OnRestaurantDetailsParsed(const FString& Key, const FString& ProviderName, bool bRequested, bool bParsed, const FRestaurantData& Details)
+{
+    if (!bParsed)
+    {
+        if (bRequested)
+        {
+            HandleAPIError(ProviderName, "Malformed details response");
+        }
+        return;
+    }
+    
+    DetailsCache.Add(Key, Details);
+    UE_LOG(LogTemp, Verbose, TEXT("Details cached for %s"), *Key);
+    OnRestaurantDetailsReceived.Broadcast(Details);
+}
+
+void ARestaurantDataManager::ApplyCachedDetails(TArray<FRestaurantData>& Restaurants)
+{
+    if (DetailsCache.Num() == 0)
+    {
+        return;
+    }
+    
+    for (FRestaurantData& Restaurant : Restaurants)
+    {
+        for (const TSharedPtr<FRestaurantProvider>& Provider : Providers)
+        {
+            const FString Id = Provider->GetDetailsId(Restaurant);
+            if (Id.IsEmpty())
+            {
+                continue;
+            }
+            
+            if (const FRestaurantData* Details = DetailsCache.Find(FRestaurantDetailsCache::MakeKey(Provider->GetName(), Id)))
+            {
+                MergeRestaurantData(Restaurant, *Details);
+            }
+        }
+    }
+}
+
+void ARestaurantDataManager::RequestPhoto(const FString& PhotoURL)
+{
+    Photos->Request(PhotoURL);
+}
+
+void ARestaurantDataManager::OnPhotoLoaded(const FString& PhotoURL, UTexture2D* Texture, bool bFullResolution)
+{
+    OnPhotoReady.Broadcast(PhotoURL, Texture, bFullResolution);
+}
+
+void ARestaurantDataManager::OnPhotoEvicted(const FString& PhotoURL, UTexture2D* Texture)
+{
+    OnPhotoReleased.Broadcast(PhotoURL, Texture);
+}
+
+FString ARestaurantDataManager::BuildRestaurantContext(const TArray<FRestaurantData>& Restaurants)
+{
+    const TConstArrayView<FRestaurantData> Listed(Restaurants.GetData(), FMath::Min(Restaurants.Num(), 10));
+    
+    // Details may have arrived after the caller got these rows. They enter the key through
+    // the details cache generation, and hours only known from details through the quarter
+    // hour, so a repeated context is found without copying or merging anything.
+    const int64 QuarterHour = FDateTime::UtcNow().GetTicks() / (ETimespan::TicksPerMinute * FRestaurantOpenHours::SlotMinutes);
+    const uint32 Key = ContextRenderer->ComputeSourceKey(FString(), Listed, HashCombine(DetailsCache.GetGeneration(), GetTypeHash(QuarterHour)));
+    FString Context;
+    if (ContextRenderer->FindCached(Key, Context))
+    {
+        return Context;
+    }
+    
+    TArray<FRestaurantData> Detailed(Listed.GetData(), Listed.Num());
+    ApplyCachedDetails(Detailed);
+    return ContextRenderer->RenderAs(Key, FString(), Detailed);
+}
+
+void ARestaurantDataManager::ApplyLocalFilters(TArray<FRestaurantData>& Restaurants, FVector2D Location, const FSearchFilters& Filters)
+{
+    FRestaurantFilter(Filters, Location).Apply(Restaurants);
+}
+
+void ARestaurantDataManager::SaveCache(bool bBlocking)
+{
+    if (!CacheStore.IsValid())
+    {
+        return;
+    }
+    
+    // One write at a time, the mapping it reads from has to stay put
+    if (PendingCacheWrite.IsValid())
+    {
+        if (!bBlocking)
+        {
+            return;
+        }
+        PendingCacheWrite.Wait();
+        OnCacheWritten(PendingCacheWrite.Get());
+    }
+    
+    if (!TileCache.IsDirty())
+    {
+        return;
+    }
+    
+    // Only the changed tiles are snapshotted here, the file carries over the rest.
+    // Serializing and writing happen on a worker thread.
+    TSharedRef<TArray<FRestaurantPersistedTile>, ESPMode::ThreadSafe> Tiles = MakeShared<TArray<FRestaurantPersistedTile>, ESPMode::ThreadSafe>();
+    TileCache.ExportDirtyTiles(*Tiles);
+    PendingCacheTiles = Tiles;
+    const FDateTime OldestAllowed = FDateTime::UtcNow() - FTimespan::FromMinutes(TileCache.GetTimeToLiveMinutes());
+    
+    if (bBlocking)
+    {
+        OnCacheWritten(CacheStore->WriteFile(*Tiles, OldestAllowed));
+        return;
+    }
+    
+    TWeakObjectPtr<ARestaurantDataManager> WeakThis(this);
+    PendingCacheWrite = Async(EAsyncExecution::ThreadPool, [WeakThis, Store = CacheStore, Tiles, OldestAllowed]()
+    {
+        const bool bWritten = Store->WriteFile(*Tiles, OldestAllowed);
+        
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, bWritten]()
+        {
+            // A blocking save may have finished this write already
+            ARestaurantDataManager* This = WeakThis.Get();
+            if (This && This->PendingCacheWrite.IsValid())
+            {
+                This->OnCacheWritten(bWritten);
+            }
+        });
+        return bWritten;
+    });
+}
+
+void ARestaurantDataManager::OnCacheWritten(bool bWritten)
+{
+    PendingCacheWrite = TFuture<bool>();
+    TSharedPtr<const TArray<FRestaurantPersistedTile>, ESPMode::ThreadSafe> Tiles = MoveTemp(PendingCacheTiles);
+    
+    if (bDiscardPendingCacheWrite)
+    {
+        bDiscardPendingCacheWrite = false;
+        CacheStore->DiscardFile();
+        CacheStore->Invalidate();
+        TileCache.SetBackingStore(CacheStore.Get());
+        return;
+    }
+    
+    // The tiles are written again with the next save
+    if (!bWritten || !CacheStore->CommitFile())
+    {
+        TileCache.MarkDirty(*Tiles);
+    }
+}
+
+void ARestaurantDataManager::ClearCache()
+{
+    // Pages still arriving would refill the cache, searches in flight are recognised by their generation
+    CacheGeneration++;
+    for (const TPair<int32, TSharedPtr<FRestaurantSearchSession>>& Prefetch : PrefetchSessions)
+    {
+        for (FRestaurantProviderCall& Call : Prefetch.Value->ProviderCalls)
+        {
+            CancelProviderCall(Call);
+        }
+    }
+    PrefetchSessions.Empty();
+    
+    TileCache.Clear();
+    DetailsCache.Clear();
+    ContextRenderer->ClearCache();
+    ResultSets.Empty();
+    if (CacheStore.IsValid())
+    {
+        if (PendingCacheWrite.IsValid())
+        {
+            // The write still reads the mapped file, which goes once it is done.
+            // Until then no tile may be faulted back in from it.
+            bDiscardPendingCacheWrite = true;
+            TileCache.SetBackingStore(nullptr);
+        }
+        else
+        {
+            CacheStore->Invalidate();
+        }
+    }
     UE_LOG(LogTemp, Log, TEXT("Restaurant cache cleared"));
 }
 
@@ -4,7 +4,18 @@
 #include "GameFramework/Actor.h"
 #include "Engine/Engine.h"
 #include "Http.h"
+#include "Async/Future.h"
 #include "RestaurantData.h"
+#include "RestaurantSearchSession.h"
+#include "RestaurantTileCache.h"
+#include "RestaurantProvider.h"
+#include "RestaurantFilter.h"
+#include "RestaurantRanker.h"
+#include "RestaurantHttpClient.h"
+#include "RestaurantRequestScheduler.h"
+#include "RestaurantDetailsCache.h"
+#include "RestaurantPhotoPipeline.h"
+#include "RestaurantContextRenderer.h"
 #include "RestaurantDataManager.generated.h"
 
 UCLASS(BlueprintType, Blueprintable)
@@ -18,26 +29,93 @@ public:
     UPROPERTY(BlueprintAssignable, Category = "Events")
     FOnRestaurantsFound OnRestaurantsFound;
 
+    UPROPERTY(BlueprintAssignable, Category = "Events")
+    FOnSearchComplete OnSearchComplete;
+
+    // Fires when a completed session's restaurants change materially afterwards:
+    // stale cached results were refreshed in the background, or further result
+    // pages were prefetched for it
+    UPROPERTY(BlueprintAssignable, Category = "Events")
+    FOnSearchComplete OnSearchRevalidated;
+
+    // Progressive delivery: fires as each provider answers, before OnSearchComplete
+    UPROPERTY(BlueprintAssignable, Category = "Events")
+    FOnSearchResultsDelta OnSearchResultsDelta;
+
+    // Details fetched for one restaurant, whether asked for or prefetched for the top
+    // results. Holds only the fields the details endpoint returns and the provider id.
+    UPROPERTY(BlueprintAssignable, Category = "Events")
+    FOnRestaurantDetailsReceived OnRestaurantDetailsReceived;
+
+    // A photo is ready in Texture, first as a low resolution preview and then in full.
+    // Textures are pooled: a photo not requested for a while hands its texture to another.
+    UPROPERTY(BlueprintAssignable, Category = "Events")
+    FOnRestaurantPhotoReady OnPhotoReady;
+
+    // Texture stops showing PhotoURL and is about to be filled with another photo.
+    // Widgets still displaying PhotoURL should clear it or request the photo again.
+    UPROPERTY(BlueprintAssignable, Category = "Events")
+    FOnRestaurantPhotoReleased OnPhotoReleased;
+
     UPROPERTY(BlueprintAssignable, Category = "Events")
     FOnAPIError OnAPIError;
 
+    // Starts a search and returns its session id. OnSearchComplete fires for every
+    // session, OnRestaurantsFound only for the most recently started one.
+    UFUNCTION(BlueprintCallable, Category = "Restaurant Search")
+    int32 SearchRestaurants(FVector2D Location, const FSearchFilters& Filters);
+
+    // Narrows the results of a completed search ("cheaper", "with delivery", "4 stars
+    // and up") without asking the providers again. Returns the new session id, which
+    // completes through the same events as SearchRestaurants, or INDEX_NONE if the
+    // results are no longer held or Filters needs data they were not fetched with.
+    UFUNCTION(BlueprintCallable, Category = "Restaurant Search")
+    int32 RefineSearch(int32 SessionId, const FSearchFilters& Filters);
+
+    UFUNCTION(BlueprintCallable, Category = "Restaurant Search")
+    void CancelSearch(int32 SessionId);
+
+    UFUNCTION(BlueprintCallable, Category = "Restaurant Search")
+    bool IsSearchActive(int32 SessionId) const { return SessionSearches.Contains(SessionId); }
+
     UFUNCTION(BlueprintCallable, Category = "Restaurant Search")
-    void SearchRestaurants(FVector2D Location, const FSearchFilters& Filters);
+    int32 GetLatestSessionId() const { return LatestSessionId; }
 
+    // Answers through OnRestaurantDetailsReceived, from the details cache when possible
     UFUNCTION(BlueprintCallable, Category = "Restaurant Search")
     void GetRestaurantDetails(const FString& RestaurantId, const FString& APISource = "GooglePlaces");
 
+    // Loads one of a restaurant's PhotoURLs, answers through OnPhotoReady. Call again
+    // whenever the photo is shown so its texture stays in the pool.
+    UFUNCTION(BlueprintCallable, Category = "Photos")
+    void RequestPhoto(const FString& PhotoURL);
+
     UFUNCTION(BlueprintCallable, Category = "Restaurant Search")
     FString BuildRestaurantContext(const TArray<FRestaurantData>& Restaurants);
 
     UFUNCTION(BlueprintCallable, Category = "Configuration")
     void SetAPIKeys(const FString& GooglePlacesKey, const FString& YelpKey);
 
+    // Adds a search backend next to the built-in Google Places and Yelp providers.
+    // Affects searches started afterwards.
+    void RegisterProvider(TSharedRef<FRestaurantProvider> Provider);
+
+    // Replaces the weighted ranker that orders every result list
+    void SetRanker(TSharedRef<FRestaurantRanker> InRanker) { Ranker = InRanker; }
+
+    // Rate tokens, remaining daily quota and queue depth of every provider
+    UFUNCTION(BlueprintCallable, Category = "Configuration")
+    TArray<FRestaurantQuotaStatus> GetProviderQuotas() const;
+
     UFUNCTION(BlueprintCallable, Category = "Cache")
     void ClearCache();
 
+    UFUNCTION(BlueprintCallable, Category = "Cache")
+    FRestaurantCacheStats GetCacheStats() const { return TileCache.GetStats(); }
+
 protected:
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 private:
     // API Keys
@@ -47,60 +125,206 @@ private:
     UPROPERTY(EditAnywhere, Category = "API Configuration", meta = (AllowPrivateAccess = "true"))
     FString YelpAPIKey;
 
-    // API Base URLs
-    FString GooglePlacesBaseURL = "https://maps.googleapis.com/maps/api/place/";
-    FString YelpBaseURL = "https://api.yelp.com/v3/";
+    // A search answers with the merged results of whichever providers made it in time
+    UPROPERTY(EditAnywhere, Category = "API Configuration", meta = (AllowPrivateAccess = "true"))
+    float SearchDeadlineSeconds = 5.0f;
+
+    UPROPERTY(EditAnywhere, Category = "API Configuration", meta = (AllowPrivateAccess = "true"))
+    float ProviderTimeoutSeconds = 3.0f;
 
-    // Current search data
-    UPROPERTY()
-    TArray<FRestaurantData> CurrentRestaurants;
+    // A provider request whose response has not started after this long is abandoned and
+    // retried. Slow but healthy responses hit it too, so it is off (0) unless it is well
+    // below a raised ProviderTimeoutSeconds.
+    UPROPERTY(EditAnywhere, Category = "API Configuration", meta = (AllowPrivateAccess = "true"))
+    float ProviderFirstByteTimeoutSeconds = 0.0f;
 
-    UPROPERTY()
-    FVector2D CurrentSearchLocation;
+    // A provider that has not answered after this long gets a second, hedged request
+    UPROPERTY(EditAnywhere, Category = "API Configuration", meta = (AllowPrivateAccess = "true"))
+    float ProviderHedgeDelaySeconds = 1.5f;
 
-    UPROPERTY()
-    FSearchFilters CurrentFilters;
+    // Send OnSearchResultsDelta updates while providers are still outstanding
+    UPROPERTY(EditAnywhere, Category = "API Configuration", meta = (AllowPrivateAccess = "true"))
+    bool bProgressiveResults = true;
+
+    // Minimum spacing between background page requests
+    UPROPERTY(EditAnywhere, Category = "API Configuration", meta = (AllowPrivateAccess = "true"))
+    float PagePrefetchIntervalSeconds = 0.5f;
+
+    // Weights of the default ranker
+    UPROPERTY(EditAnywhere, Category = "Ranking", meta = (AllowPrivateAccess = "true"))
+    FRestaurantRankingWeights RankingWeights;
+
+    // Only this many leading results are put in rank order, the rest keep provider order
+    UPROPERTY(EditAnywhere, Category = "Ranking", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+    int32 RankedResultCount = 20;
+
+    TSharedPtr<FRestaurantRanker> Ranker;
+    TSharedPtr<FWeightedRestaurantRanker> WeightedRanker;
+
+    // Transport shared by all providers: timeouts, retry budget, circuit breakers
+    TSharedPtr<FRestaurantHttpClient> HttpClient;
+
+    // Orders provider requests by priority within each provider's rate limit and daily quota
+    TSharedPtr<FRestaurantRequestScheduler> Scheduler;
+
+    // Search backends, queried in parallel
+    TArray<TSharedPtr<FRestaurantProvider>> Providers;
+    TSharedPtr<FGooglePlacesProvider> GooglePlacesProvider;
+    TSharedPtr<FYelpProvider> YelpProvider;
+
+    // Search sessions. Identical queries share one provider search (single flight):
+    // ActiveSessions holds the provider searches, SessionSearches maps every
+    // caller's session id to the provider search it is attached to.
+    TMap<int32, TSharedPtr<FRestaurantSearchSession>> ActiveSessions;
+    TMap<int32, int32> SessionSearches;
+    TMultiMap<FString, int32> InFlightSearches; // Query class -> provider search
+
+    // Answered searches whose further result pages are still being prefetched
+    TMap<int32, TSharedPtr<FRestaurantSearchSession>> PrefetchSessions;
+
+    // Bumped by ClearCache, see FRestaurantSearchSession::CacheGeneration
+    uint32 CacheGeneration = 0;
+
+    int32 NextSessionId = 1;
+    int32 LatestSessionId = INDEX_NONE;
+
+    // Unfiltered results of the most recent completed searches, for RefineSearch.
+    // Refinements share the result set of the search they narrowed.
+    TMap<int32, TSharedPtr<const FRestaurantResultSet>> ResultSets;
 
     // Cache system
-    UPROPERTY()
-    TMap<FString, TArray<FRestaurantData>> RestaurantCache;
+    FRestaurantTileCache TileCache;
+
+    // Cached results younger than this are served as is
+    UPROPERTY(EditAnywhere, Category = "Cache", meta = (AllowPrivateAccess = "true"))
+    float CacheMaxAgeMinutes = 30.0f;
+
+    // Older results, up to this age, are served immediately and refreshed in the background
+    UPROPERTY(EditAnywhere, Category = "Cache", meta = (AllowPrivateAccess = "true"))
+    float CacheStaleMaxAgeMinutes = 180.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Cache", meta = (AllowPrivateAccess = "true"))
+    int32 CacheBudgetMegabytes = 256;
+
+    // Keep the cache in Saved/Cache across restarts
+    UPROPERTY(EditAnywhere, Category = "Cache", meta = (AllowPrivateAccess = "true"))
+    bool bPersistCache = true;
+
+    // Shared with the worker thread that writes it
+    TSharedPtr<FRestaurantCacheStore, ESPMode::ThreadSafe> CacheStore;
 
-    UPROPERTY()
-    TMap<FString, FDateTime> CacheTimestamps;
+    // The write in flight, if any. The store must not be reopened or invalidated
+    // until it has finished, a ClearCache meanwhile drops it afterwards.
+    TFuture<bool> PendingCacheWrite;
+    bool bDiscardPendingCacheWrite = false;
+
+    // The tiles it writes, marked dirty again if it fails
+    TSharedPtr<const TArray<FRestaurantPersistedTile>, ESPMode::ThreadSafe> PendingCacheTiles;
+
+    // Hours, phone and photos of the best results are fetched right after each search
+    UPROPERTY(EditAnywhere, Category = "Details", meta = (AllowPrivateAccess = "true", ClampMin = "0"))
+    int32 DetailsPrefetchCount = 5;
+
+    UPROPERTY(EditAnywhere, Category = "Details", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+    int32 MaxConcurrentDetailsRequests = 3;
+
+    UPROPERTY(EditAnywhere, Category = "Details", meta = (AllowPrivateAccess = "true"))
+    float DetailsCacheMaxAgeMinutes = 720.0f;
+
+    struct FDetailsFetch
+    {
+        FString Key;
+        FString Id;
+        TSharedPtr<FRestaurantProvider> Provider;
+        TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request;
+        // Asked for through GetRestaurantDetails rather than prefetched
+        bool bRequested = false;
+    };
+
+    FRestaurantDetailsCache DetailsCache;
+    TArray<FDetailsFetch> DetailsQueue;
+    TMap<FString, FDetailsFetch> DetailsInFlight;
+
+    // Photo textures kept in VRAM at once, each PhotoTextureSize squared
+    UPROPERTY(EditAnywhere, Category = "Photos", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+    int32 PhotoPoolSize = 48;
+
+    UPROPERTY(EditAnywhere, Category = "Photos", meta = (AllowPrivateAccess = "true", ClampMin = "64"))
+    int32 PhotoTextureSize = 512;
+
+    UPROPERTY(EditAnywhere, Category = "Photos", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+    int32 MaxConcurrentPhotoDownloads = 4;
+
+    // Downloaded photos kept in Saved/Cache/Photos
+    UPROPERTY(EditAnywhere, Category = "Photos", meta = (AllowPrivateAccess = "true"))
+    int32 PhotoDiskCacheMegabytes = 128;
+
+    // The first photo of this many top results is loaded right after each search
+    UPROPERTY(EditAnywhere, Category = "Photos", meta = (AllowPrivateAccess = "true", ClampMin = "0"))
+    int32 PhotoPrefetchCount = 5;
+
+    TSharedPtr<FRestaurantPhotoPipeline> Photos;
+
+    // BuildRestaurantContext output, cached per result set
+    TUniquePtr<FRestaurantContextRenderer> ContextRenderer;
+
+    FTimerHandle CacheEvictionTimer;
 
     // HTTP request handling
-    void OnGooglePlacesResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
-    void OnYelpResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
-    void OnRestaurantDetailsResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
+    void OnProviderResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, int32 SessionId, int32 CallIndex);
+    void OnRestaurantDetailsResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, FString Key);
+    void OnPhotoLoaded(const FString& PhotoURL, UTexture2D* Texture, bool bFullResolution);
+    void OnPhotoEvicted(const FString& PhotoURL, UTexture2D* Texture);
+    void OnRestaurantDetailsParsed(const FString& Key, const FString& ProviderName, bool bRequested, bool bParsed, const FRestaurantData& Details);
+    void OnProviderParsed(int32 SessionId, int32 CallIndex, bool bSucceeded, const TArray<FRestaurantData>& ProviderResults, const FString& NextPageToken);
+    void OnProviderPageResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, int32 SessionId, int32 CallIndex);
+    void OnProviderPageParsed(int32 SessionId, int32 CallIndex, bool bSucceeded, const TArray<FRestaurantData>& PageResults, const FString& NextPageToken);
     
     // Search methods
-    void SearchGooglePlaces(FVector2D Location, const FSearchFilters& Filters);
-    void SearchYelp(FVector2D Location, const FSearchFilters& Filters);
-    void CheckRequestsComplete();
+    void SendProviderRequest(FRestaurantSearchSession& Session, int32 CallIndex);
+    void OnProviderHedge(int32 SessionId, int32 CallIndex);
+    void OnProviderRetry(int32 SessionId, int32 CallIndex);
+    void OnSearchDeadline(int32 SessionId);
+    void CancelProviderCall(FRestaurantProviderCall& Call);
+    void CheckRequestsComplete(int32 SessionId);
 
-    // API request builders
-    FString BuildGooglePlacesSearchURL(FVector2D Location, const FSearchFilters& Filters);
-    FString BuildYelpSearchURL(FVector2D Location, const FSearchFilters& Filters);
-    FString BuildGooglePlaceDetailsURL(const FString& PlaceId);
+    // Background pagination
+    void StartPagePrefetch(TSharedRef<FRestaurantSearchSession> Session);
+    void SchedulePageFetch(FRestaurantSearchSession& Session, int32 CallIndex, float DelaySeconds);
+    void FetchNextPage(int32 SessionId, int32 CallIndex);
+    void UpdateCompletedSubscribers(FRestaurantSearchSession& Session);
+    void StoreSessionResults(const FRestaurantSearchSession& Session);
 
-    // Data processing
-    TArray<FRestaurantData> ParseGooglePlacesResponse(const FString& ResponseBody);
-    TArray<FRestaurantData> ParseYelpResponse(const FString& ResponseBody);
-    FRestaurantData ParseGooglePlaceDetails(const FString& ResponseBody);
+    // Session handling
+    TSharedPtr<FRestaurantSearchSession> StartProviderSearch(int32 SessionId, FVector2D Location, const FSearchFilters& Filters);
+    TSharedPtr<FRestaurantSearchSession> FindInFlightSearch(FVector2D Location, const FSearchFilters& Filters) const;
+    void AttachToSearch(FRestaurantSearchSession& Session, const FRestaurantSearchSubscriber& Subscriber);
+    void CancelProviderSearch(int32 SearchId);
+    void StartRevalidation(int32 StaleSessionId, FVector2D Location, const FSearchFilters& Filters, const TArray<FRestaurantData>& StaleResults);
+    uint32 ComputeResultFingerprint(const TArray<FRestaurantData>& Restaurants) const;
+    TSharedPtr<FRestaurantSearchSession> FindLiveSession(int32 SessionId) const;
+    void AddSessionResults(FRestaurantSearchSession& Session, const TArray<FRestaurantData>& Results);
+    void CompleteSession(int32 SessionId, const TArray<FRestaurantData>& Results);
+    void CompleteSessionNextTick(int32 SessionId, const TArray<FRestaurantData>& Results);
+    void BroadcastDelta(const FRestaurantSearchSession& Session, FRestaurantSearchSubscriber& Subscriber, bool bFinal);
+    void RetainResultSet(int32 SessionId, TSharedPtr<const FRestaurantResultSet> ResultSet);
+
+    // Details (requests are built and parsed by the providers)
+    void PrefetchDetails(const TArray<FRestaurantData>& Restaurants);
+    void QueueDetailsFetch(TSharedRef<FRestaurantProvider> Provider, const FString& Id, bool bRequested);
+    void PumpDetailsFetches();
+    void ApplyCachedDetails(TArray<FRestaurantData>& Restaurants);
+    TSharedPtr<FRestaurantProvider> FindProvider(const FString& Name) const;
 
     // Utility functions
     void CombineSearchResults(const TArray<FRestaurantData>& GoogleResults, const TArray<FRestaurantData>& YelpResults);
     void MergeRestaurantData(FRestaurantData& Target, const FRestaurantData& Source);
-    void SortByRelevance(TArray<FRestaurantData>& Restaurants);
-    bool IsCacheValid(const FString& CacheKey, float MaxAgeMinutes = 30.0f);
-    FString GenerateCacheKey(FVector2D Location, const FSearchFilters& Filters);
-    FString GetTodayHours(const FOperatingHours& Hours);
+    void RankResults(TArray<FRestaurantData>& Restaurants, const FSearchFilters& Filters);
+    void SaveCache(bool bBlocking = false);
+    void OnCacheWritten(bool bWritten);
+    void ApplyLocalFilters(TArray<FRestaurantData>& Restaurants, FVector2D Location, const FSearchFilters& Filters);
+    static uint32 ComputeRestaurantHash(const FRestaurantData& Restaurant);
 
     // Error handling
     void HandleAPIError(const FString& APIName, const FString& ErrorMessage);
-
-    // Request tracking
-    int32 PendingRequests = 0;
-    bool bGooglePlacesComplete = false;
-    bool bYelpComplete = false;
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "RestaurantDetailsCache.h"
+
+void FRestaurantDetailsCache::SetLimits(int32 InMaxEntries, float InTimeToLiveMinutes)
+{
+    MaxEntries = FMath::Max(InMaxEntries, 1);
+    TimeToLiveMinutes = InTimeToLiveMinutes;
+}
+
+const FRestaurantData* FRestaurantDetailsCache::Find(const FString& Key)
+{
+    FEntry* Entry = Entries.Find(Key);
+    if (!Entry)
+    {
+        return nullptr;
+    }
+
+    if ((FDateTime::Now() - Entry->FetchedAt).GetTotalMinutes() >= TimeToLiveMinutes)
+    {
+        Entries.Remove(Key);
+        Generation++;
+        return nullptr;
+    }
+
+    Entry->LastAccess = ++AccessCounter;
+    return &Entry->Details;
+}
+
+void FRestaurantDetailsCache::Add(const FString& Key, const FRestaurantData& Details)
+{
+    FEntry& Entry = Entries.FindOrAdd(Key);
+    Entry.Details = Details;
+    Entry.FetchedAt = FDateTime::Now();
+    Entry.LastAccess = ++AccessCounter;
+    Generation++;
+
+    // Small enough that a scan for the oldest entry is cheaper than keeping a list
+    while (Entries.Num() > MaxEntries)
+    {
+        const FString* OldestKey = nullptr;
+        uint64 OldestAccess = MAX_uint64;
+        for (const TPair<FString, FEntry>& Other : Entries)
+        {
+            if (Other.Value.LastAccess < OldestAccess)
+            {
+                OldestAccess = Other.Value.LastAccess;
+                OldestKey = &Other.Key;
+            }
+        }
+        Entries.Remove(FString(*OldestKey));
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+// Place details (hours, phone, photos) by provider and id. Kept apart from the
+// tile cache: details are fetched per restaurant, outlive search results by far
+// and apply to every search the restaurant shows up in. Entries older than the
+// TTL are ignored, the least recently used ones are evicted past MaxEntries.
+class RESTAURANTCONCIERGE_API FRestaurantDetailsCache
+{
+public:
+    static FString MakeKey(const FString& ProviderName, const FString& Id) { return ProviderName + TEXT(":") + Id; }
+
+    void SetLimits(int32 InMaxEntries, float InTimeToLiveMinutes);
+
+    // Null if missing or expired. The pointer is valid until the next Add.
+    const FRestaurantData* Find(const FString& Key);
+
+    void Add(const FString& Key, const FRestaurantData& Details);
+
+    void Clear() { Entries.Empty(); Generation++; }
+    int32 Num() const { return Entries.Num(); }
+
+    // Changes whenever an entry is added or dropped, for caches of merged results
+    uint32 GetGeneration() const { return Generation; }
+
+private:
+    struct FEntry
+    {
+        FRestaurantData Details;
+        FDateTime FetchedAt;
+        uint64 LastAccess = 0;
+    };
+
+    TMap<FString, FEntry> Entries;
+    int32 MaxEntries = 512;
+    float TimeToLiveMinutes = 720.0f;
+    uint64 AccessCounter = 0;
+    uint32 Generation = 0;
+};
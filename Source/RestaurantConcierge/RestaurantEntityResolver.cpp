@@ -0,0 +1,300 @@
+#include "RestaurantEntityResolver.h"
+#include "RestaurantGeo.h"
+
+FRestaurantEntityResolver::FRestaurantEntityResolver(double InMatchRadiusMeters, double InMinNameSimilarity)
+    : MatchRadiusMeters(InMatchRadiusMeters)
+    , MinNameSimilarity(InMinNameSimilarity)
+    , ExactNameRadiusMeters(InMatchRadiusMeters * 3.0)
+{
+    Reset(FVector2D::ZeroVector);
+}
+
+void FRestaurantEntityResolver::Reset(const FVector2D& ReferenceLocation)
+{
+    Entries.Reset();
+    Cells.Reset();
+    EntriesByNameHash.Reset();
+    EntriesByGoogleId.Reset();
+    EntriesByYelpId.Reset();
+    EntriesByIndex.Reset();
+
+    // Clamp so cells stay usable near the poles
+    const double CosLat = FMath::Max(FMath::Cos(FMath::DegreesToRadians(static_cast<double>(ReferenceLocation.X))), 0.01);
+    CellSizeLatDegrees = MatchRadiusMeters / FRestaurantGeo::MetersPerDegreeLatitude;
+    CellSizeLngDegrees = MatchRadiusMeters / (FRestaurantGeo::MetersPerDegreeLatitude * CosLat);
+}
+
+FIntPoint FRestaurantEntityResolver::GetCell(const FVector2D& Location) const
+{
+    return FIntPoint(
+        FMath::FloorToInt32(Location.X / CellSizeLatDegrees),
+        FMath::FloorToInt32(Location.Y / CellSizeLngDegrees));
+}
+
+void FRestaurantEntityResolver::Add(const FRestaurantData& Restaurant, int32 Index)
+{
+    FEntry& Entry = Entries.AddDefaulted_GetRef();
+    Entry.Index = Index;
+    Entry.Location = Restaurant.Location;
+    Entry.NormalizedName = NormalizeName(Restaurant.Name);
+    Entry.NameHash = GetTypeHash(Entry.NormalizedName);
+    Entry.bHasLocation = FRestaurantGeo::IsValidLocation(Restaurant.Location);
+
+    const int32 EntryIndex = Entries.Num() - 1;
+
+    if (Entry.bHasLocation)
+    {
+        Cells.FindOrAdd(GetCell(Entry.Location)).Add(EntryIndex);
+    }
+
+    if (!Entry.NormalizedName.IsEmpty())
+    {
+        EntriesByNameHash.Add(Entry.NameHash, EntryIndex);
+    }
+
+    EntriesByIndex.Add(Index, EntryIndex);
+    UpdateIds(Restaurant, Index);
+}
+
+void FRestaurantEntityResolver::UpdateIds(const FRestaurantData& Restaurant, int32 Index)
+{
+    const int32* EntryIndex = EntriesByIndex.Find(Index);
+    if (!EntryIndex)
+    {
+        return;
+    }
+
+    FEntry& Entry = Entries[*EntryIndex];
+    if (Entry.GooglePlaceId.IsEmpty() && !Restaurant.GooglePlaceId.IsEmpty())
+    {
+        Entry.GooglePlaceId = Restaurant.GooglePlaceId;
+        EntriesByGoogleId.Add(Entry.GooglePlaceId, *EntryIndex);
+    }
+    if (Entry.YelpBusinessId.IsEmpty() && !Restaurant.YelpBusinessId.IsEmpty())
+    {
+        Entry.YelpBusinessId = Restaurant.YelpBusinessId;
+        EntriesByYelpId.Add(Entry.YelpBusinessId, *EntryIndex);
+    }
+}
+
+int32 FRestaurantEntityResolver::FindMatch(const FRestaurantData& Restaurant) const
+{
+    const FString NormalizedName = NormalizeName(Restaurant.Name);
+    const uint32 NameHash = GetTypeHash(NormalizedName);
+    const bool bHasLocation = FRestaurantGeo::IsValidLocation(Restaurant.Location);
+
+    // A provider id names one listing, so it settles the question before any heuristic
+    const int32* IdMatch = Restaurant.GooglePlaceId.IsEmpty() ? nullptr : EntriesByGoogleId.Find(Restaurant.GooglePlaceId);
+    if (!IdMatch && !Restaurant.YelpBusinessId.IsEmpty())
+    {
+        IdMatch = EntriesByYelpId.Find(Restaurant.YelpBusinessId);
+    }
+    if (IdMatch)
+    {
+        return Entries[*IdMatch].Index;
+    }
+
+    // Identical normalized names first, they are the cheapest and most reliable signal
+    if (!NormalizedName.IsEmpty())
+    {
+        for (auto It = EntriesByNameHash.CreateConstKeyIterator(NameHash); It; ++It)
+        {
+            const FEntry& Entry = Entries[It.Value()];
+            if (IsSameRestaurant(Entry, Restaurant, bHasLocation, NormalizedName, NameHash))
+            {
+                return Entry.Index;
+            }
+        }
+    }
+
+    if (!bHasLocation)
+    {
+        return INDEX_NONE;
+    }
+
+    // Fuzzy names only within the neighbouring cells
+    const FIntPoint Center = GetCell(Restaurant.Location);
+    int32 BestIndex = INDEX_NONE;
+    double BestDistance = MatchRadiusMeters;
+
+    for (int32 DX = -1; DX <= 1; DX++)
+    {
+        for (int32 DY = -1; DY <= 1; DY++)
+        {
+            const TArray<int32, TInlineAllocator<4>>* Bucket = Cells.Find(Center + FIntPoint(DX, DY));
+            if (!Bucket)
+            {
+                continue;
+            }
+
+            for (int32 EntryIndex : *Bucket)
+            {
+                const FEntry& Entry = Entries[EntryIndex];
+                const double Distance = FRestaurantGeo::HaversineMeters(Entry.Location, Restaurant.Location);
+                if (Distance <= BestDistance &&
+                    IsSameRestaurant(Entry, Restaurant, bHasLocation, NormalizedName, NameHash))
+                {
+                    BestIndex = Entry.Index;
+                    BestDistance = Distance;
+                }
+            }
+        }
+    }
+
+    return BestIndex;
+}
+
+bool FRestaurantEntityResolver::IsSameRestaurant(const FEntry& Entry, const FRestaurantData& Restaurant, bool bHasLocation,
+    const FString& NormalizedName, uint32 NameHash) const
+{
+    if (HasConflictingIds(Entry, Restaurant))
+    {
+        return false;
+    }
+
+    const bool bSameName = Entry.NameHash == NameHash && Entry.NormalizedName == NormalizedName;
+
+    if (!Entry.bHasLocation || !bHasLocation)
+    {
+        // Without coordinates only an exact name is trustworthy
+        return bSameName && !NormalizedName.IsEmpty();
+    }
+
+    const double Distance = FRestaurantGeo::HaversineMeters(Entry.Location, Restaurant.Location);
+
+    if (bSameName)
+    {
+        return Distance <= ExactNameRadiusMeters;
+    }
+
+    return Distance <= MatchRadiusMeters && JaroWinkler(Entry.NormalizedName, NormalizedName) >= MinNameSimilarity;
+}
+
+bool FRestaurantEntityResolver::HasConflictingIds(const FEntry& Entry, const FRestaurantData& Restaurant)
+{
+    const bool bGoogleConflict = !Entry.GooglePlaceId.IsEmpty() && !Restaurant.GooglePlaceId.IsEmpty() &&
+        Entry.GooglePlaceId != Restaurant.GooglePlaceId;
+    const bool bYelpConflict = !Entry.YelpBusinessId.IsEmpty() && !Restaurant.YelpBusinessId.IsEmpty() &&
+        Entry.YelpBusinessId != Restaurant.YelpBusinessId;
+    return bGoogleConflict || bYelpConflict;
+}
+
+FString FRestaurantEntityResolver::NormalizeName(const FString& Name)
+{
+    static const TCHAR* FillerWords[] = { TEXT("the"), TEXT("and"), TEXT("restaurant"), TEXT("llc"), TEXT("inc") };
+
+    FString Result;
+    Result.Reserve(Name.Len());
+
+    FString Word;
+    auto FlushWord = [&Result, &Word]()
+    {
+        if (Word.IsEmpty())
+        {
+            return;
+        }
+
+        for (const TCHAR* Filler : FillerWords)
+        {
+            if (Word == Filler)
+            {
+                Word.Reset();
+                return;
+            }
+        }
+
+        if (!Result.IsEmpty())
+        {
+            Result.AppendChar(TEXT(' '));
+        }
+        Result += Word;
+        Word.Reset();
+    };
+
+    for (TCHAR Char : Name)
+    {
+        if (FChar::IsAlnum(Char))
+        {
+            Word.AppendChar(FChar::ToLower(Char));
+        }
+        else if (Char != TEXT('\'') && Char != TEXT('.'))
+        {
+            // Apostrophes and dots are dropped inside a word ("Joe's" == "Joes")
+            FlushWord();
+        }
+    }
+    FlushWord();
+
+    return Result;
+}
+
+double FRestaurantEntityResolver::JaroWinkler(const FString& A, const FString& B)
+{
+    const int32 LenA = A.Len();
+    const int32 LenB = B.Len();
+
+    if (LenA == 0 || LenB == 0)
+    {
+        return (LenA == LenB) ? 1.0 : 0.0;
+    }
+
+    const int32 MatchWindow = FMath::Max(0, FMath::Max(LenA, LenB) / 2 - 1);
+
+    TArray<bool, TInlineAllocator<64>> MatchedA;
+    TArray<bool, TInlineAllocator<64>> MatchedB;
+    MatchedA.SetNumZeroed(LenA);
+    MatchedB.SetNumZeroed(LenB);
+
+    int32 Matches = 0;
+    for (int32 i = 0; i < LenA; i++)
+    {
+        const int32 Start = FMath::Max(0, i - MatchWindow);
+        const int32 End = FMath::Min(LenB - 1, i + MatchWindow);
+        for (int32 j = Start; j <= End; j++)
+        {
+            if (!MatchedB[j] && A[i] == B[j])
+            {
+                MatchedA[i] = true;
+                MatchedB[j] = true;
+                Matches++;
+                break;
+            }
+        }
+    }
+
+    if (Matches == 0)
+    {
+        return 0.0;
+    }
+
+    int32 Transpositions = 0;
+    int32 k = 0;
+    for (int32 i = 0; i < LenA; i++)
+    {
+        if (!MatchedA[i])
+        {
+            continue;
+        }
+        while (!MatchedB[k])
+        {
+            k++;
+        }
+        if (A[i] != B[k])
+        {
+            Transpositions++;
+        }
+        k++;
+    }
+
+    const double M = static_cast<double>(Matches);
+    const double Jaro = (M / LenA + M / LenB + (M - Transpositions / 2.0) / M) / 3.0;
+
+    int32 Prefix = 0;
+    const int32 MaxPrefix = FMath::Min(4, FMath::Min(LenA, LenB));
+    while (Prefix < MaxPrefix && A[Prefix] == B[Prefix])
+    {
+        Prefix++;
+    }
+
+    return Jaro + Prefix * 0.1 * (1.0 - Jaro);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+// Finds the entry describing the same physical restaurant when results from
+// several providers are merged. Entries are bucketed into a metric grid so a
+// lookup only inspects the 3x3 neighbourhood around the candidate, which keeps
+// merging N results against M results close to linear.
+class RESTAURANTCONCIERGE_API FRestaurantEntityResolver
+{
+public:
+    FRestaurantEntityResolver(double InMatchRadiusMeters = 75.0, double InMinNameSimilarity = 0.88);
+
+    // Clears all entries. The reference location fixes the longitude cell width.
+    void Reset(const FVector2D& ReferenceLocation);
+
+    // Registers a restaurant stored at Index in the caller's result array
+    void Add(const FRestaurantData& Restaurant, int32 Index);
+
+    // Picks up the provider ids a merge gave the restaurant registered at Index
+    void UpdateIds(const FRestaurantData& Restaurant, int32 Index);
+
+    // Returns the caller's index of the matching restaurant, or INDEX_NONE. A
+    // shared provider id always matches, a different id from the same provider
+    // never does; names and distance only decide between records that cannot tell.
+    int32 FindMatch(const FRestaurantData& Restaurant) const;
+
+    // Lowercase alphanumeric words with filler words ("the", "restaurant", ...) removed
+    static FString NormalizeName(const FString& Name);
+
+    // Jaro-Winkler similarity in [0, 1]
+    static double JaroWinkler(const FString& A, const FString& B);
+
+private:
+    struct FEntry
+    {
+        int32 Index = INDEX_NONE;
+        FVector2D Location = FVector2D::ZeroVector;
+        FString NormalizedName;
+        uint32 NameHash = 0;
+        FString GooglePlaceId;
+        FString YelpBusinessId;
+        bool bHasLocation = false;
+    };
+
+    FIntPoint GetCell(const FVector2D& Location) const;
+    bool IsSameRestaurant(const FEntry& Entry, const FRestaurantData& Restaurant, bool bHasLocation,
+        const FString& NormalizedName, uint32 NameHash) const;
+
+    // Both records come from the same provider under different ids, e.g. two branches of a chain
+    static bool HasConflictingIds(const FEntry& Entry, const FRestaurantData& Restaurant);
+
+    double MatchRadiusMeters;
+    double MinNameSimilarity;
+
+    // Providers geocode the same storefront differently, so an identical
+    // normalized name is accepted from further away than a fuzzy one
+    double ExactNameRadiusMeters;
+
+    double CellSizeLatDegrees = 0.0;
+    double CellSizeLngDegrees = 0.0;
+
+    TArray<FEntry> Entries;
+    TMap<FIntPoint, TArray<int32, TInlineAllocator<4>>> Cells;
+    TMultiMap<uint32, int32> EntriesByNameHash;
+    TMap<FString, int32> EntriesByGoogleId;
+    TMap<FString, int32> EntriesByYelpId;
+    TMap<int32, int32> EntriesByIndex;
+};
@@ -0,0 +1,214 @@
+#include "RestaurantFilter.h"
+#include "RestaurantGeo.h"
+#include "RestaurantTileCache.h"
+#include "Math/VectorRegister.h"
+
+void FRestaurantFilterColumns::Pack(TArray<FRestaurantData>& Restaurants, FVector2D Location)
+{
+    NumRows = Restaurants.Num();
+    const int32 PaddedRows = Align(NumRows, 4);
+
+    Ratings.Reset(PaddedRows);
+    Distances.Reset(PaddedRows);
+    PriceLevels.Reset(NumRows);
+    Flags.Reset(NumRows);
+    OpenSlots.Reset(NumRows);
+    UtcOffsetMinutes.Reset(NumRows);
+
+    // One vectorized pass for all distances
+    TArray<double> Latitudes, Longitudes;
+    Latitudes.Reserve(NumRows);
+    Longitudes.Reserve(NumRows);
+    for (const FRestaurantData& Restaurant : Restaurants)
+    {
+        Latitudes.Add(Restaurant.Location.X);
+        Longitudes.Add(Restaurant.Location.Y);
+    }
+    Distances.SetNumUninitialized(NumRows);
+    FRestaurantGeo::HaversineMetersBatch(Location, Latitudes.GetData(), Longitudes.GetData(), NumRows, Distances.GetData());
+
+    for (int32 Row = 0; Row < NumRows; Row++)
+    {
+        FRestaurantData& Restaurant = Restaurants[Row];
+        if (FRestaurantGeo::IsValidLocation(Restaurant.Location))
+        {
+            Restaurant.DistanceFromUser = Distances[Row];
+        }
+        else
+        {
+            // Whatever DistanceFromUser says was measured from somewhere else
+            Distances[Row] = 0.0f;
+        }
+
+        Ratings.Add(Restaurant.Rating);
+        PriceLevels.Add(ParsePriceLevel(Restaurant.PriceLevel));
+
+        uint8 RowFlags = 0;
+        RowFlags |= Restaurant.bAcceptsReservations ? AcceptsReservations : 0;
+        RowFlags |= Restaurant.bDelivery ? Delivery : 0;
+        RowFlags |= Restaurant.bTakeout ? Takeout : 0;
+        RowFlags |= Restaurant.Hours.bHasUtcOffset ? HasUtcOffset : 0;
+
+        // Google never reports services, on its rows they are unknown rather than absent
+        RowFlags |= Restaurant.YelpBusinessId.IsEmpty() ? 0 : ServicesKnown;
+        Flags.Add(RowFlags);
+
+        OpenSlots.Add(Restaurant.Hours.OpenSlots);
+        UtcOffsetMinutes.Add(static_cast<int16>(Restaurant.Hours.UtcOffsetMinutes));
+    }
+
+    // Padding rows are loaded with the last block but masked out by Evaluate
+    Ratings.SetNumZeroed(PaddedRows);
+    Distances.SetNumZeroed(PaddedRows);
+}
+
+uint8 FRestaurantFilterColumns::ParsePriceLevel(const FString& PriceLevel)
+{
+    int32 Level = 0;
+    for (TCHAR Char : PriceLevel)
+    {
+        Level += Char == TEXT('$') ? 1 : 0;
+    }
+    return static_cast<uint8>(FMath::Min(Level, 4));
+}
+
+FRestaurantFilter::FRestaurantFilter(const FSearchFilters& Filters, FVector2D InLocation)
+    : Location(InLocation)
+    , MinRating(Filters.MinRating)
+    , MaxDistance(Filters.MaxDistance)
+    , bOpenNow(Filters.bOpenNow)
+{
+    if (!Filters.PriceRange.IsEmpty() && !ParsePriceRange(Filters.PriceRange, MinPriceLevel, MaxPriceLevel))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Ignoring unrecognized price range '%s'"), *Filters.PriceRange);
+    }
+
+    RequiredFlags |= Filters.bAcceptsReservations ? FRestaurantFilterColumns::AcceptsReservations : 0;
+    RequiredFlags |= Filters.bHasDelivery ? FRestaurantFilterColumns::Delivery : 0;
+    RequiredFlags |= Filters.bHasTakeout ? FRestaurantFilterColumns::Takeout : 0;
+
+    if (bOpenNow)
+    {
+        UtcNow = FDateTime::UtcNow();
+        FallbackUtcOffsetMinutes = FRestaurantOpenHours::GetLocalUtcOffsetMinutes();
+    }
+}
+
+void FRestaurantFilter::Evaluate(const FRestaurantFilterColumns& Columns, TArray<int32>& OutRows) const
+{
+    OutRows.Reset(Columns.NumRows);
+
+    const VectorRegister4Float MinRatingVector = VectorSetFloat1(MinRating);
+    const VectorRegister4Float MaxDistanceVector = VectorSetFloat1(MaxDistance);
+    const float* Ratings = Columns.Ratings.GetData();
+    const float* Distances = Columns.Distances.GetData();
+
+    for (int32 Block = 0; Block < Columns.NumRows; Block += 4)
+    {
+        // Rating and distance for four rows at once, the rest only for rows that survive
+        const VectorRegister4Float RatingPass = VectorCompareGE(VectorLoad(Ratings + Block), MinRatingVector);
+        const VectorRegister4Float DistancePass = VectorCompareLE(VectorLoad(Distances + Block), MaxDistanceVector);
+        uint32 Mask = VectorMaskBits(VectorBitwiseAnd(RatingPass, DistancePass));
+        if (Columns.NumRows - Block < 4)
+        {
+            Mask &= (1u << (Columns.NumRows - Block)) - 1;
+        }
+
+        while (Mask)
+        {
+            const int32 Row = Block + FMath::CountTrailingZeros(Mask);
+            Mask &= Mask - 1;
+
+            const uint8 PriceLevel = Columns.PriceLevels[Row];
+            const uint8 RowFlags = Columns.Flags[Row];
+            if (((RowFlags & FRestaurantFilterColumns::ServicesKnown) && (RowFlags & RequiredFlags) != RequiredFlags) ||
+                (PriceLevel != 0 && (PriceLevel < MinPriceLevel || PriceLevel > MaxPriceLevel)))
+            {
+                continue;
+            }
+
+            if (bOpenNow && Columns.OpenSlots[Row].bKnown)
+            {
+                int32 Day = 0, MinuteOfDay = 0;
+                const int32 Offset = (RowFlags & FRestaurantFilterColumns::HasUtcOffset) ? Columns.UtcOffsetMinutes[Row] : FallbackUtcOffsetMinutes;
+                FRestaurantOpenHours::ToLocal(UtcNow, Offset, Day, MinuteOfDay);
+                if (!Columns.OpenSlots[Row].IsOpenAtLocal(Day, MinuteOfDay))
+                {
+                    continue;
+                }
+            }
+            else if (bOpenNow && !Columns.OpenSlots[Row].IsOpenNearObservation(UtcNow))
+            {
+                continue;
+            }
+
+            OutRows.Add(Row);
+        }
+    }
+}
+
+void FRestaurantFilter::Apply(TArray<FRestaurantData>& Restaurants) const
+{
+    FRestaurantFilterColumns Columns;
+    Columns.Pack(Restaurants, Location);
+
+    TArray<int32> Rows;
+    Evaluate(Columns, Rows);
+    if (Rows.Num() == Restaurants.Num())
+    {
+        return;
+    }
+
+    TArray<FRestaurantData> Passed;
+    Passed.Reserve(Rows.Num());
+    for (int32 Row : Rows)
+    {
+        Passed.Add(MoveTemp(Restaurants[Row]));
+    }
+    Restaurants = MoveTemp(Passed);
+}
+
+bool FRestaurantFilter::ParsePriceRange(const FString& PriceRange, uint8& OutMin, uint8& OutMax)
+{
+    FString MinText = PriceRange, MaxText;
+    if (!PriceRange.Split(TEXT("-"), &MinText, &MaxText))
+    {
+        MaxText = MinText;
+    }
+
+    MinText.TrimStartAndEndInline();
+    MaxText.TrimStartAndEndInline();
+    const uint8 Min = FRestaurantFilterColumns::ParsePriceLevel(MinText);
+    const uint8 Max = FRestaurantFilterColumns::ParsePriceLevel(MaxText);
+    if (Min == 0 || Max == 0 || Min > Max || MinText.Len() != Min || MaxText.Len() != Max)
+    {
+        return false;
+    }
+
+    OutMin = Min;
+    OutMax = Max;
+    return true;
+}
+
+FRestaurantResultSet::FRestaurantResultSet(FVector2D InLocation, const FSearchFilters& InFilters, float InCoveredRadius, const TArray<FRestaurantData>& InRows)
+    : Location(InLocation)
+    , Filters(InFilters)
+    , CoveredRadius(InCoveredRadius)
+    , Rows(InRows)
+{
+    Columns.Pack(Rows, Location);
+}
+
+bool FRestaurantResultSet::CanAnswer(const FSearchFilters& Refined) const
+{
+    if (Refined.MaxDistance > CoveredRadius)
+    {
+        return false;
+    }
+
+    // Open-now is enforced locally, so only dropping it needs the providers again
+    FSearchFilters ProviderView = Refined;
+    ProviderView.bOpenNow = Filters.bOpenNow;
+    return (Refined.bOpenNow || !Filters.bOpenNow) &&
+        FRestaurantTileCache::GetQueryClass(ProviderView) == FRestaurantTileCache::GetQueryClass(Filters);
+}
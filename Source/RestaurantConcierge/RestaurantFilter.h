@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+// The fields FSearchFilters looks at, packed into columns. Ratings and distances
+// are padded to a multiple of four rows so the predicate tests four rows at once.
+struct RESTAURANTCONCIERGE_API FRestaurantFilterColumns
+{
+    enum EFlags : uint8
+    {
+        AcceptsReservations = 1 << 0,
+        Delivery = 1 << 1,
+        Takeout = 1 << 2,
+        HasUtcOffset = 1 << 3,
+        ServicesKnown = 1 << 4, // The three service flags above were reported at all
+    };
+
+    int32 NumRows = 0;
+    TArray<float> Ratings;
+    TArray<float> Distances; // Meters from the search location, 0 without coordinates
+    TArray<uint8> PriceLevels; // 1-4, 0 when unknown
+    TArray<uint8> Flags;
+    TArray<FRestaurantOpenHours> OpenSlots;
+    TArray<int16> UtcOffsetMinutes;
+
+    // Also stores the distances in Restaurants[i].DistanceFromUser
+    void Pack(TArray<FRestaurantData>& Restaurants, FVector2D Location);
+
+    // "$$" -> 2, anything without dollar signs -> 0
+    static uint8 ParsePriceLevel(const FString& PriceLevel);
+};
+
+// An FSearchFilters compiled into plain thresholds and masks. Everything the
+// providers cannot be trusted with (or cannot express at all) is enforced here.
+// Restaurants with unknown price, hours or services (reservations, delivery,
+// takeout; only Yelp reports them) are kept, unknown ratings are not.
+class RESTAURANTCONCIERGE_API FRestaurantFilter
+{
+public:
+    // Captures the current time for the open-now check
+    FRestaurantFilter(const FSearchFilters& Filters, FVector2D InLocation);
+
+    // Indices of the rows that pass, in row order
+    void Evaluate(const FRestaurantFilterColumns& Columns, TArray<int32>& OutRows) const;
+
+    // Removes every restaurant that does not pass and sets DistanceFromUser on the rest
+    void Apply(TArray<FRestaurantData>& Restaurants) const;
+
+    // "$-$$", "$$", "$$$-$$$$"; false for anything else
+    static bool ParsePriceRange(const FString& PriceRange, uint8& OutMin, uint8& OutMax);
+
+private:
+    FVector2D Location;
+    float MinRating = 0.0f;
+    float MaxDistance = 0.0f;
+    uint8 MinPriceLevel = 1;
+    uint8 MaxPriceLevel = 4;
+    uint8 RequiredFlags = 0;
+    bool bOpenNow = false;
+    FDateTime UtcNow;
+    int32 FallbackUtcOffsetMinutes = 0;
+};
+
+// The unfiltered results a search was answered from, kept so refinements of it
+// ("cheaper", "with delivery") can be answered without going back to the providers
+struct RESTAURANTCONCIERGE_API FRestaurantResultSet
+{
+    FVector2D Location = FVector2D::ZeroVector;
+    FSearchFilters Filters;
+
+    // Rows are what the providers answer up to this distance from Location, every
+    // restaurant they know if the search was exhaustive, their top results otherwise
+    float CoveredRadius = 0.0f;
+
+    TArray<FRestaurantData> Rows;
+    FRestaurantFilterColumns Columns;
+
+    FRestaurantResultSet(FVector2D InLocation, const FSearchFilters& InFilters, float InCoveredRadius, const TArray<FRestaurantData>& InRows);
+
+    // True if Refined only narrows what the rows were fetched for
+    bool CanAnswer(const FSearchFilters& Refined) const;
+};
@@ -0,0 +1,113 @@
+#include "RestaurantGeo.h"
+#include "Math/VectorRegister.h"
+
+double FRestaurantGeo::HaversineMeters(const FVector2D& A, const FVector2D& B)
+{
+    const double Lat1 = FMath::DegreesToRadians(static_cast<double>(A.X));
+    const double Lat2 = FMath::DegreesToRadians(static_cast<double>(B.X));
+    const double DeltaLat = Lat2 - Lat1;
+    const double DeltaLng = FMath::DegreesToRadians(static_cast<double>(B.Y - A.Y));
+
+    const double SinLat = FMath::Sin(DeltaLat * 0.5);
+    const double SinLng = FMath::Sin(DeltaLng * 0.5);
+    const double H = SinLat * SinLat + FMath::Cos(Lat1) * FMath::Cos(Lat2) * SinLng * SinLng;
+
+    return 2.0 * EarthRadiusMeters * FMath::Asin(FMath::Min(1.0, FMath::Sqrt(H)));
+}
+
+void FRestaurantGeo::HaversineMetersBatch(const FVector2D& Origin, const double* Latitudes, const double* Longitudes, int32 Num, float* OutMeters)
+{
+    const double OriginLat = FMath::DegreesToRadians(static_cast<double>(Origin.X));
+    const double OriginLng = FMath::DegreesToRadians(static_cast<double>(Origin.Y));
+
+    const VectorRegister4Float CosOriginLat = VectorSetFloat1(static_cast<float>(FMath::Cos(OriginLat)));
+    const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+    const VectorRegister4Float Diameter = VectorSetFloat1(static_cast<float>(2.0 * EarthRadiusMeters));
+
+    for (int32 Base = 0; Base < Num; Base += 4)
+    {
+        const int32 Lanes = FMath::Min(4, Num - Base);
+
+        // The deltas are taken in double so no precision is lost before the narrowing
+        alignas(16) float DeltaLat[4];
+        alignas(16) float DeltaLng[4];
+        alignas(16) float Lat[4];
+        for (int32 Lane = 0; Lane < 4; Lane++)
+        {
+            const int32 Index = Base + FMath::Min(Lane, Lanes - 1);
+            const double PointLat = FMath::DegreesToRadians(Latitudes[Index]);
+            const double PointLng = FMath::DegreesToRadians(Longitudes[Index]);
+            DeltaLat[Lane] = static_cast<float>(PointLat - OriginLat);
+            DeltaLng[Lane] = static_cast<float>(FMath::UnwindRadians(PointLng - OriginLng));
+            Lat[Lane] = static_cast<float>(PointLat);
+        }
+
+        const VectorRegister4Float SinLat = VectorSin(VectorMultiply(VectorLoadAligned(DeltaLat), Half));
+        const VectorRegister4Float SinLng = VectorSin(VectorMultiply(VectorLoadAligned(DeltaLng), Half));
+        const VectorRegister4Float CosLat = VectorCos(VectorLoadAligned(Lat));
+
+        VectorRegister4Float H = VectorMultiplyAdd(VectorMultiply(CosOriginLat, CosLat), VectorMultiply(SinLng, SinLng), VectorMultiply(SinLat, SinLat));
+        H = VectorMin(VectorMax(H, VectorZero()), VectorOne());
+
+        // asin(sqrt(h)) as atan2(sqrt(h), sqrt(1 - h)), which stays accurate near h = 1
+        const VectorRegister4Float Distance = VectorMultiply(Diameter, VectorATan2(VectorSqrt(H), VectorSqrt(VectorSubtract(VectorOne(), H))));
+
+        alignas(16) float Meters[4];
+        VectorStoreAligned(Distance, Meters);
+        for (int32 Lane = 0; Lane < Lanes; Lane++)
+        {
+            OutMeters[Base + Lane] = Meters[Lane];
+        }
+    }
+}
+
+bool FRestaurantGeo::IsValidLocation(const FVector2D& Location)
+{
+    return !Location.IsNearlyZero() &&
+        FMath::Abs(Location.X) <= 90.0 &&
+        FMath::Abs(Location.Y) <= 180.0;
+}
+
+FIntPoint FRestaurantGeo::GetTile(const FVector2D& Location, int32 Level)
+{
+    const double TileCount = static_cast<double>(1 << Level);
+    const double Lat = FMath::DegreesToRadians(FMath::Clamp(static_cast<double>(Location.X), -85.0511, 85.0511));
+    const double X = (Location.Y + 180.0) / 360.0 * TileCount;
+    const double Y = (1.0 - FMath::Loge(FMath::Tan(Lat) + 1.0 / FMath::Cos(Lat)) / UE_DOUBLE_PI) * 0.5 * TileCount;
+
+    const int32 MaxIndex = (1 << Level) - 1;
+    return FIntPoint(
+        FMath::Clamp(FMath::FloorToInt32(X), 0, MaxIndex),
+        FMath::Clamp(FMath::FloorToInt32(Y), 0, MaxIndex));
+}
+
+void FRestaurantGeo::GetTileBounds(const FIntPoint& Tile, int32 Level, FVector2D& OutMin, FVector2D& OutMax)
+{
+    const double TileCount = static_cast<double>(1 << Level);
+
+    auto TileYToLat = [TileCount](double Y)
+    {
+        const double N = UE_DOUBLE_PI * (1.0 - 2.0 * Y / TileCount);
+        return FMath::RadiansToDegrees(FMath::Atan(0.5 * (FMath::Exp(N) - FMath::Exp(-N))));
+    };
+
+    // Tile Y grows southwards
+    OutMin = FVector2D(TileYToLat(Tile.Y + 1), Tile.X / TileCount * 360.0 - 180.0);
+    OutMax = FVector2D(TileYToLat(Tile.Y), (Tile.X + 1) / TileCount * 360.0 - 180.0);
+}
+
+uint64 FRestaurantGeo::EncodeMorton(const FIntPoint& Tile)
+{
+    auto SpreadBits = [](uint64 Value)
+    {
+        Value &= 0xFFFFFFFFull;
+        Value = (Value | (Value << 16)) & 0x0000FFFF0000FFFFull;
+        Value = (Value | (Value << 8)) & 0x00FF00FF00FF00FFull;
+        Value = (Value | (Value << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        Value = (Value | (Value << 2)) & 0x3333333333333333ull;
+        Value = (Value | (Value << 1)) & 0x5555555555555555ull;
+        return Value;
+    };
+
+    return SpreadBits(static_cast<uint32>(Tile.X)) | (SpreadBits(static_cast<uint32>(Tile.Y)) << 1);
+}
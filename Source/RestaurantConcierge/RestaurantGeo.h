@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Geographic helpers for restaurant coordinates.
+// Locations are stored as FVector2D(Latitude, Longitude) in degrees.
+struct RESTAURANTCONCIERGE_API FRestaurantGeo
+{
+    static constexpr double EarthRadiusMeters = 6371008.8;
+    static constexpr double MetersPerDegreeLatitude = 111320.0;
+
+    // Great-circle distance in meters
+    static double HaversineMeters(const FVector2D& A, const FVector2D& B);
+
+    // Distances from Origin to Num points given as separate latitude and longitude
+    // columns, four at a time in single precision. Agrees with HaversineMeters to
+    // well under a meter at city scale.
+    static void HaversineMetersBatch(const FVector2D& Origin, const double* Latitudes, const double* Longitudes, int32 Num, float* OutMeters);
+
+    // Providers report missing coordinates as 0,0
+    static bool IsValidLocation(const FVector2D& Location);
+
+    // Web Mercator (slippy map) tile containing Location at the given zoom level
+    static FIntPoint GetTile(const FVector2D& Location, int32 Level);
+
+    // South-west and north-east corners of a tile, as latitude/longitude
+    static void GetTileBounds(const FIntPoint& Tile, int32 Level, FVector2D& OutMin, FVector2D& OutMax);
+
+    // Interleaves the tile coordinates so nearby tiles get nearby keys
+    static uint64 EncodeMorton(const FIntPoint& Tile);
+};
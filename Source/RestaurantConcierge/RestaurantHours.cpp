@@ -0,0 +1,250 @@
+#include "RestaurantHours.h"
+#include "RestaurantData.h"
+
+namespace
+{
+    const TCHAR* const DayNames[] =
+    {
+        TEXT("Monday"), TEXT("Tuesday"), TEXT("Wednesday"), TEXT("Thursday"), TEXT("Friday"), TEXT("Saturday"), TEXT("Sunday")
+    };
+
+    enum class EMeridiem
+    {
+        None,
+        AM,
+        PM
+    };
+
+    // "9", "9:30", "21:00", "9:30 pm", "noon", "midnight"
+    bool ParseTime(FString Text, int32& OutMinute, EMeridiem& OutMeridiem)
+    {
+        Text.TrimStartAndEndInline();
+        OutMeridiem = EMeridiem::None;
+
+        if (Text == TEXT("noon"))
+        {
+            OutMinute = 12 * 60;
+            OutMeridiem = EMeridiem::PM;
+            return true;
+        }
+        if (Text == TEXT("midnight"))
+        {
+            OutMinute = 0;
+            OutMeridiem = EMeridiem::AM;
+            return true;
+        }
+
+        if (Text.EndsWith(TEXT("am")) || Text.EndsWith(TEXT("pm")))
+        {
+            OutMeridiem = Text.EndsWith(TEXT("am")) ? EMeridiem::AM : EMeridiem::PM;
+            Text.LeftChopInline(2);
+            Text.TrimEndInline();
+        }
+
+        FString HourText = Text, MinuteText;
+        Text.Split(TEXT(":"), &HourText, &MinuteText);
+        if (HourText.IsEmpty() || !HourText.IsNumeric() || (!MinuteText.IsEmpty() && !MinuteText.IsNumeric()))
+        {
+            return false;
+        }
+
+        int32 Hour = FCString::Atoi(*HourText);
+        const int32 Minute = MinuteText.IsEmpty() ? 0 : FCString::Atoi(*MinuteText);
+        if (Hour > 24 || Minute > 59 || (OutMeridiem != EMeridiem::None && (Hour < 1 || Hour > 12)))
+        {
+            return false;
+        }
+
+        if (OutMeridiem != EMeridiem::None)
+        {
+            Hour = (Hour % 12) + (OutMeridiem == EMeridiem::PM ? 12 : 0);
+        }
+
+        OutMinute = Hour * 60 + Minute;
+        return true;
+    }
+
+    int32 ApplyMeridiem(int32 Minute, EMeridiem Meridiem)
+    {
+        const int32 Hour12 = (Minute / 60) % 12;
+        return Hour12 * 60 + Minute % 60 + (Meridiem == EMeridiem::PM ? 12 * 60 : 0);
+    }
+}
+
+void FRestaurantOpenHours::AddSpan(int32 Day, int32 StartMinute, int32 EndMinute)
+{
+    if (EndMinute <= StartMinute)
+    {
+        EndMinute += MinutesPerDay;
+    }
+
+    // A slot counts as open if the restaurant is open at its start
+    const int32 FirstSlot = Day * SlotsPerDay + StartMinute / SlotMinutes;
+    const int32 EndSlot = Day * SlotsPerDay + (EndMinute + SlotMinutes - 1) / SlotMinutes;
+    for (int32 Slot = FirstSlot; Slot < EndSlot; Slot++)
+    {
+        const int32 Wrapped = Slot % SlotsPerWeek;
+        Slots[Wrapped >> 6] |= 1ull << (Wrapped & 63);
+    }
+}
+
+bool FRestaurantOpenHours::IsOpenNearObservation(const FDateTime& UtcTime) const
+{
+    if (OpenNowObservedAt == FDateTime() || FMath::Abs((UtcTime - OpenNowObservedAt).GetTotalMinutes()) > OpenNowValidMinutes)
+    {
+        return true;
+    }
+    return bOpenNow;
+}
+
+void FRestaurantOpenHours::SetAlwaysOpen()
+{
+    for (int32 Word = 0; Word < NumWords; Word++)
+    {
+        const int32 BitsInWord = FMath::Min(64, SlotsPerWeek - Word * 64);
+        Slots[Word] = BitsInWord == 64 ? ~0ull : (1ull << BitsInWord) - 1;
+    }
+    bKnown = true;
+}
+
+void FRestaurantOpenHours::ToLocal(const FDateTime& UtcTime, int32 UtcOffsetMinutes, int32& OutDay, int32& OutMinuteOfDay)
+{
+    const FDateTime Local = UtcTime + FTimespan::FromMinutes(UtcOffsetMinutes);
+    OutDay = static_cast<int32>(Local.GetDayOfWeek());
+    OutMinuteOfDay = Local.GetHour() * 60 + Local.GetMinute();
+}
+
+int32 FRestaurantOpenHours::GetLocalUtcOffsetMinutes()
+{
+    // Rounded to whole quarter hours, the two clocks are not read at the same instant
+    const double OffsetMinutes = (FDateTime::Now() - FDateTime::UtcNow()).GetTotalMinutes();
+    return FMath::RoundToInt(OffsetMinutes / SlotMinutes) * SlotMinutes;
+}
+
+bool FRestaurantOpenHours::ParseDayText(const FString& Text, TArray<TPair<int32, int32>>& OutSpans)
+{
+    OutSpans.Reset();
+
+    FString Normalized = Text.ToLower();
+    Normalized.TrimStartAndEndInline();
+    if (Normalized.IsEmpty() || Normalized == TEXT("closed"))
+    {
+        return true;
+    }
+    if (Normalized.Contains(TEXT("24 hours")))
+    {
+        OutSpans.Emplace(0, MinutesPerDay);
+        return true;
+    }
+
+    // Providers use hyphens, en and em dashes and narrow no-break spaces interchangeably
+    Normalized.ReplaceCharInline(TEXT('\u2013'), TEXT('-'));
+    Normalized.ReplaceCharInline(TEXT('\u2014'), TEXT('-'));
+    Normalized.ReplaceCharInline(TEXT('\u00A0'), TEXT(' '));
+    Normalized.ReplaceCharInline(TEXT('\u202F'), TEXT(' '));
+    Normalized.ReplaceInline(TEXT("a.m."), TEXT("am"));
+    Normalized.ReplaceInline(TEXT("p.m."), TEXT("pm"));
+
+    TArray<FString> Ranges;
+    Normalized.ParseIntoArray(Ranges, TEXT(","));
+    for (const FString& Range : Ranges)
+    {
+        FString StartText, EndText;
+        if (!Range.Split(TEXT("-"), &StartText, &EndText))
+        {
+            return false;
+        }
+
+        int32 Start = 0, End = 0;
+        EMeridiem StartMeridiem, EndMeridiem;
+        if (!ParseTime(StartText, Start, StartMeridiem) || !ParseTime(EndText, End, EndMeridiem))
+        {
+            return false;
+        }
+
+        // "5:00 - 10:00 PM": the start shares the end's meridiem unless that puts it after the end
+        if (StartMeridiem == EMeridiem::None && EndMeridiem != EMeridiem::None && Start <= 12 * 60)
+        {
+            Start = ApplyMeridiem(Start, EndMeridiem);
+            if (Start > End && EndMeridiem == EMeridiem::PM)
+            {
+                Start -= 12 * 60;
+            }
+        }
+
+        OutSpans.Emplace(Start % MinutesPerDay, End == 0 ? MinutesPerDay : End);
+    }
+
+    return true;
+}
+
+FString FRestaurantOpenHours::FormatMinute(int32 MinuteOfDay)
+{
+    MinuteOfDay %= MinutesPerDay;
+    const int32 Hour = MinuteOfDay / 60;
+    const int32 Hour12 = Hour % 12 == 0 ? 12 : Hour % 12;
+    return FString::Printf(TEXT("%d:%02d %s"), Hour12, MinuteOfDay % 60, Hour < 12 ? TEXT("AM") : TEXT("PM"));
+}
+
+const TCHAR* FRestaurantOpenHours::GetDayName(int32 Day)
+{
+    return DayNames[Day];
+}
+
+void FOperatingHours::RebuildOpenSlots()
+{
+    // The open_now observation does not come from the fields above, keep it
+    const FRestaurantOpenHours Previous = OpenSlots;
+    OpenSlots = FRestaurantOpenHours();
+    OpenSlots.SetOpenNow(Previous.bOpenNow, Previous.OpenNowObservedAt);
+
+    if (bTemporarilyClosed)
+    {
+        OpenSlots.bKnown = true;
+        return;
+    }
+    if (bOpen24Hours)
+    {
+        OpenSlots.SetAlwaysOpen();
+        return;
+    }
+
+    // No days, or "Closed" on every one, means unknown rather than never open
+    bool bAnyOpen = false;
+    TArray<TPair<int32, int32>> Spans;
+    for (int32 Day = 0; Day < 7; Day++)
+    {
+        const FString* DayText = WeeklyHours.Find(FRestaurantOpenHours::GetDayName(Day));
+        if (!DayText)
+        {
+            continue;
+        }
+
+        if (!FRestaurantOpenHours::ParseDayText(*DayText, Spans))
+        {
+            OpenSlots = FRestaurantOpenHours();
+            OpenSlots.SetOpenNow(Previous.bOpenNow, Previous.OpenNowObservedAt);
+            return;
+        }
+
+        for (const TPair<int32, int32>& Span : Spans)
+        {
+            OpenSlots.AddSpan(Day, Span.Key, Span.Value);
+            bAnyOpen = true;
+        }
+    }
+
+    OpenSlots.bKnown = bAnyOpen;
+}
+
+bool FOperatingHours::IsOpenAt(const FDateTime& UtcTime, int32 FallbackUtcOffsetMinutes) const
+{
+    if (!OpenSlots.bKnown)
+    {
+        return OpenSlots.IsOpenNearObservation(UtcTime);
+    }
+
+    int32 Day = 0, MinuteOfDay = 0;
+    FRestaurantOpenHours::ToLocal(UtcTime, bHasUtcOffset ? UtcOffsetMinutes : FallbackUtcOffsetMinutes, Day, MinuteOfDay);
+    return OpenSlots.IsOpenAtLocal(Day, MinuteOfDay);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Weekly opening hours as a bitmask of 15 minute slots in the restaurant's local
+// time, Monday 00:00 first. Built once from the provider data; afterwards "open
+// now" or "open at 8pm Friday" is a single bit test.
+struct RESTAURANTCONCIERGE_API FRestaurantOpenHours
+{
+    static constexpr int32 SlotMinutes = 15;
+    static constexpr int32 MinutesPerDay = 24 * 60;
+    static constexpr int32 SlotsPerDay = MinutesPerDay / SlotMinutes;
+    static constexpr int32 SlotsPerWeek = 7 * SlotsPerDay;
+    static constexpr int32 NumWords = (SlotsPerWeek + 63) / 64;
+
+    // How long an open_now observation is trusted either side of when it was made
+    static constexpr int32 OpenNowValidMinutes = 60;
+
+    uint64 Slots[NumWords] = {};
+
+    // Nothing is known about the hours. Such restaurants are never treated as closed.
+    bool bKnown = false;
+
+    // Search results without periods only say whether the restaurant was open when
+    // they were fetched. While the slots are unknown that stands in for nearby times.
+    FDateTime OpenNowObservedAt; // UTC, default if never observed
+    bool bOpenNow = false;
+
+    // Day 0 is Monday. A span that ends at or before its start runs past midnight
+    // into the next day, Sunday wraps around to Monday.
+    void AddSpan(int32 Day, int32 StartMinute, int32 EndMinute);
+    void SetAlwaysOpen();
+
+    bool IsOpenAtLocal(int32 Day, int32 MinuteOfDay) const
+    {
+        const int32 Slot = Day * SlotsPerDay + MinuteOfDay / SlotMinutes;
+        return ((Slots[Slot >> 6] >> (Slot & 63)) & 1) != 0;
+    }
+
+    // For unknown slots: the open_now observation if it was made close to UtcTime, otherwise open
+    bool IsOpenNearObservation(const FDateTime& UtcTime) const;
+
+    void SetOpenNow(bool bInOpenNow, const FDateTime& UtcTime)
+    {
+        bOpenNow = bInOpenNow;
+        OpenNowObservedAt = UtcTime;
+    }
+
+    // Splits a UTC time into the local day (0 = Monday) and minute of day
+    static void ToLocal(const FDateTime& UtcTime, int32 UtcOffsetMinutes, int32& OutDay, int32& OutMinuteOfDay);
+
+    // UTC offset of this machine, used for restaurants whose provider reports none
+    static int32 GetLocalUtcOffsetMinutes();
+
+    // Parses one day of display text such as "9:00 AM - 10:00 PM",
+    // "11:30 AM - 2:30 PM, 5:00 - 10:00 PM", "Closed" or "Open 24 hours".
+    // Returns false if the text is not understood.
+    static bool ParseDayText(const FString& Text, TArray<TPair<int32, int32>>& OutSpans);
+
+    // "9:00 AM" style, the format ParseDayText reads back
+    static FString FormatMinute(int32 MinuteOfDay);
+
+    // Key used by FOperatingHours::WeeklyHours
+    static const TCHAR* GetDayName(int32 Day);
+};
@@ -0,0 +1,230 @@
+#include "RestaurantHttpClient.h"
+#include "RestaurantProvider.h"
+#include "HAL/PlatformTime.h"
+
+bool FRestaurantCircuitBreaker::AllowRequest(double Now, double CooldownSeconds)
+{
+    switch (State)
+    {
+    case EState::Closed:
+        return true;
+
+    case EState::Open:
+        if (Now - OpenedAt < CooldownSeconds)
+        {
+            return false;
+        }
+        State = EState::HalfOpen;
+        bProbeInFlight = true;
+        return true;
+
+    case EState::HalfOpen:
+    default:
+        // Only one probe at a time, everyone else keeps failing fast until it reports back
+        if (bProbeInFlight)
+        {
+            return false;
+        }
+        bProbeInFlight = true;
+        return true;
+    }
+}
+
+void FRestaurantCircuitBreaker::RecordSuccess()
+{
+    State = EState::Closed;
+    ConsecutiveFailures = 0;
+    bProbeInFlight = false;
+}
+
+void FRestaurantCircuitBreaker::RecordFailure(double Now, int32 FailureThreshold)
+{
+    ConsecutiveFailures++;
+    bProbeInFlight = false;
+
+    if (State == EState::HalfOpen || (FailureThreshold > 0 && ConsecutiveFailures >= FailureThreshold))
+    {
+        State = EState::Open;
+        OpenedAt = Now;
+    }
+}
+
+bool FRestaurantRetryBudget::TryConsume()
+{
+    if (Tokens < 1.0f)
+    {
+        return false;
+    }
+
+    Tokens -= 1.0f;
+    return true;
+}
+
+bool FRestaurantHttpClient::IsAvailable(const FString& Endpoint, const FRestaurantProviderPolicy& Policy)
+{
+    FEndpoint& State = Endpoints.FindOrAdd(Endpoint);
+    const bool bAllowed = State.Breaker.AllowRequest(FPlatformTime::Seconds(), Policy.CircuitCooldownSeconds);
+    if (bAllowed && State.Breaker.GetState() == FRestaurantCircuitBreaker::EState::HalfOpen)
+    {
+        UE_LOG(LogTemp, Log, TEXT("%s circuit is half open, probing"), *Endpoint);
+        State.bProbeReserved = true;
+    }
+    return bAllowed;
+}
+
+void FRestaurantHttpClient::Send(const FString& Endpoint, TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request, const FRestaurantProviderPolicy& Policy,
+    bool bExtraAttempt, FHttpRequestCompleteDelegate OnComplete)
+{
+    FEndpoint& EndpointState = Endpoints.FindOrAdd(Endpoint);
+    if (!bExtraAttempt)
+    {
+        EndpointState.RetryBudget.OnFirstAttempt();
+    }
+
+    TSharedRef<FRequestState, ESPMode::ThreadSafe> State = MakeShared<FRequestState, ESPMode::ThreadSafe>();
+    State->Endpoint = Endpoint;
+    State->bProbe = EndpointState.bProbeReserved;
+    EndpointState.bProbeReserved = false;
+    State->FailureThreshold = Policy.CircuitFailureThreshold;
+    State->OnComplete = MoveTemp(OnComplete);
+    InFlight.Add(&Request.Get(), State);
+
+    Request->SetHeader(TEXT("Connection"), TEXT("keep-alive"));
+    if (Policy.TimeoutSeconds > 0.0f)
+    {
+        Request->SetTimeout(Policy.TimeoutSeconds);
+    }
+    Request->OnProcessRequestComplete().BindSP(AsShared(), &FRestaurantHttpClient::OnRequestComplete, State);
+
+    // The engine reports no connection events, so the earliest sign of life is the first response byte
+    if (Policy.FirstByteTimeoutSeconds > 0.0f && Policy.FirstByteTimeoutSeconds < Policy.TimeoutSeconds)
+    {
+        TWeakPtr<FRequestState, ESPMode::ThreadSafe> WeakState = State;
+        Request->OnRequestProgress().BindLambda([WeakState](FHttpRequestPtr, int32, int32 BytesReceived)
+        {
+            TSharedPtr<FRequestState, ESPMode::ThreadSafe> Pinned = WeakState.Pin();
+            if (Pinned.IsValid() && BytesReceived > 0)
+            {
+                Pinned->bReceivedBytes = true;
+            }
+        });
+
+        TWeakPtr<IHttpRequest, ESPMode::ThreadSafe> WeakRequest = Request;
+        State->FirstByteWatchdog = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakState, WeakRequest](float)
+        {
+            TSharedPtr<FRequestState, ESPMode::ThreadSafe> Pinned = WeakState.Pin();
+            TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> PinnedRequest = WeakRequest.Pin();
+            if (Pinned.IsValid() && PinnedRequest.IsValid() && !Pinned->bReceivedBytes)
+            {
+                Pinned->FirstByteWatchdog.Reset();
+                UE_LOG(LogTemp, Log, TEXT("%s request got no response within the first byte timeout"), *Pinned->Endpoint);
+                PinnedRequest->CancelRequest();
+            }
+            return false;
+        }), Policy.FirstByteTimeoutSeconds);
+    }
+
+    Request->ProcessRequest();
+}
+
+void FRestaurantHttpClient::Cancel(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request)
+{
+    if (TSharedRef<FRequestState, ESPMode::ThreadSafe>* State = InFlight.Find(&Request.Get()))
+    {
+        (*State)->bCancelled = true;
+    }
+    Request->CancelRequest();
+}
+
+void FRestaurantHttpClient::ReleaseReservedProbe(const FString& Endpoint)
+{
+    FEndpoint* State = Endpoints.Find(Endpoint);
+    if (State && State->bProbeReserved)
+    {
+        State->bProbeReserved = false;
+        State->Breaker.ReleaseProbe();
+    }
+}
+
+bool FRestaurantHttpClient::TryRetry(const FString& Endpoint)
+{
+    return Endpoints.FindOrAdd(Endpoint).RetryBudget.TryConsume();
+}
+
+void FRestaurantHttpClient::RecordFailure(const FString& Endpoint, const FRestaurantProviderPolicy& Policy)
+{
+    FRestaurantCircuitBreaker& Breaker = Endpoints.FindOrAdd(Endpoint).Breaker;
+    const bool bWasOpen = Breaker.GetState() != FRestaurantCircuitBreaker::EState::Closed;
+    Breaker.RecordFailure(FPlatformTime::Seconds(), Policy.CircuitFailureThreshold);
+    if (!bWasOpen && Breaker.GetState() == FRestaurantCircuitBreaker::EState::Open)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("%s circuit opened after repeated failures, skipping it for now"), *Endpoint);
+    }
+}
+
+float FRestaurantHttpClient::GetRetryDelay(const FRestaurantProviderPolicy& Policy, int32 Attempt)
+{
+    const float Backoff = Policy.RetryBaseDelaySeconds * FMath::Pow(2.0f, static_cast<float>(FMath::Max(Attempt - 1, 0)));
+    return Backoff * FMath::FRandRange(0.5f, 1.5f);
+}
+
+ERestaurantHttpResult FRestaurantHttpClient::Classify(FHttpResponsePtr Response, bool bWasSuccessful)
+{
+    if (!bWasSuccessful || !Response.IsValid())
+    {
+        return ERestaurantHttpResult::RetryableFailure;
+    }
+
+    const int32 Code = Response->GetResponseCode();
+    if (EHttpResponseCodes::IsOk(Code))
+    {
+        return ERestaurantHttpResult::Success;
+    }
+    if (Code == EHttpResponseCodes::TooManyRequests || Code >= 500)
+    {
+        return ERestaurantHttpResult::RetryableFailure;
+    }
+    return ERestaurantHttpResult::Failure;
+}
+
+void FRestaurantHttpClient::OnRequestComplete(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, TSharedRef<FRequestState, ESPMode::ThreadSafe> State)
+{
+    InFlight.Remove(Request.Get());
+    if (State->FirstByteWatchdog.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(State->FirstByteWatchdog);
+        State->FirstByteWatchdog.Reset();
+    }
+
+    // Hedges that lost and searches that were abandoned say nothing about the endpoint
+    if (State->bCancelled)
+    {
+        if (State->bProbe)
+        {
+            Endpoints.FindOrAdd(State->Endpoint).Breaker.ReleaseProbe();
+        }
+        return;
+    }
+
+    FEndpoint& Endpoint = Endpoints.FindOrAdd(State->Endpoint);
+    const bool bWasOpen = Endpoint.Breaker.GetState() != FRestaurantCircuitBreaker::EState::Closed;
+    if (Classify(Response, bWasSuccessful) == ERestaurantHttpResult::RetryableFailure)
+    {
+        Endpoint.Breaker.RecordFailure(FPlatformTime::Seconds(), State->FailureThreshold);
+        if (!bWasOpen && Endpoint.Breaker.GetState() == FRestaurantCircuitBreaker::EState::Open)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("%s circuit opened after repeated failures, skipping it for now"), *State->Endpoint);
+        }
+    }
+    else
+    {
+        // A 4xx is the caller's problem, the endpoint itself is up
+        Endpoint.Breaker.RecordSuccess();
+        if (bWasOpen)
+        {
+            UE_LOG(LogTemp, Log, TEXT("%s circuit closed, endpoint recovered"), *State->Endpoint);
+        }
+    }
+
+    State->OnComplete.ExecuteIfBound(Request, Response, bWasSuccessful);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Containers/Ticker.h"
+
+struct FRestaurantProviderPolicy;
+
+// How a finished request went, as far as retries and failure tracking are concerned
+enum class ERestaurantHttpResult : uint8
+{
+    Success,
+    // Transport error, timeout, 429 or 5xx: worth another attempt
+    RetryableFailure,
+    // Any other non-2xx status, e.g. a rejected API key: retrying will not help
+    Failure
+};
+
+// Trips after a run of failed requests. While open every request fails fast
+// instead of waiting out its timeout; after the cooldown a single probe request
+// is let through and its outcome closes or re-opens the circuit.
+class RESTAURANTCONCIERGE_API FRestaurantCircuitBreaker
+{
+public:
+    enum class EState : uint8
+    {
+        Closed,
+        Open,
+        HalfOpen
+    };
+
+    bool AllowRequest(double Now, double CooldownSeconds);
+    void RecordSuccess();
+    void RecordFailure(double Now, int32 FailureThreshold);
+
+    // A request was abandoned without an outcome; if it was the probe, allow another
+    void ReleaseProbe() { bProbeInFlight = false; }
+
+    EState GetState() const { return State; }
+
+private:
+    EState State = EState::Closed;
+    int32 ConsecutiveFailures = 0;
+    double OpenedAt = 0.0;
+    bool bProbeInFlight = false;
+};
+
+// Caps retries and hedges at a fraction of first attempts. Every first attempt
+// earns RetryRatio of a token, every extra attempt spends a whole one, so a
+// failing upstream never sees more than (1 + RetryRatio) times its normal load.
+class RESTAURANTCONCIERGE_API FRestaurantRetryBudget
+{
+public:
+    static constexpr float RetryRatio = 0.2f;
+    static constexpr float MaxTokens = 10.0f;
+
+    void OnFirstAttempt() { Tokens = FMath::Min(MaxTokens, Tokens + RetryRatio); }
+    bool TryConsume();
+
+private:
+    float Tokens = MaxTokens;
+};
+
+// Shared transport for every provider request. Applies the provider policy's
+// timeouts, tracks health per endpoint (a provider name) and spends retries from
+// a per-endpoint budget. Connections are kept alive and pooled per host by the
+// engine's curl backend, all requests here go through that one pool.
+class RESTAURANTCONCIERGE_API FRestaurantHttpClient : public TSharedFromThis<FRestaurantHttpClient, ESPMode::ThreadSafe>
+{
+public:
+    // False while the endpoint's circuit is open; callers should leave it out
+    // rather than wait on it. A true answer after the cooldown reserves the probe.
+    bool IsAvailable(const FString& Endpoint, const FRestaurantProviderPolicy& Policy);
+
+    // Sends Request. OnComplete fires once on the game thread, unless the request
+    // is cancelled through Cancel. Do not bind the request's own completion delegate.
+    // bExtraAttempt marks hedges and retries, which the retry budget must allow first.
+    void Send(const FString& Endpoint, TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request, const FRestaurantProviderPolicy& Policy,
+        bool bExtraAttempt, FHttpRequestCompleteDelegate OnComplete);
+
+    // Aborts a request without counting it against its endpoint's health
+    void Cancel(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request);
+
+    // Gives back a probe reserved by IsAvailable whose request was never sent
+    void ReleaseReservedProbe(const FString& Endpoint);
+
+    // Spends one retry from the endpoint's budget
+    bool TryRetry(const FString& Endpoint);
+
+    // Counts a request that completed but failed by its content against the endpoint's health
+    void RecordFailure(const FString& Endpoint, const FRestaurantProviderPolicy& Policy);
+
+    // Exponential backoff, jittered by up to half either way
+    static float GetRetryDelay(const FRestaurantProviderPolicy& Policy, int32 Attempt);
+
+    static ERestaurantHttpResult Classify(FHttpResponsePtr Response, bool bWasSuccessful);
+
+private:
+    struct FEndpoint
+    {
+        FRestaurantCircuitBreaker Breaker;
+        FRestaurantRetryBudget RetryBudget;
+
+        // IsAvailable handed out the probe, the next request sent carries it
+        bool bProbeReserved = false;
+    };
+
+    struct FRequestState
+    {
+        FString Endpoint;
+        int32 FailureThreshold = 0;
+        FHttpRequestCompleteDelegate OnComplete;
+        FTSTicker::FDelegateHandle FirstByteWatchdog;
+        bool bReceivedBytes = false;
+        bool bCancelled = false;
+        bool bProbe = false;
+    };
+
+    void OnRequestComplete(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, TSharedRef<FRequestState, ESPMode::ThreadSafe> State);
+
+    TMap<FString, FEndpoint> Endpoints;
+    TMap<const IHttpRequest*, TSharedRef<FRequestState, ESPMode::ThreadSafe>> InFlight;
+};
@@ -0,0 +1,974 @@
+#include "RestaurantJsonParser.h"
+
+FRestaurantJsonCursor::FRestaurantJsonCursor(const uint8* InData, int32 InNum)
+    : Data(InData)
+    , Num(InNum)
+{
+    // Skip a UTF-8 byte order mark
+    if (Num >= 3 && Data[0] == 0xEF && Data[1] == 0xBB && Data[2] == 0xBF)
+    {
+        Pos = 3;
+    }
+}
+
+bool FRestaurantJsonCursor::KeyIs(FAnsiStringView Key, const ANSICHAR* Literal)
+{
+    const int32 LiteralLen = FCStringAnsi::Strlen(Literal);
+    return Key.Len() == LiteralLen && FMemory::Memcmp(Key.GetData(), Literal, LiteralLen) == 0;
+}
+
+bool FRestaurantJsonCursor::Fail()
+{
+    bError = true;
+    return false;
+}
+
+void FRestaurantJsonCursor::SkipWhitespace()
+{
+    while (Pos < Num && (Data[Pos] == ' ' || Data[Pos] == '\n' || Data[Pos] == '\r' || Data[Pos] == '\t'))
+    {
+        Pos++;
+    }
+}
+
+bool FRestaurantJsonCursor::Expect(ANSICHAR Char)
+{
+    SkipWhitespace();
+    if (Pos < Num && Data[Pos] == static_cast<uint8>(Char))
+    {
+        Pos++;
+        return true;
+    }
+    return Fail();
+}
+
+bool FRestaurantJsonCursor::MatchLiteral(const ANSICHAR* Literal)
+{
+    const int32 LiteralLen = FCStringAnsi::Strlen(Literal);
+    if (Pos + LiteralLen <= Num && FMemory::Memcmp(Data + Pos, Literal, LiteralLen) == 0)
+    {
+        Pos += LiteralLen;
+        return true;
+    }
+    return false;
+}
+
+bool FRestaurantJsonCursor::ForEachMember(TFunctionRef<bool(FAnsiStringView Key)> Visitor)
+{
+    if (!Expect('{'))
+    {
+        return false;
+    }
+
+    SkipWhitespace();
+    if (Pos < Num && Data[Pos] == '}')
+    {
+        Pos++;
+        return true;
+    }
+
+    while (true)
+    {
+        if (!Expect('"'))
+        {
+            return false;
+        }
+
+        // Keys are compared raw, escaped keys never match a literal
+        const int32 KeyStart = Pos;
+        while (Pos < Num && Data[Pos] != '"')
+        {
+            Pos += (Data[Pos] == '\\') ? 2 : 1;
+        }
+        if (Pos >= Num)
+        {
+            return Fail();
+        }
+
+        const FAnsiStringView Key(reinterpret_cast<const ANSICHAR*>(Data + KeyStart), Pos - KeyStart);
+        Pos++;
+
+        if (!Expect(':') || !Visitor(Key) || bError)
+        {
+            return Fail();
+        }
+
+        SkipWhitespace();
+        if (Pos >= Num)
+        {
+            return Fail();
+        }
+        if (Data[Pos] == ',')
+        {
+            Pos++;
+            continue;
+        }
+        if (Data[Pos] == '}')
+        {
+            Pos++;
+            return true;
+        }
+        return Fail();
+    }
+}
+
+bool FRestaurantJsonCursor::ForEachElement(TFunctionRef<bool()> Visitor)
+{
+    if (!Expect('['))
+    {
+        return false;
+    }
+
+    SkipWhitespace();
+    if (Pos < Num && Data[Pos] == ']')
+    {
+        Pos++;
+        return true;
+    }
+
+    while (true)
+    {
+        if (!Visitor() || bError)
+        {
+            return Fail();
+        }
+
+        SkipWhitespace();
+        if (Pos >= Num)
+        {
+            return Fail();
+        }
+        if (Data[Pos] == ',')
+        {
+            Pos++;
+            continue;
+        }
+        if (Data[Pos] == ']')
+        {
+            Pos++;
+            return true;
+        }
+        return Fail();
+    }
+}
+
+bool FRestaurantJsonCursor::TryReadNull()
+{
+    SkipWhitespace();
+    return MatchLiteral("null");
+}
+
+bool FRestaurantJsonCursor::ReadHex4(uint32& OutValue)
+{
+    if (Pos + 4 > Num)
+    {
+        return false;
+    }
+
+    OutValue = 0;
+    for (int32 i = 0; i < 4; i++)
+    {
+        const uint8 C = Data[Pos++];
+        OutValue <<= 4;
+        if (C >= '0' && C <= '9')
+        {
+            OutValue |= C - '0';
+        }
+        else if (C >= 'a' && C <= 'f')
+        {
+            OutValue |= C - 'a' + 10;
+        }
+        else if (C >= 'A' && C <= 'F')
+        {
+            OutValue |= C - 'A' + 10;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FRestaurantJsonCursor::ReadString(FString& OutValue)
+{
+    if (TryReadNull())
+    {
+        return true;
+    }
+
+    if (!Expect('"'))
+    {
+        return false;
+    }
+
+    OutValue.Reset();
+
+    // Unescaped runs are converted from UTF-8 in one go
+    int32 RunStart = Pos;
+    auto FlushRun = [this, &OutValue, &RunStart]()
+    {
+        if (Pos > RunStart)
+        {
+            const auto Converted = StringCast<TCHAR>(reinterpret_cast<const UTF8CHAR*>(Data + RunStart), Pos - RunStart);
+            OutValue.Append(Converted.Get(), Converted.Length());
+        }
+    };
+
+    while (Pos < Num)
+    {
+        const uint8 C = Data[Pos];
+
+        if (C == '"')
+        {
+            FlushRun();
+            Pos++;
+            return true;
+        }
+
+        if (C != '\\')
+        {
+            Pos++;
+            continue;
+        }
+
+        FlushRun();
+        if (Pos + 1 >= Num)
+        {
+            return Fail();
+        }
+
+        const uint8 Escape = Data[Pos + 1];
+        Pos += 2;
+
+        switch (Escape)
+        {
+        case '"': OutValue.AppendChar(TEXT('"')); break;
+        case '\\': OutValue.AppendChar(TEXT('\\')); break;
+        case '/': OutValue.AppendChar(TEXT('/')); break;
+        case 'b': OutValue.AppendChar(TEXT('\b')); break;
+        case 'f': OutValue.AppendChar(TEXT('\f')); break;
+        case 'n': OutValue.AppendChar(TEXT('\n')); break;
+        case 'r': OutValue.AppendChar(TEXT('\r')); break;
+        case 't': OutValue.AppendChar(TEXT('\t')); break;
+        case 'u':
+        {
+            uint32 CodePoint = 0;
+            if (!ReadHex4(CodePoint))
+            {
+                return Fail();
+            }
+
+            // Surrogate pair
+            if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF && Pos + 1 < Num && Data[Pos] == '\\' && Data[Pos + 1] == 'u')
+            {
+                Pos += 2;
+                uint32 Low = 0;
+                if (!ReadHex4(Low))
+                {
+                    return Fail();
+                }
+                CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+            }
+
+            if (CodePoint > 0xFFFF && sizeof(TCHAR) == 2)
+            {
+                CodePoint -= 0x10000;
+                OutValue.AppendChar(static_cast<TCHAR>(0xD800 + (CodePoint >> 10)));
+                OutValue.AppendChar(static_cast<TCHAR>(0xDC00 + (CodePoint & 0x3FF)));
+            }
+            else
+            {
+                OutValue.AppendChar(static_cast<TCHAR>(CodePoint));
+            }
+            break;
+        }
+        default:
+            return Fail();
+        }
+
+        RunStart = Pos;
+    }
+
+    return Fail();
+}
+
+bool FRestaurantJsonCursor::ReadNumber(double& OutValue)
+{
+    if (TryReadNull())
+    {
+        return true;
+    }
+
+    const int32 Start = Pos;
+    while (Pos < Num)
+    {
+        const uint8 C = Data[Pos];
+        if ((C >= '0' && C <= '9') || C == '-' || C == '+' || C == '.' || C == 'e' || C == 'E')
+        {
+            Pos++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    const int32 Len = Pos - Start;
+    ANSICHAR Buffer[64];
+    if (Len == 0 || Len >= UE_ARRAY_COUNT(Buffer))
+    {
+        return Fail();
+    }
+
+    FMemory::Memcpy(Buffer, Data + Start, Len);
+    Buffer[Len] = '\0';
+    OutValue = FCStringAnsi::Atod(Buffer);
+    return true;
+}
+
+bool FRestaurantJsonCursor::ReadBool(bool& OutValue)
+{
+    SkipWhitespace();
+    if (MatchLiteral("true"))
+    {
+        OutValue = true;
+        return true;
+    }
+    if (MatchLiteral("false"))
+    {
+        OutValue = false;
+        return true;
+    }
+    return MatchLiteral("null") || Fail();
+}
+
+bool FRestaurantJsonCursor::SkipValue()
+{
+    SkipWhitespace();
+    if (Pos >= Num)
+    {
+        return Fail();
+    }
+
+    switch (Data[Pos])
+    {
+    case '{':
+        return ForEachMember([this](FAnsiStringView) { return SkipValue(); });
+    case '[':
+        return ForEachElement([this]() { return SkipValue(); });
+    case '"':
+        Pos++;
+        while (Pos < Num && Data[Pos] != '"')
+        {
+            Pos += (Data[Pos] == '\\') ? 2 : 1;
+        }
+        if (Pos >= Num)
+        {
+            return Fail();
+        }
+        Pos++;
+        return true;
+    case 't':
+    case 'f':
+    {
+        bool Unused;
+        return ReadBool(Unused);
+    }
+    case 'n':
+        return TryReadNull() || Fail();
+    default:
+    {
+        double Unused;
+        return ReadNumber(Unused);
+    }
+    }
+}
+
+namespace
+{
+    // "1730" -> minute of day
+    int32 ParseClockTime(const FString& Text)
+    {
+        const int32 Value = FCString::Atoi(*Text);
+        return FMath::Clamp((Value / 100) * 60 + Value % 100, 0, FRestaurantOpenHours::MinutesPerDay);
+    }
+
+    // Collects the open spans of a week and writes both the display text and the slot mask
+    struct FWeeklyHoursBuilder
+    {
+        FString DayText[7];
+        bool bAnyOpen = false;
+
+        // Day 0 is Monday. An end at or before the start is an overnight span, AddSpan carries it into the next day.
+        void Add(FOperatingHours& Hours, int32 Day, int32 StartMinute, int32 EndMinute)
+        {
+            Hours.OpenSlots.AddSpan(Day, StartMinute, EndMinute);
+            const FString Range = FRestaurantOpenHours::FormatMinute(StartMinute) + TEXT(" - ") + FRestaurantOpenHours::FormatMinute(EndMinute);
+            DayText[Day] = DayText[Day].IsEmpty() ? Range : DayText[Day] + TEXT(", ") + Range;
+            bAnyOpen = true;
+        }
+
+        void Finish(FOperatingHours& Hours) const
+        {
+            if (!bAnyOpen)
+            {
+                return;
+            }
+            // Days without a span are left out, OpenSlots.bKnown makes them read as closed
+            for (int32 Day = 0; Day < 7; Day++)
+            {
+                if (!DayText[Day].IsEmpty())
+                {
+                    Hours.WeeklyHours.Add(FRestaurantOpenHours::GetDayName(Day), DayText[Day]);
+                }
+            }
+            Hours.OpenSlots.bKnown = true;
+        }
+    };
+
+    // opening_hours: { "periods": [{ "open": { "day": 0, "time": "1100" }, "close": { "day": 0, "time": "2200" } }] }
+    // with day 0 being Sunday. Search results only carry open_now, kept for when periods are missing.
+    bool ParseGoogleOpeningHours(FRestaurantJsonCursor& Cursor, FOperatingHours& Hours)
+    {
+        FWeeklyHoursBuilder Builder;
+        bool bAlwaysOpen = false;
+
+        const bool bRead = Cursor.ForEachMember([&](FAnsiStringView Key)
+        {
+            if (FRestaurantJsonCursor::KeyIs(Key, "open_now"))
+            {
+                bool bOpenNow = false;
+                const bool bReadOpenNow = Cursor.TryReadNull() || Cursor.ReadBool(bOpenNow);
+                if (bReadOpenNow)
+                {
+                    Hours.OpenSlots.SetOpenNow(bOpenNow, FDateTime::UtcNow());
+                }
+                return bReadOpenNow;
+            }
+            if (!FRestaurantJsonCursor::KeyIs(Key, "periods"))
+            {
+                return Cursor.SkipValue();
+            }
+
+            return Cursor.ForEachElement([&]()
+            {
+                double OpenDay = -1.0, CloseDay = -1.0;
+                FString OpenTime, CloseTime;
+                const bool bReadPeriod = Cursor.ForEachMember([&](FAnsiStringView PeriodKey)
+                {
+                    const bool bOpen = FRestaurantJsonCursor::KeyIs(PeriodKey, "open");
+                    if (!bOpen && !FRestaurantJsonCursor::KeyIs(PeriodKey, "close"))
+                    {
+                        return Cursor.SkipValue();
+                    }
+
+                    double& Day = bOpen ? OpenDay : CloseDay;
+                    FString& Time = bOpen ? OpenTime : CloseTime;
+                    return Cursor.ForEachMember([&](FAnsiStringView PointKey)
+                    {
+                        if (FRestaurantJsonCursor::KeyIs(PointKey, "day"))
+                        {
+                            return Cursor.ReadNumber(Day);
+                        }
+                        if (FRestaurantJsonCursor::KeyIs(PointKey, "time"))
+                        {
+                            return Cursor.ReadString(Time);
+                        }
+                        return Cursor.SkipValue();
+                    });
+                });
+
+                if (bReadPeriod && OpenDay >= 0.0 && OpenDay < 7.0 && !OpenTime.IsEmpty())
+                {
+                    // An open without a close is how Google says open around the clock
+                    if (CloseTime.IsEmpty())
+                    {
+                        bAlwaysOpen = true;
+                    }
+                    else
+                    {
+                        Builder.Add(Hours, (static_cast<int32>(OpenDay) + 6) % 7, ParseClockTime(OpenTime), ParseClockTime(CloseTime));
+                    }
+                }
+                return bReadPeriod;
+            });
+        });
+
+        if (bAlwaysOpen)
+        {
+            Hours.bOpen24Hours = true;
+            Hours.OpenSlots.SetAlwaysOpen();
+            for (int32 Day = 0; Day < 7; Day++)
+            {
+                Hours.WeeklyHours.Add(FRestaurantOpenHours::GetDayName(Day), TEXT("Open 24 hours"));
+            }
+        }
+        else
+        {
+            Builder.Finish(Hours);
+        }
+        return bRead;
+    }
+
+    bool ParseGooglePlace(FRestaurantJsonCursor& Cursor, FRestaurantData& Restaurant)
+    {
+        return Cursor.ForEachMember([&Cursor, &Restaurant](FAnsiStringView Key)
+        {
+            if (FRestaurantJsonCursor::KeyIs(Key, "name"))
+            {
+                return Cursor.ReadString(Restaurant.Name);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "vicinity"))
+            {
+                return Cursor.ReadString(Restaurant.Address);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "place_id"))
+            {
+                return Cursor.ReadString(Restaurant.GooglePlaceId);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "rating"))
+            {
+                double Rating = 0.0;
+                const bool bRead = Cursor.ReadNumber(Rating);
+                Restaurant.Rating = static_cast<float>(Rating);
+                return bRead;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "user_ratings_total"))
+            {
+                double ReviewCount = 0.0;
+                const bool bRead = Cursor.ReadNumber(ReviewCount);
+                Restaurant.ReviewCount = static_cast<int32>(ReviewCount);
+                return bRead;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "price_level"))
+            {
+                double PriceLevel = 0.0;
+                if (!Cursor.ReadNumber(PriceLevel))
+                {
+                    return false;
+                }
+                switch (static_cast<int32>(PriceLevel))
+                {
+                case 1: Restaurant.PriceLevel = "$"; break;
+                case 2: Restaurant.PriceLevel = "$$"; break;
+                case 3: Restaurant.PriceLevel = "$$$"; break;
+                case 4: Restaurant.PriceLevel = "$$$$"; break;
+                default: Restaurant.PriceLevel = "N/A"; break;
+                }
+                return true;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "geometry"))
+            {
+                return Cursor.ForEachMember([&Cursor, &Restaurant](FAnsiStringView GeometryKey)
+                {
+                    if (!FRestaurantJsonCursor::KeyIs(GeometryKey, "location"))
+                    {
+                        return Cursor.SkipValue();
+                    }
+
+                    double Lat = 0.0, Lng = 0.0;
+                    bool bHasLat = false, bHasLng = false;
+                    const bool bRead = Cursor.ForEachMember([&](FAnsiStringView LocationKey)
+                    {
+                        if (FRestaurantJsonCursor::KeyIs(LocationKey, "lat"))
+                        {
+                            bHasLat = true;
+                            return Cursor.ReadNumber(Lat);
+                        }
+                        if (FRestaurantJsonCursor::KeyIs(LocationKey, "lng"))
+                        {
+                            bHasLng = true;
+                            return Cursor.ReadNumber(Lng);
+                        }
+                        return Cursor.SkipValue();
+                    });
+
+                    if (bHasLat && bHasLng)
+                    {
+                        Restaurant.Location = FVector2D(Lat, Lng);
+                    }
+                    return bRead;
+                });
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "business_status"))
+            {
+                FString Status;
+                const bool bRead = Cursor.ReadString(Status);
+                Restaurant.Hours.bTemporarilyClosed = Status == TEXT("CLOSED_TEMPORARILY");
+                if (Restaurant.Hours.bTemporarilyClosed)
+                {
+                    Restaurant.Hours.OpenSlots.bKnown = true;
+                }
+                return bRead;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "formatted_phone_number"))
+            {
+                return Cursor.ReadString(Restaurant.PhoneNumber);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "website"))
+            {
+                return Cursor.ReadString(Restaurant.Website);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "utc_offset"))
+            {
+                double UtcOffset = 0.0;
+                Restaurant.Hours.bHasUtcOffset = !Cursor.TryReadNull();
+                const bool bRead = !Restaurant.Hours.bHasUtcOffset || Cursor.ReadNumber(UtcOffset);
+                Restaurant.Hours.UtcOffsetMinutes = static_cast<int32>(UtcOffset);
+                return bRead;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "opening_hours"))
+            {
+                return ParseGoogleOpeningHours(Cursor, Restaurant.Hours);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "photos"))
+            {
+                return Cursor.ForEachElement([&Cursor, &Restaurant]()
+                {
+                    return Cursor.ForEachMember([&Cursor, &Restaurant](FAnsiStringView PhotoKey)
+                    {
+                        if (!FRestaurantJsonCursor::KeyIs(PhotoKey, "photo_reference"))
+                        {
+                            return Cursor.SkipValue();
+                        }
+
+                        // Photo references need the API key, which is appended when the photo is fetched
+                        FString Reference;
+                        if (!Cursor.ReadString(Reference))
+                        {
+                            return false;
+                        }
+                        if (!Reference.IsEmpty())
+                        {
+                            Restaurant.PhotoURLs.Add(TEXT("https://maps.googleapis.com/maps/api/place/photo?maxwidth=800&photo_reference=") + Reference);
+                        }
+                        return true;
+                    });
+                });
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "types"))
+            {
+                return Cursor.ForEachElement([&Cursor, &Restaurant]()
+                {
+                    FString Type;
+                    if (!Cursor.ReadString(Type))
+                    {
+                        return false;
+                    }
+                    if (Type != "restaurant" && Type != "food" && Type != "establishment")
+                    {
+                        Restaurant.CuisineTypes.Add(MoveTemp(Type));
+                    }
+                    return true;
+                });
+            }
+            return Cursor.SkipValue();
+        });
+    }
+
+    // business_hours: [{ "hours_type": "REGULAR", "open": [{ "day": 0, "start": "1100", "end": "2200" }] }]
+    // with day 0 being Monday. Fills both the display text and the slot mask.
+    bool ParseYelpBusinessHours(FRestaurantJsonCursor& Cursor, FOperatingHours& Hours)
+    {
+        FWeeklyHoursBuilder Builder;
+
+        const bool bRead = Cursor.ForEachElement([&]()
+        {
+            bool bRegular = true;
+            TArray<FIntVector> Spans;
+            const bool bReadEntry = Cursor.ForEachMember([&](FAnsiStringView EntryKey)
+            {
+                if (FRestaurantJsonCursor::KeyIs(EntryKey, "hours_type"))
+                {
+                    FString HoursType;
+                    const bool bReadType = Cursor.ReadString(HoursType);
+                    bRegular = HoursType.IsEmpty() || HoursType == TEXT("REGULAR");
+                    return bReadType;
+                }
+                if (!FRestaurantJsonCursor::KeyIs(EntryKey, "open"))
+                {
+                    return Cursor.SkipValue();
+                }
+
+                return Cursor.ForEachElement([&]()
+                {
+                    double Day = -1.0;
+                    FString Start, End;
+                    const bool bReadSpan = Cursor.ForEachMember([&](FAnsiStringView SpanKey)
+                    {
+                        if (FRestaurantJsonCursor::KeyIs(SpanKey, "day"))
+                        {
+                            return Cursor.ReadNumber(Day);
+                        }
+                        if (FRestaurantJsonCursor::KeyIs(SpanKey, "start"))
+                        {
+                            return Cursor.ReadString(Start);
+                        }
+                        if (FRestaurantJsonCursor::KeyIs(SpanKey, "end"))
+                        {
+                            return Cursor.ReadString(End);
+                        }
+                        return Cursor.SkipValue();
+                    });
+
+                    if (bReadSpan && Day >= 0.0 && Day < 7.0 && !Start.IsEmpty() && !End.IsEmpty())
+                    {
+                        Spans.Emplace(static_cast<int32>(Day), ParseClockTime(Start), ParseClockTime(End));
+                    }
+                    return bReadSpan;
+                });
+            });
+
+            if (bReadEntry && bRegular)
+            {
+                for (const FIntVector& Span : Spans)
+                {
+                    Builder.Add(Hours, Span.X, Span.Y, Span.Z);
+                }
+            }
+            return bReadEntry;
+        });
+
+        Builder.Finish(Hours);
+        return bRead;
+    }
+
+    bool ParseYelpBusiness(FRestaurantJsonCursor& Cursor, FRestaurantData& Restaurant)
+    {
+        return Cursor.ForEachMember([&Cursor, &Restaurant](FAnsiStringView Key)
+        {
+            if (FRestaurantJsonCursor::KeyIs(Key, "name"))
+            {
+                return Cursor.ReadString(Restaurant.Name);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "id"))
+            {
+                return Cursor.ReadString(Restaurant.YelpBusinessId);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "phone"))
+            {
+                return Cursor.ReadString(Restaurant.PhoneNumber);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "url"))
+            {
+                return Cursor.ReadString(Restaurant.Website);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "image_url"))
+            {
+                FString ImageURL;
+                const bool bRead = Cursor.ReadString(ImageURL);
+                if (!ImageURL.IsEmpty())
+                {
+                    Restaurant.PhotoURLs.Add(MoveTemp(ImageURL));
+                }
+                return bRead;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "price"))
+            {
+                return Cursor.ReadString(Restaurant.PriceLevel);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "rating"))
+            {
+                double Rating = 0.0;
+                const bool bRead = Cursor.ReadNumber(Rating);
+                Restaurant.Rating = static_cast<float>(Rating);
+                return bRead;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "review_count"))
+            {
+                double ReviewCount = 0.0;
+                const bool bRead = Cursor.ReadNumber(ReviewCount);
+                Restaurant.ReviewCount = static_cast<int32>(ReviewCount);
+                return bRead;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "coordinates"))
+            {
+                double Lat = 0.0, Lng = 0.0;
+                bool bHasLat = false, bHasLng = false;
+                const bool bRead = Cursor.ForEachMember([&](FAnsiStringView CoordinateKey)
+                {
+                    if (FRestaurantJsonCursor::KeyIs(CoordinateKey, "latitude"))
+                    {
+                        bHasLat = !Cursor.TryReadNull();
+                        return bHasLat ? Cursor.ReadNumber(Lat) : true;
+                    }
+                    if (FRestaurantJsonCursor::KeyIs(CoordinateKey, "longitude"))
+                    {
+                        bHasLng = !Cursor.TryReadNull();
+                        return bHasLng ? Cursor.ReadNumber(Lng) : true;
+                    }
+                    return Cursor.SkipValue();
+                });
+
+                if (bHasLat && bHasLng)
+                {
+                    Restaurant.Location = FVector2D(Lat, Lng);
+                }
+                return bRead;
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "location"))
+            {
+                return Cursor.ForEachMember([&Cursor, &Restaurant](FAnsiStringView LocationKey)
+                {
+                    if (FRestaurantJsonCursor::KeyIs(LocationKey, "address1"))
+                    {
+                        return Cursor.ReadString(Restaurant.Address);
+                    }
+                    return Cursor.SkipValue();
+                });
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "transactions"))
+            {
+                return Cursor.ForEachElement([&Cursor, &Restaurant]()
+                {
+                    FString Transaction;
+                    if (!Cursor.ReadString(Transaction))
+                    {
+                        return false;
+                    }
+                    Restaurant.bDelivery |= Transaction == TEXT("delivery");
+                    Restaurant.bTakeout |= Transaction == TEXT("pickup");
+                    Restaurant.bAcceptsReservations |= Transaction == TEXT("restaurant_reservation");
+                    return true;
+                });
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "business_hours"))
+            {
+                return ParseYelpBusinessHours(Cursor, Restaurant.Hours);
+            }
+            if (FRestaurantJsonCursor::KeyIs(Key, "categories"))
+            {
+                return Cursor.ForEachElement([&Cursor, &Restaurant]()
+                {
+                    return Cursor.ForEachMember([&Cursor, &Restaurant](FAnsiStringView CategoryKey)
+                    {
+                        if (!FRestaurantJsonCursor::KeyIs(CategoryKey, "title"))
+                        {
+                            return Cursor.SkipValue();
+                        }
+
+                        FString Title;
+                        if (!Cursor.ReadString(Title))
+                        {
+                            return false;
+                        }
+                        if (!Title.IsEmpty())
+                        {
+                            Restaurant.CuisineTypes.Add(MoveTemp(Title));
+                        }
+                        return true;
+                    });
+                });
+            }
+            return Cursor.SkipValue();
+        });
+    }
+
+    // OtherMember consumes every top-level member except the result array
+    bool ParseResultArray(const TArray<uint8>& Utf8Body, const ANSICHAR* ArrayKey, TArray<FRestaurantData>& OutResults,
+        bool (*ParseEntry)(FRestaurantJsonCursor&, FRestaurantData&), TFunctionRef<bool(FRestaurantJsonCursor&, FAnsiStringView)> OtherMember)
+    {
+        FRestaurantJsonCursor Cursor(Utf8Body.GetData(), Utf8Body.Num());
+
+        return Cursor.ForEachMember([&](FAnsiStringView Key)
+        {
+            if (!FRestaurantJsonCursor::KeyIs(Key, ArrayKey))
+            {
+                return OtherMember(Cursor, Key);
+            }
+
+            return Cursor.ForEachElement([&]()
+            {
+                FRestaurantData Restaurant;
+                if (!ParseEntry(Cursor, Restaurant))
+                {
+                    return false;
+                }
+                OutResults.Add(MoveTemp(Restaurant));
+                return true;
+            });
+        });
+    }
+}
+
+bool FRestaurantJsonParser::ParseGooglePlaces(const TArray<uint8>& Utf8Body, TArray<FRestaurantData>& OutResults, FString* OutNextPageToken)
+{
+    OutResults.Reserve(OutResults.Num() + 20);
+    FString Status;
+    const bool bRead = ParseResultArray(Utf8Body, "results", OutResults, &ParseGooglePlace, [OutNextPageToken, &Status](FRestaurantJsonCursor& Cursor, FAnsiStringView Key)
+    {
+        if (OutNextPageToken && FRestaurantJsonCursor::KeyIs(Key, "next_page_token"))
+        {
+            return Cursor.ReadString(*OutNextPageToken);
+        }
+        if (FRestaurantJsonCursor::KeyIs(Key, "status"))
+        {
+            return Cursor.ReadString(Status);
+        }
+        return Cursor.SkipValue();
+    });
+
+    // INVALID_REQUEST (a page token used too early), REQUEST_DENIED and OVER_QUERY_LIMIT
+    // would otherwise read as a complete, empty last page
+    return bRead && (Status == TEXT("OK") || Status == TEXT("ZERO_RESULTS"));
+}
+
+FString FRestaurantJsonParser::ParseGoogleStatus(const TArray<uint8>& Utf8Body)
+{
+    FRestaurantJsonCursor Cursor(Utf8Body.GetData(), Utf8Body.Num());
+    FString Status;
+
+    Cursor.ForEachMember([&](FAnsiStringView Key)
+    {
+        if (FRestaurantJsonCursor::KeyIs(Key, "status"))
+        {
+            return Cursor.ReadString(Status);
+        }
+        return Cursor.SkipValue();
+    });
+
+    return Status;
+}
+
+bool FRestaurantJsonParser::ParseYelp(const TArray<uint8>& Utf8Body, TArray<FRestaurantData>& OutResults, int32* OutTotal)
+{
+    OutResults.Reserve(OutResults.Num() + 50);
+    return ParseResultArray(Utf8Body, "businesses", OutResults, &ParseYelpBusiness, [OutTotal](FRestaurantJsonCursor& Cursor, FAnsiStringView Key)
+    {
+        double Total = 0.0;
+        if (OutTotal && FRestaurantJsonCursor::KeyIs(Key, "total"))
+        {
+            if (!Cursor.ReadNumber(Total))
+            {
+                return false;
+            }
+            *OutTotal = static_cast<int32>(Total);
+            return true;
+        }
+        return Cursor.SkipValue();
+    });
+}
+
+bool FRestaurantJsonParser::ParseGooglePlaceDetails(const TArray<uint8>& Utf8Body, FRestaurantData& OutRestaurant)
+{
+    FRestaurantJsonCursor Cursor(Utf8Body.GetData(), Utf8Body.Num());
+    FString Status;
+    bool bHasResult = false;
+
+    const bool bRead = Cursor.ForEachMember([&](FAnsiStringView Key)
+    {
+        if (FRestaurantJsonCursor::KeyIs(Key, "result"))
+        {
+            bHasResult = true;
+            return ParseGooglePlace(Cursor, OutRestaurant);
+        }
+        if (FRestaurantJsonCursor::KeyIs(Key, "status"))
+        {
+            return Cursor.ReadString(Status);
+        }
+        return Cursor.SkipValue();
+    });
+
+    return bRead && bHasResult && Status == TEXT("OK");
+}
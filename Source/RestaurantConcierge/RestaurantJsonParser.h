@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+// Forward-only cursor over a UTF-8 JSON buffer. Values are consumed in document
+// order; anything the caller is not interested in is skipped without allocating.
+class RESTAURANTCONCIERGE_API FRestaurantJsonCursor
+{
+public:
+    FRestaurantJsonCursor(const uint8* InData, int32 InNum);
+
+    // Visits every member of the object at the cursor. The visitor must consume
+    // the member value (read or skip it) and return false to abort parsing.
+    bool ForEachMember(TFunctionRef<bool(FAnsiStringView Key)> Visitor);
+
+    // Visits every element of the array at the cursor, same contract as ForEachMember
+    bool ForEachElement(TFunctionRef<bool()> Visitor);
+
+    // A null value is accepted and leaves OutValue untouched
+    bool ReadString(FString& OutValue);
+    bool ReadNumber(double& OutValue);
+    bool ReadBool(bool& OutValue);
+    bool SkipValue();
+
+    // True (and consumed) if the next value is null
+    bool TryReadNull();
+
+    bool HasError() const { return bError; }
+
+    static bool KeyIs(FAnsiStringView Key, const ANSICHAR* Literal);
+
+private:
+    void SkipWhitespace();
+    bool Expect(ANSICHAR Char);
+    bool MatchLiteral(const ANSICHAR* Literal);
+    bool ReadHex4(uint32& OutValue);
+    bool Fail();
+
+    const uint8* Data;
+    int32 Num;
+    int32 Pos = 0;
+    bool bError = false;
+};
+
+// Streaming parser for provider search responses. Reads the raw UTF-8 body in a
+// single forward pass and writes FRestaurantData directly, without building a
+// JSON DOM or converting the body to an FString first. Safe to call from worker
+// threads: it touches no UObjects.
+class RESTAURANTCONCIERGE_API FRestaurantJsonParser
+{
+public:
+    // Google Places "nearbysearch" response. OutNextPageToken is left untouched on the last page.
+    // Fails unless the status is OK or ZERO_RESULTS; errors come back with HTTP 200.
+    static bool ParseGooglePlaces(const TArray<uint8>& Utf8Body, TArray<FRestaurantData>& OutResults, FString* OutNextPageToken = nullptr);
+
+    // The top-level "status" of a Google Places response, empty if there is none
+    static FString ParseGoogleStatus(const TArray<uint8>& Utf8Body);
+
+    // Google Places "details" response. Fails unless the status is OK.
+    static bool ParseGooglePlaceDetails(const TArray<uint8>& Utf8Body, FRestaurantData& OutRestaurant);
+
+    // Yelp Fusion "businesses/search" response. OutTotal receives the number of matches across all pages.
+    static bool ParseYelp(const TArray<uint8>& Utf8Body, TArray<FRestaurantData>& OutResults, int32* OutTotal = nullptr);
+};
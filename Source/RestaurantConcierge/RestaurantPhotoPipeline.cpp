@@ -0,0 +1,477 @@
+#include "RestaurantPhotoPipeline.h"
+#include "RestaurantHttpClient.h"
+#include "RestaurantRequestScheduler.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Engine/Texture2D.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Modules/ModuleManager.h"
+
+namespace
+{
+    // Larger sources are rejected before decoding, 8192^2 BGRA is still well inside int32
+    constexpr int32 MaxSourceDimension = 8192;
+
+    // Averages every source pixel under the destination pixel, for shrinking
+    void BoxResample(const uint8* Src, int32 SrcPitch, int32 SrcX, int32 SrcY, int32 Crop, int32 Size, uint8* Dst)
+    {
+        for (int32 Y = 0; Y < Size; Y++)
+        {
+            const int32 Y0 = SrcY + Y * Crop / Size;
+            const int32 Y1 = FMath::Max(SrcY + (Y + 1) * Crop / Size, Y0 + 1);
+            for (int32 X = 0; X < Size; X++)
+            {
+                const int32 X0 = SrcX + X * Crop / Size;
+                const int32 X1 = FMath::Max(SrcX + (X + 1) * Crop / Size, X0 + 1);
+
+                uint32 Sum[4] = {};
+                for (int32 SY = Y0; SY < Y1; SY++)
+                {
+                    const uint8* Row = Src + SY * SrcPitch + X0 * 4;
+                    for (int32 SX = X0; SX < X1; SX++, Row += 4)
+                    {
+                        Sum[0] += Row[0];
+                        Sum[1] += Row[1];
+                        Sum[2] += Row[2];
+                        Sum[3] += Row[3];
+                    }
+                }
+
+                const uint32 Count = (Y1 - Y0) * (X1 - X0);
+                uint8* Out = Dst + (Y * Size + X) * 4;
+                for (int32 C = 0; C < 4; C++)
+                {
+                    Out[C] = static_cast<uint8>(Sum[C] / Count);
+                }
+            }
+        }
+    }
+
+    // Interpolates between the four nearest source pixels, for enlarging thumbnails
+    void BilinearResample(const uint8* Src, int32 SrcPitch, int32 SrcX, int32 SrcY, int32 Crop, int32 Size, uint8* Dst)
+    {
+        const float Scale = static_cast<float>(Crop) / Size;
+        for (int32 Y = 0; Y < Size; Y++)
+        {
+            const float FY = FMath::Clamp((Y + 0.5f) * Scale - 0.5f, 0.0f, static_cast<float>(Crop - 1));
+            const int32 Y0 = FMath::FloorToInt32(FY);
+            const int32 Y1 = FMath::Min(Y0 + 1, Crop - 1);
+            const float TY = FY - Y0;
+            for (int32 X = 0; X < Size; X++)
+            {
+                const float FX = FMath::Clamp((X + 0.5f) * Scale - 0.5f, 0.0f, static_cast<float>(Crop - 1));
+                const int32 X0 = FMath::FloorToInt32(FX);
+                const int32 X1 = FMath::Min(X0 + 1, Crop - 1);
+                const float TX = FX - X0;
+
+                const uint8* P00 = Src + (SrcY + Y0) * SrcPitch + (SrcX + X0) * 4;
+                const uint8* P01 = Src + (SrcY + Y0) * SrcPitch + (SrcX + X1) * 4;
+                const uint8* P10 = Src + (SrcY + Y1) * SrcPitch + (SrcX + X0) * 4;
+                const uint8* P11 = Src + (SrcY + Y1) * SrcPitch + (SrcX + X1) * 4;
+                uint8* Out = Dst + (Y * Size + X) * 4;
+                for (int32 C = 0; C < 4; C++)
+                {
+                    const float Top = FMath::Lerp<float>(P00[C], P01[C], TX);
+                    const float Bottom = FMath::Lerp<float>(P10[C], P11[C], TX);
+                    Out[C] = static_cast<uint8>(FMath::RoundToInt32(FMath::Lerp(Top, Bottom, TY)));
+                }
+            }
+        }
+    }
+}
+
+FRestaurantPhotoPipeline::FRestaurantPhotoPipeline(TSharedRef<FRestaurantRequestScheduler> InScheduler, TSharedRef<FRestaurantHttpClient> InHttpClient, const FString& InCacheDirectory)
+    : Scheduler(InScheduler)
+    , HttpClient(InHttpClient)
+    , CacheDirectory(InCacheDirectory)
+{
+    // Full images are larger than search responses, the thumbnail covers the wait
+    DownloadPolicy.TimeoutSeconds = 5.0f;
+    DownloadPolicy.FirstByteTimeoutSeconds = 3.0f;
+}
+
+void FRestaurantPhotoPipeline::Request(const FString& PhotoURL)
+{
+    if (PhotoURL.IsEmpty())
+    {
+        return;
+    }
+
+    if (FEntry* Entry = Entries.Find(PhotoURL))
+    {
+        Entry->LastUse = ++UseCounter;
+        OnLoaded.ExecuteIfBound(PhotoURL, Entry->Texture, Entry->bFullResolution);
+        return;
+    }
+
+    if (Loading.Contains(PhotoURL))
+    {
+        return;
+    }
+
+    if (!ImageWrapper)
+    {
+        ImageWrapper = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+    }
+
+    Loading.Add(PhotoURL);
+    LoadFromDisk(PhotoURL);
+}
+
+void FRestaurantPhotoPipeline::CancelPending()
+{
+    for (const FDownload& Download : Queue)
+    {
+        if (Download.bFullResolution)
+        {
+            Loading.Remove(Download.PhotoURL);
+        }
+    }
+    Queue.Empty();
+}
+
+void FRestaurantPhotoPipeline::TrimDiskCache()
+{
+    const FString Directory = CacheDirectory;
+    const int64 BudgetBytes = Settings.DiskBudgetBytes;
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Directory, BudgetBytes]()
+    {
+        struct FCachedFile
+        {
+            FString Path;
+            int64 Size;
+            FDateTime ModifiedAt;
+        };
+
+        TArray<FCachedFile> Files;
+        int64 TotalBytes = 0;
+        IFileManager::Get().IterateDirectoryStat(*Directory, [&Files, &TotalBytes](const TCHAR* Path, const FFileStatData& Stat)
+        {
+            if (!Stat.bIsDirectory)
+            {
+                Files.Add({ Path, Stat.FileSize, Stat.ModificationTime });
+                TotalBytes += Stat.FileSize;
+            }
+            return true;
+        });
+
+        if (TotalBytes <= BudgetBytes)
+        {
+            return;
+        }
+
+        // Reads touch the files, so the oldest ones are the least recently used
+        Files.Sort([](const FCachedFile& A, const FCachedFile& B) { return A.ModifiedAt < B.ModifiedAt; });
+        for (const FCachedFile& File : Files)
+        {
+            if (TotalBytes <= BudgetBytes)
+            {
+                break;
+            }
+            if (IFileManager::Get().Delete(*File.Path, false, false, true))
+            {
+                TotalBytes -= File.Size;
+            }
+        }
+    });
+}
+
+void FRestaurantPhotoPipeline::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    for (TPair<FString, FEntry>& Entry : Entries)
+    {
+        Collector.AddReferencedObject(Entry.Value.Texture);
+    }
+}
+
+bool FRestaurantPhotoPipeline::DecodeToSquare(IImageWrapperModule& ImageWrapper, const TArray<uint8>& Compressed, int32 Size, TArray<uint8>& OutPixels)
+{
+    const EImageFormat Format = ImageWrapper.DetectImageFormat(Compressed.GetData(), Compressed.Num());
+    if (Format != EImageFormat::JPEG && Format != EImageFormat::PNG)
+    {
+        return false;
+    }
+
+    TSharedPtr<IImageWrapper> Wrapper = ImageWrapper.CreateImageWrapper(Format);
+    if (!Wrapper.IsValid() || !Wrapper->SetCompressed(Compressed.GetData(), Compressed.Num()))
+    {
+        return false;
+    }
+
+    // The header alone says how big the pixels would be, check it before they are allocated
+    const int64 SourceWidth = Wrapper->GetWidth();
+    const int64 SourceHeight = Wrapper->GetHeight();
+    if (SourceWidth <= 0 || SourceHeight <= 0 || SourceWidth > MaxSourceDimension || SourceHeight > MaxSourceDimension)
+    {
+        return false;
+    }
+
+    const int32 Width = static_cast<int32>(SourceWidth);
+    const int32 Height = static_cast<int32>(SourceHeight);
+    TArray<uint8> Raw;
+    if (!Wrapper->GetRaw(ERGBFormat::BGRA, 8, Raw) || Raw.Num() < Width * Height * 4)
+    {
+        return false;
+    }
+
+    // Cards show a square, crop the middle of the photo rather than letterbox it
+    const int32 Crop = FMath::Min(Width, Height);
+    const int32 SrcX = (Width - Crop) / 2;
+    const int32 SrcY = (Height - Crop) / 2;
+
+    OutPixels.SetNumUninitialized(Size * Size * 4);
+    if (Crop >= Size)
+    {
+        BoxResample(Raw.GetData(), Width * 4, SrcX, SrcY, Crop, Size, OutPixels.GetData());
+    }
+    else
+    {
+        BilinearResample(Raw.GetData(), Width * 4, SrcX, SrcY, Crop, Size, OutPixels.GetData());
+    }
+    return true;
+}
+
+FString FRestaurantPhotoPipeline::GetCachePath(const FString& PhotoURL, bool bFullResolution) const
+{
+    return CacheDirectory / FMD5::HashAnsiString(*PhotoURL) + (bFullResolution ? TEXT("_full.img") : TEXT("_thumb.img"));
+}
+
+void FRestaurantPhotoPipeline::LoadFromDisk(const FString& PhotoURL)
+{
+    TWeakPtr<FRestaurantPhotoPipeline, ESPMode::ThreadSafe> WeakThis = AsShared();
+    IImageWrapperModule* Wrapper = ImageWrapper;
+    const int32 Size = Settings.TextureSize;
+    const FString FullPath = GetCachePath(PhotoURL, true);
+    const FString ThumbnailPath = GetCachePath(PhotoURL, false);
+
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Wrapper, Size, PhotoURL, FullPath, ThumbnailPath]()
+    {
+        // The full image makes the thumbnail and both downloads unnecessary
+        TArray<uint8> Compressed, Pixels;
+        bool bFullResolution = false;
+        bool bDecoded = false;
+        for (int32 Attempt = 0; Attempt < 2 && !bDecoded; Attempt++)
+        {
+            const FString& Path = Attempt == 0 ? FullPath : ThumbnailPath;
+            if (FFileHelper::LoadFileToArray(Compressed, *Path, FILEREAD_Silent) && DecodeToSquare(*Wrapper, Compressed, Size, Pixels))
+            {
+                IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+                bFullResolution = Attempt == 0;
+                bDecoded = true;
+            }
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, PhotoURL, bFullResolution, bDecoded, Pixels = MoveTemp(Pixels)]() mutable
+        {
+            TSharedPtr<FRestaurantPhotoPipeline, ESPMode::ThreadSafe> This = WeakThis.Pin();
+            if (!This.IsValid())
+            {
+                return;
+            }
+
+            if (bDecoded)
+            {
+                This->OnDecoded(PhotoURL, bFullResolution, true, MoveTemp(Pixels));
+            }
+            if (!bFullResolution)
+            {
+                if (!bDecoded)
+                {
+                    This->Enqueue(PhotoURL, false);
+                }
+                This->Enqueue(PhotoURL, true);
+            }
+        });
+    });
+}
+
+void FRestaurantPhotoPipeline::Enqueue(const FString& PhotoURL, bool bFullResolution)
+{
+    // Every thumbnail goes ahead of every full image, so a page of cards fills in quickly
+    const int32 FirstFull = Queue.IndexOfByPredicate([](const FDownload& Download) { return Download.bFullResolution; });
+    Queue.Insert({ PhotoURL, bFullResolution }, bFullResolution || FirstFull == INDEX_NONE ? Queue.Num() : FirstFull);
+    PumpDownloads();
+}
+
+void FRestaurantPhotoPipeline::PumpDownloads()
+{
+    while (DownloadsInFlight < Settings.MaxConcurrentDownloads && !Queue.IsEmpty())
+    {
+        const FDownload Download = Queue[0];
+        Queue.RemoveAt(0);
+
+        const int32 MaxPixels = Download.bFullResolution ? Settings.TextureSize : Settings.ThumbnailPixels;
+        FString URL;
+        bool bBilled = false;
+        TSharedPtr<FRestaurantProvider> Owner;
+        for (const TSharedPtr<FRestaurantProvider>& Provider : Providers)
+        {
+            URL = Provider->ResolvePhotoURL(Download.PhotoURL, MaxPixels, bBilled);
+            if (!URL.IsEmpty())
+            {
+                Owner = Provider;
+                break;
+            }
+        }
+
+        // Without a smaller variant a thumbnail would just download the full image twice,
+        // and a billed one costs as much as the full image
+        if (!Download.bFullResolution && (!Owner.IsValid() || bBilled))
+        {
+            continue;
+        }
+        if (!Owner.IsValid())
+        {
+            URL = Download.PhotoURL;
+        }
+
+        if (bBilled && !Scheduler->IsAvailable(*Owner, ERestaurantRequestPriority::Details))
+        {
+            OnDecoded(Download.PhotoURL, Download.bFullResolution, false, TArray<uint8>());
+            continue;
+        }
+
+        TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+        Request->SetURL(URL);
+        Request->SetVerb(TEXT("GET"));
+
+        FHttpRequestCompleteDelegate OnComplete = FHttpRequestCompleteDelegate::CreateSP(AsShared(), &FRestaurantPhotoPipeline::OnDownloaded, Download.PhotoURL, Download.bFullResolution);
+        DownloadsInFlight++;
+        if (bBilled)
+        {
+            Scheduler->Send(*Owner, ERestaurantRequestPriority::Details, Request, false, MoveTemp(OnComplete));
+        }
+        else
+        {
+            HttpClient->Send(TEXT("Photos"), Request, DownloadPolicy, false, MoveTemp(OnComplete));
+        }
+    }
+}
+
+void FRestaurantPhotoPipeline::OnDownloaded(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, FString PhotoURL, bool bFullResolution)
+{
+    DownloadsInFlight--;
+
+    if (FRestaurantHttpClient::Classify(Response, bWasSuccessful) != ERestaurantHttpResult::Success)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Photo download failed: %s"), Response.IsValid() ? *FString::FromInt(Response->GetResponseCode()) : TEXT("no response"));
+        OnDecoded(PhotoURL, bFullResolution, false, TArray<uint8>());
+        PumpDownloads();
+        return;
+    }
+
+    // Decoding a full size JPEG takes tens of milliseconds, never on the game thread
+    TWeakPtr<FRestaurantPhotoPipeline, ESPMode::ThreadSafe> WeakThis = AsShared();
+    IImageWrapperModule* Wrapper = ImageWrapper;
+    const int32 Size = Settings.TextureSize;
+    const FString CachePath = GetCachePath(PhotoURL, bFullResolution);
+    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, Wrapper, Size, CachePath, Response, PhotoURL, bFullResolution]()
+    {
+        TArray<uint8> Pixels;
+        const bool bDecoded = DecodeToSquare(*Wrapper, Response->GetContent(), Size, Pixels);
+        if (bDecoded)
+        {
+            FFileHelper::SaveArrayToFile(Response->GetContent(), *CachePath);
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, PhotoURL, bFullResolution, bDecoded, Pixels = MoveTemp(Pixels)]() mutable
+        {
+            if (TSharedPtr<FRestaurantPhotoPipeline, ESPMode::ThreadSafe> This = WeakThis.Pin())
+            {
+                This->OnDecoded(PhotoURL, bFullResolution, bDecoded, MoveTemp(Pixels));
+            }
+        });
+    });
+
+    PumpDownloads();
+}
+
+void FRestaurantPhotoPipeline::OnDecoded(const FString& PhotoURL, bool bFullResolution, bool bDecoded, TArray<uint8>&& Pixels)
+{
+    if (bDecoded)
+    {
+        Upload(PhotoURL, bFullResolution, MoveTemp(Pixels));
+    }
+
+    // Done either way once the full image is settled; a thumbnail still waiting is pointless now
+    if (bFullResolution)
+    {
+        Loading.Remove(PhotoURL);
+        if (bDecoded)
+        {
+            Queue.RemoveAll([&PhotoURL](const FDownload& Download) { return Download.PhotoURL == PhotoURL; });
+        }
+    }
+}
+
+void FRestaurantPhotoPipeline::Upload(const FString& PhotoURL, bool bFullResolution, TArray<uint8>&& Pixels)
+{
+    const int32 Size = Settings.TextureSize;
+    FEntry* Entry = Entries.Find(PhotoURL);
+    if ((Entry && Entry->bFullResolution && !bFullResolution) || Pixels.Num() != Size * Size * 4)
+    {
+        return;
+    }
+
+    if (!Entry)
+    {
+        UTexture2D* Texture = AcquireTexture();
+        if (!Texture)
+        {
+            return;
+        }
+        Entry = &Entries.Add(PhotoURL);
+        Entry->Texture = Texture;
+    }
+    Entry->bFullResolution = bFullResolution;
+    Entry->LastUse = ++UseCounter;
+
+    // The render thread copies the pixels and frees them, the game thread only queues the command
+    TArray<uint8>* Data = new TArray<uint8>(MoveTemp(Pixels));
+    FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, Size, Size);
+    Entry->Texture->UpdateTextureRegions(0, 1, Region, Size * 4, 4, Data->GetData(), [Data](uint8*, const FUpdateTextureRegion2D* InRegion)
+    {
+        delete Data;
+        delete InRegion;
+    });
+
+    OnLoaded.ExecuteIfBound(PhotoURL, Entry->Texture, bFullResolution);
+}
+
+UTexture2D* FRestaurantPhotoPipeline::AcquireTexture()
+{
+    if (Entries.Num() < Settings.PoolSize)
+    {
+        UTexture2D* Texture = UTexture2D::CreateTransient(Settings.TextureSize, Settings.TextureSize, PF_B8G8R8A8);
+        if (Texture)
+        {
+            Texture->SRGB = true;
+            Texture->UpdateResource();
+        }
+        return Texture;
+    }
+
+    // Pool is full: the least recently requested photo gives up its texture
+    const FString* OldestURL = nullptr;
+    uint64 OldestUse = MAX_uint64;
+    for (const TPair<FString, FEntry>& Entry : Entries)
+    {
+        if (Entry.Value.LastUse < OldestUse)
+        {
+            OldestUse = Entry.Value.LastUse;
+            OldestURL = &Entry.Key;
+        }
+    }
+
+    const FString Evicted = *OldestURL;
+    UTexture2D* Texture = Entries.FindChecked(Evicted).Texture;
+    Entries.Remove(Evicted);
+    OnEvicted.ExecuteIfBound(Evicted, Texture);
+    return Texture;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "Interfaces/IHttpRequest.h"
+#include "RestaurantProvider.h"
+
+class FRestaurantHttpClient;
+class FRestaurantRequestScheduler;
+class IImageWrapperModule;
+class UTexture2D;
+
+DECLARE_DELEGATE_ThreeParams(FOnRestaurantPhotoLoaded, const FString& /*PhotoURL*/, UTexture2D* /*Texture*/, bool /*bFullResolution*/);
+DECLARE_DELEGATE_TwoParams(FOnRestaurantPhotoEvicted, const FString& /*PhotoURL*/, UTexture2D* /*Texture*/);
+
+// Turns PhotoURLs into textures without touching the game thread for anything
+// but the final upload. A photo is looked up in the on-disk cache first, then
+// downloaded with bounded concurrency, thumbnails ahead of full size images (only
+// where the thumbnail is free), and decoded and cropped to a square on a worker
+// thread. The pixels land in a fixed pool of same sized textures: a thumbnail shows
+// up first and is overwritten in place by the full image, and once the pool is full
+// the least recently requested photo gives up its texture, announced through
+// OnEvicted. VRAM use is therefore capped at PoolSize * TextureSize^2 * 4 bytes no
+// matter how many cards are browsed.
+class RESTAURANTCONCIERGE_API FRestaurantPhotoPipeline : public FGCObject, public TSharedFromThis<FRestaurantPhotoPipeline, ESPMode::ThreadSafe>
+{
+public:
+    struct FSettings
+    {
+        int32 PoolSize = 48;
+        int32 TextureSize = 512;
+        int32 ThumbnailPixels = 128;
+        int32 MaxConcurrentDownloads = 4;
+        int64 DiskBudgetBytes = 128ll * 1024 * 1024;
+    };
+
+    FRestaurantPhotoPipeline(TSharedRef<FRestaurantRequestScheduler> InScheduler, TSharedRef<FRestaurantHttpClient> InHttpClient, const FString& InCacheDirectory);
+
+    // Textures already in the pool keep their size, call before the first Request
+    void Configure(const FSettings& InSettings) { Settings = InSettings; }
+
+    // Providers resolve their own photo URLs, anything else is downloaded as is
+    void SetProviders(const TArray<TSharedPtr<FRestaurantProvider>>& InProviders) { Providers = InProviders; }
+
+    // Loads the photo into the pool. OnLoaded fires with the thumbnail and again with
+    // the full image, or once right away if the photo is already loaded. Requesting a
+    // photo again whenever it is shown keeps its texture from being reused.
+    void Request(const FString& PhotoURL);
+
+    // Forgets downloads that have not started yet
+    void CancelPending();
+
+    // Deletes the oldest files beyond the disk budget, off the game thread
+    void TrimDiskCache();
+
+    FOnRestaurantPhotoLoaded OnLoaded;
+
+    // The photo's texture is about to show another photo, whoever displays it has to let go
+    FOnRestaurantPhotoEvicted OnEvicted;
+
+    // FGCObject
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+    virtual FString GetReferencerName() const override { return TEXT("FRestaurantPhotoPipeline"); }
+
+    // Decodes a JPEG or PNG and center-crops it to a Size x Size BGRA square. Safe on worker threads.
+    static bool DecodeToSquare(IImageWrapperModule& ImageWrapper, const TArray<uint8>& Compressed, int32 Size, TArray<uint8>& OutPixels);
+
+private:
+    struct FEntry
+    {
+        TObjectPtr<UTexture2D> Texture;
+        bool bFullResolution = false;
+        uint64 LastUse = 0;
+    };
+
+    struct FDownload
+    {
+        FString PhotoURL;
+        bool bFullResolution = false;
+    };
+
+    FString GetCachePath(const FString& PhotoURL, bool bFullResolution) const;
+
+    void LoadFromDisk(const FString& PhotoURL);
+    void Enqueue(const FString& PhotoURL, bool bFullResolution);
+    void PumpDownloads();
+    void OnDownloaded(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, FString PhotoURL, bool bFullResolution);
+    void OnDecoded(const FString& PhotoURL, bool bFullResolution, bool bDecoded, TArray<uint8>&& Pixels);
+    void Upload(const FString& PhotoURL, bool bFullResolution, TArray<uint8>&& Pixels);
+    UTexture2D* AcquireTexture();
+
+    TSharedRef<FRestaurantRequestScheduler> Scheduler;
+    TSharedRef<FRestaurantHttpClient> HttpClient;
+    TArray<TSharedPtr<FRestaurantProvider>> Providers;
+    FString CacheDirectory;
+    FSettings Settings;
+
+    // Timeouts for downloads that are not billed to a provider
+    FRestaurantProviderPolicy DownloadPolicy;
+
+    IImageWrapperModule* ImageWrapper = nullptr;
+
+    TMap<FString, FEntry> Entries;
+    uint64 UseCounter = 0;
+
+    // Photos whose full image is still on its way
+    TSet<FString> Loading;
+    TArray<FDownload> Queue;
+    int32 DownloadsInFlight = 0;
+};
@@ -0,0 +1,148 @@
+#include "RestaurantProvider.h"
+#include "RestaurantJsonParser.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe> FGooglePlacesProvider::CreateSearchRequest(FVector2D Location, const FSearchFilters& Filters, const FString& PageToken) const
+{
+    FString URL = BaseURL + "nearbysearch/json?";
+
+    // A page token stands for the original query, further parameters are ignored
+    if (!PageToken.IsEmpty())
+    {
+        URL += TEXT("pagetoken=") + FGenericPlatformHttp::UrlEncode(PageToken);
+    }
+    else
+    {
+        URL += FString::Printf(TEXT("location=%f,%f"), Location.X, Location.Y);
+        URL += FString::Printf(TEXT("&radius=%f"), Filters.MaxDistance);
+        URL += TEXT("&type=restaurant");
+
+        if (Filters.bOpenNow)
+        {
+            URL += TEXT("&opennow=true");
+        }
+
+        if (!Filters.CuisineTypes.IsEmpty())
+        {
+            URL += TEXT("&keyword=") + FString::Join(Filters.CuisineTypes, TEXT("+"));
+        }
+    }
+
+    URL += TEXT("&key=") + APIKey;
+
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+    Request->SetURL(URL);
+    Request->SetVerb("GET");
+    Request->SetHeader("Content-Type", "application/json");
+
+    return Request;
+}
+
+bool FGooglePlacesProvider::ParseSearchResponse(const TArray<uint8>& Content, const FString& PageToken, TArray<FRestaurantData>& OutResults, FString& OutNextPageToken) const
+{
+    return FRestaurantJsonParser::ParseGooglePlaces(Content, OutResults, &OutNextPageToken);
+}
+
+bool FGooglePlacesProvider::IsRateLimitResponse(const TArray<uint8>& Content) const
+{
+    return FRestaurantJsonParser::ParseGoogleStatus(Content) == TEXT("OVER_QUERY_LIMIT");
+}
+
+TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> FGooglePlacesProvider::CreateDetailsRequest(const FString& Id) const
+{
+    // Only the fields search results lack, details are billed per field group
+    FString URL = BaseURL + "details/json?";
+    URL += TEXT("place_id=") + FGenericPlatformHttp::UrlEncode(Id);
+    URL += TEXT("&fields=place_id,formatted_phone_number,website,opening_hours,utc_offset,photos");
+    URL += TEXT("&key=") + APIKey;
+
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+    Request->SetURL(URL);
+    Request->SetVerb("GET");
+    Request->SetHeader("Content-Type", "application/json");
+
+    return Request;
+}
+
+bool FGooglePlacesProvider::ParseDetailsResponse(const TArray<uint8>& Content, FRestaurantData& OutRestaurant) const
+{
+    return FRestaurantJsonParser::ParseGooglePlaceDetails(Content, OutRestaurant);
+}
+
+FString FGooglePlacesProvider::ResolvePhotoURL(const FString& PhotoURL, int32 MaxPixels, bool& bOutBilled) const
+{
+    // Stored without the key as photo?maxwidth=N&photo_reference=R, see FRestaurantJsonParser
+    FString Reference;
+    if (!PhotoURL.StartsWith(BaseURL + TEXT("photo?")) || !PhotoURL.Split(TEXT("photo_reference="), nullptr, &Reference) || Reference.IsEmpty())
+    {
+        return FString();
+    }
+
+    bOutBilled = true;
+    return FString::Printf(TEXT("%sphoto?maxwidth=%d&photo_reference=%s&key=%s"), *BaseURL, MaxPixels, *Reference, *APIKey);
+}
+
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe> FYelpProvider::CreateSearchRequest(FVector2D Location, const FSearchFilters& Filters, const FString& PageToken) const
+{
+    FString URL = BaseURL + "businesses/search?";
+    URL += FString::Printf(TEXT("latitude=%f&longitude=%f"), Location.X, Location.Y);
+    URL += FString::Printf(TEXT("&radius=%d"), FMath::RoundToInt(Filters.MaxDistance));
+    URL += TEXT("&categories=restaurants");
+    URL += FString::Printf(TEXT("&limit=%d"), PageSize);
+
+    if (!PageToken.IsEmpty())
+    {
+        URL += TEXT("&offset=") + PageToken;
+    }
+
+    if (Filters.bOpenNow)
+    {
+        URL += TEXT("&open_now=true");
+    }
+
+    if (!Filters.CuisineTypes.IsEmpty())
+    {
+        URL += TEXT("&term=") + FString::Join(Filters.CuisineTypes, TEXT("+"));
+    }
+
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+    Request->SetURL(URL);
+    Request->SetVerb("GET");
+    Request->SetHeader("Content-Type", "application/json");
+    Request->SetHeader("Authorization", FString::Printf(TEXT("Bearer %s"), *APIKey));
+
+    return Request;
+}
+
+bool FYelpProvider::ParseSearchResponse(const TArray<uint8>& Content, const FString& PageToken, TArray<FRestaurantData>& OutResults, FString& OutNextPageToken) const
+{
+    const int32 FirstResult = OutResults.Num();
+    int32 Total = 0;
+    if (!FRestaurantJsonParser::ParseYelp(Content, OutResults, &Total))
+    {
+        return false;
+    }
+
+    const int32 NextOffset = FCString::Atoi(*PageToken) + (OutResults.Num() - FirstResult);
+    if (OutResults.Num() - FirstResult == PageSize && NextOffset < Total && NextOffset + PageSize <= MaxResultWindow)
+    {
+        OutNextPageToken = FString::FromInt(NextOffset);
+    }
+
+    return true;
+}
+
+FString FYelpProvider::ResolvePhotoURL(const FString& PhotoURL, int32 MaxPixels, bool& bOutBilled) const
+{
+    // Business photos come from Yelp's CDN, which serves fixed size variants and is not metered
+    if (!PhotoURL.Contains(TEXT("yelpcdn.com/")) || !PhotoURL.EndsWith(TEXT("/o.jpg")))
+    {
+        return FString();
+    }
+
+    bOutBilled = false;
+    const TCHAR* Variant = MaxPixels <= 250 ? TEXT("ls.jpg") : MaxPixels <= 600 ? TEXT("l.jpg") : TEXT("o.jpg");
+    return PhotoURL.LeftChop(5) + Variant;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpRequest.h"
+#include "RestaurantData.h"
+
+// Timing rules for the requests sent to one provider
+struct FRestaurantProviderPolicy
+{
+    // A request that has not completed after this long counts as failed
+    float TimeoutSeconds = 3.0f;
+
+    // A request whose response has not started after this long is abandoned early.
+    // This limits time to first byte, which includes the server's own work, so it
+    // only pays off well below a long TimeoutSeconds. 0 disables it.
+    float FirstByteTimeoutSeconds = 0.0f;
+
+    // Send a duplicate request if the first one has not answered after this
+    // long and keep whichever returns first. 0 disables hedging.
+    float HedgeDelaySeconds = 1.5f;
+
+    // Upper bound on requests per search, hedges and retries after a failure included
+    int32 MaxAttempts = 2;
+
+    // First retry waits about this long, every further one twice as long, jittered
+    float RetryBaseDelaySeconds = 0.2f;
+
+    // Consecutive failures that take the provider out of searches for CircuitCooldownSeconds
+    int32 CircuitFailureThreshold = 3;
+    float CircuitCooldownSeconds = 30.0f;
+
+    // Pages fetched per search, the first included. Pages after the first are
+    // prefetched in the background once the search has answered.
+    int32 MaxPages = 3;
+
+    // Sustained request rate and burst the provider tolerates. Background work keeps
+    // part of the burst free so a live search never waits behind it.
+    float RequestsPerSecond = 10.0f;
+    float BurstSize = 10.0f;
+
+    // Requests per UTC day allowed for one API key, 0 for no limit
+    int32 DailyQuota = 0;
+};
+
+// A restaurant search backend. ARestaurantDataManager fans every search out to
+// all configured providers and merges what comes back through the entity
+// resolver, so a new source only has to build its request and parse its response.
+class RESTAURANTCONCIERGE_API FRestaurantProvider
+{
+public:
+    virtual ~FRestaurantProvider() = default;
+
+    // Used in logs and OnAPIError
+    virtual FString GetName() const = 0;
+
+    // Unconfigured providers (no API key) are left out of searches
+    virtual bool IsConfigured() const = 0;
+
+    // Builds the search request without sending it, the caller binds completion.
+    // PageToken is empty for the first page, otherwise a token from ParseSearchResponse.
+    virtual TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateSearchRequest(FVector2D Location, const FSearchFilters& Filters, const FString& PageToken) const = 0;
+
+    // Called on a worker thread, must not touch UObjects. OutNextPageToken stays
+    // empty when PageToken was the last page.
+    virtual bool ParseSearchResponse(const TArray<uint8>& Content, const FString& PageToken, TArray<FRestaurantData>& OutResults, FString& OutNextPageToken) const = 0;
+
+    // True if a successful HTTP response that failed to parse says the provider is
+    // rate limiting, for providers that report it in the body rather than with a 429.
+    // Called on a worker thread.
+    virtual bool IsRateLimitResponse(const TArray<uint8>& Content) const { return false; }
+
+    // How long a next page token takes to become usable
+    virtual float GetPageTokenDelaySeconds() const { return 0.0f; }
+
+    // Most results one page holds. Providers rank by prominence and cut off there, so
+    // only a shorter page without a next page token is known to hold every match.
+    virtual int32 GetPageSize() const = 0;
+
+    // Identifies the credential requests are billed to, never the credential itself.
+    // Providers sharing a key share its daily quota.
+    virtual FString GetQuotaKey() const { return GetName(); }
+
+    // The restaurant's id at this provider's details endpoint, empty if the provider
+    // has none or does not know the restaurant
+    virtual FString GetDetailsId(const FRestaurantData& Restaurant) const { return FString(); }
+
+    // Details counterparts of CreateSearchRequest and ParseSearchResponse, only called
+    // with ids from GetDetailsId. The parse runs on a worker thread.
+    virtual TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> CreateDetailsRequest(const FString& Id) const { return nullptr; }
+    virtual bool ParseDetailsResponse(const TArray<uint8>& Content, FRestaurantData& OutRestaurant) const { return false; }
+
+    // Downloadable URL for one of this provider's PhotoURLs, at roughly MaxPixels on
+    // the long edge; empty if the photo is not this provider's. bOutBilled is set when
+    // the download counts against the provider's quota.
+    virtual FString ResolvePhotoURL(const FString& PhotoURL, int32 MaxPixels, bool& bOutBilled) const { return FString(); }
+
+    FRestaurantProviderPolicy Policy;
+};
+
+// Google Places nearby search and place details
+class RESTAURANTCONCIERGE_API FGooglePlacesProvider : public FRestaurantProvider
+{
+public:
+    void SetAPIKey(const FString& InAPIKey) { APIKey = InAPIKey; }
+
+    virtual FString GetName() const override { return TEXT("GooglePlaces"); }
+    virtual bool IsConfigured() const override { return !APIKey.IsEmpty(); }
+    virtual TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateSearchRequest(FVector2D Location, const FSearchFilters& Filters, const FString& PageToken) const override;
+    virtual bool ParseSearchResponse(const TArray<uint8>& Content, const FString& PageToken, TArray<FRestaurantData>& OutResults, FString& OutNextPageToken) const override;
+    virtual bool IsRateLimitResponse(const TArray<uint8>& Content) const override;
+
+    // Google rejects a next_page_token as INVALID_REQUEST for a short while after issuing it
+    virtual float GetPageTokenDelaySeconds() const override { return 2.0f; }
+    virtual int32 GetPageSize() const override { return 20; }
+    virtual FString GetQuotaKey() const override { return FString::Printf(TEXT("GooglePlaces:%08x"), GetTypeHash(APIKey)); }
+
+    virtual FString GetDetailsId(const FRestaurantData& Restaurant) const override { return Restaurant.GooglePlaceId; }
+    virtual TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> CreateDetailsRequest(const FString& Id) const override;
+    virtual bool ParseDetailsResponse(const TArray<uint8>& Content, FRestaurantData& OutRestaurant) const override;
+    virtual FString ResolvePhotoURL(const FString& PhotoURL, int32 MaxPixels, bool& bOutBilled) const override;
+
+private:
+    FString APIKey;
+    FString BaseURL = "https://maps.googleapis.com/maps/api/place/";
+};
+
+// Yelp Fusion business search
+class RESTAURANTCONCIERGE_API FYelpProvider : public FRestaurantProvider
+{
+public:
+    FYelpProvider()
+    {
+        // Yelp Fusion's standard daily allowance per key
+        Policy.DailyQuota = 5000;
+    }
+
+    void SetAPIKey(const FString& InAPIKey) { APIKey = InAPIKey; }
+
+    virtual FString GetName() const override { return TEXT("Yelp"); }
+    virtual bool IsConfigured() const override { return !APIKey.IsEmpty(); }
+    virtual TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateSearchRequest(FVector2D Location, const FSearchFilters& Filters, const FString& PageToken) const override;
+    virtual bool ParseSearchResponse(const TArray<uint8>& Content, const FString& PageToken, TArray<FRestaurantData>& OutResults, FString& OutNextPageToken) const override;
+    virtual int32 GetPageSize() const override { return PageSize; }
+    virtual FString GetQuotaKey() const override { return FString::Printf(TEXT("Yelp:%08x"), GetTypeHash(APIKey)); }
+    virtual FString ResolvePhotoURL(const FString& PhotoURL, int32 MaxPixels, bool& bOutBilled) const override;
+
+private:
+    // Page tokens are result offsets. Yelp caps offset + limit at 240.
+    static constexpr int32 PageSize = 50;
+    static constexpr int32 MaxResultWindow = 240;
+
+    FString APIKey;
+    FString BaseURL = "https://api.yelp.com/v3/";
+};
@@ -0,0 +1,114 @@
+#include "RestaurantRanker.h"
+#include "RestaurantGeo.h"
+
+void FRestaurantRanker::Rank(const TArray<FRestaurantData>& Restaurants, const FSearchFilters& Filters, int32 K, TArray<int32>& OutOrder) const
+{
+    const int32 Num = Restaurants.Num();
+    K = FMath::Clamp(K, 0, Num);
+
+    TArray<float> Scores;
+    Scores.SetNumUninitialized(Num);
+    for (int32 i = 0; i < Num; i++)
+    {
+        Scores[i] = Score(Restaurants[i], Filters);
+    }
+
+    // Strict weak ordering on indices
+    auto RanksBefore = [&Scores, &Restaurants](int32 A, int32 B)
+    {
+        if (Scores[A] != Scores[B])
+        {
+            return Scores[A] > Scores[B];
+        }
+        if (Restaurants[A].ReviewCount != Restaurants[B].ReviewCount)
+        {
+            return Restaurants[A].ReviewCount > Restaurants[B].ReviewCount;
+        }
+        return A < B;
+    };
+
+    // Heap of the best K seen so far, the worst of them on top
+    auto RanksAfter = [&RanksBefore](int32 A, int32 B) { return RanksBefore(B, A); };
+    TArray<int32> Best;
+    Best.Reserve(K + 1);
+    for (int32 i = 0; i < Num && K > 0; i++)
+    {
+        if (Best.Num() < K)
+        {
+            Best.HeapPush(i, RanksAfter);
+        }
+        else if (RanksBefore(i, Best.HeapTop()))
+        {
+            Best.HeapPopDiscard(RanksAfter, /*bAllowShrinking*/ false);
+            Best.HeapPush(i, RanksAfter);
+        }
+    }
+    Best.Sort(RanksBefore);
+
+    TBitArray<> Taken(false, Num);
+    for (int32 Index : Best)
+    {
+        Taken[Index] = true;
+    }
+
+    OutOrder = MoveTemp(Best);
+    OutOrder.Reserve(Num);
+    for (int32 i = 0; i < Num; i++)
+    {
+        if (!Taken[i])
+        {
+            OutOrder.Add(i);
+        }
+    }
+}
+
+void FRestaurantRanker::RankInPlace(TArray<FRestaurantData>& Restaurants, const FSearchFilters& Filters, int32 K) const
+{
+    TArray<int32> Order;
+    Rank(Restaurants, Filters, K, Order);
+
+    TArray<FRestaurantData> Ranked;
+    Ranked.Reserve(Order.Num());
+    for (int32 Index : Order)
+    {
+        Ranked.Add(MoveTemp(Restaurants[Index]));
+    }
+    Restaurants = MoveTemp(Ranked);
+}
+
+float FWeightedRestaurantRanker::Score(const FRestaurantData& Restaurant, const FSearchFilters& Filters) const
+{
+    // Unrated restaurants rank below every rated one of similar distance and match
+    float RatingTerm = 0.0f;
+    if (Restaurant.Rating > 0.0f)
+    {
+        const float Reviews = static_cast<float>(FMath::Max(Restaurant.ReviewCount, 0));
+        const float Prior = FMath::Max(Weights.PriorReviewCount, 0.0f);
+        const float Smoothed = Reviews + Prior > 0.0f ? (Reviews * Restaurant.Rating + Prior * Weights.PriorRating) / (Reviews + Prior) : Restaurant.Rating;
+        RatingTerm = FMath::Clamp(Smoothed / 5.0f, 0.0f, 1.0f);
+    }
+
+    // Restaurants without coordinates get a neutral distance
+    float DistanceTerm = 0.5f;
+    if (FRestaurantGeo::IsValidLocation(Restaurant.Location) && Weights.DistanceHalfScoreMeters > 0.0f)
+    {
+        DistanceTerm = 1.0f / (1.0f + Restaurant.DistanceFromUser / Weights.DistanceHalfScoreMeters);
+    }
+
+    float PreferenceTerm = 0.0f;
+    if (!Filters.CuisineTypes.IsEmpty())
+    {
+        int32 Matched = 0;
+        for (const FString& Wanted : Filters.CuisineTypes)
+        {
+            const bool bServes = Restaurant.CuisineTypes.ContainsByPredicate([&Wanted](const FString& Cuisine)
+            {
+                return Cuisine.Contains(Wanted.TrimStartAndEnd());
+            });
+            Matched += bServes ? 1 : 0;
+        }
+        PreferenceTerm = static_cast<float>(Matched) / Filters.CuisineTypes.Num();
+    }
+
+    return Weights.Rating * RatingTerm + Weights.Distance * DistanceTerm + Weights.PreferenceMatch * PreferenceTerm;
+}
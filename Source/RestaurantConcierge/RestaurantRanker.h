@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+
+// Orders search results. Subclasses only provide the score; selection keeps the
+// best K in a bounded heap, so ranking hundreds of merged candidates for a top
+// ten costs O(n log K) and never a full sort.
+class RESTAURANTCONCIERGE_API FRestaurantRanker
+{
+public:
+    virtual ~FRestaurantRanker() = default;
+
+    // Higher ranks first. DistanceFromUser is already set when this is called.
+    virtual float Score(const FRestaurantData& Restaurant, const FSearchFilters& Filters) const = 0;
+
+    // Fills OutOrder with indices into Restaurants: the best K in rank order, then the
+    // rest in their original order. Ties fall back to the review count and then the
+    // original position, so the order is total and repeatable.
+    void Rank(const TArray<FRestaurantData>& Restaurants, const FSearchFilters& Filters, int32 K, TArray<int32>& OutOrder) const;
+
+    // Reorders Restaurants in place, see Rank
+    void RankInPlace(TArray<FRestaurantData>& Restaurants, const FSearchFilters& Filters, int32 K) const;
+};
+
+// Weighted sum of a Bayesian-smoothed rating, a distance falloff and the share
+// of requested cuisines matched
+class RESTAURANTCONCIERGE_API FWeightedRestaurantRanker : public FRestaurantRanker
+{
+public:
+    FRestaurantRankingWeights Weights;
+
+    virtual float Score(const FRestaurantData& Restaurant, const FSearchFilters& Filters) const override;
+};
@@ -0,0 +1,325 @@
+#include "RestaurantRequestScheduler.h"
+#include "RestaurantHttpClient.h"
+#include "Interfaces/IHttpResponse.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+    // Share of the rate burst and of the daily quota each priority must leave untouched
+    constexpr float BurstReserve[] = { 0.0f, 0.25f, 0.5f, 0.5f };
+    constexpr float DailyReserve[] = { 0.0f, 0.1f, 0.2f, 0.3f };
+
+    // How often queued requests are reconsidered
+    constexpr float PumpIntervalSeconds = 0.05f;
+
+    // Backoff after a 429 without Retry-After, doubling per consecutive 429
+    constexpr double RateLimitBackoffSeconds = 1.0;
+    constexpr double MaxRateLimitBackoffSeconds = 30.0;
+
+    // Longest Retry-After honoured, beyond it the provider is just tried again
+    constexpr double MaxRetryAfterSeconds = 60.0;
+}
+
+void FRestaurantTokenBucket::Configure(float InRatePerSecond, float InBurst)
+{
+    Rate = FMath::Max(InRatePerSecond, 0.0f);
+    Burst = FMath::Max(InBurst, 1.0f);
+    Tokens = FMath::Min(Tokens, Burst);
+}
+
+void FRestaurantTokenBucket::Refill(double Now)
+{
+    if (LastRefill < 0.0)
+    {
+        Tokens = Burst;
+    }
+    else
+    {
+        Tokens = FMath::Min(Burst, Tokens + static_cast<float>((Now - LastRefill) * Rate));
+    }
+    LastRefill = Now;
+}
+
+bool FRestaurantTokenBucket::TryTake(float Reserve)
+{
+    if (Tokens - 1.0f < Reserve)
+    {
+        return false;
+    }
+
+    Tokens -= 1.0f;
+    return true;
+}
+
+FRestaurantRequestScheduler::FRestaurantRequestScheduler(TSharedRef<FRestaurantHttpClient> InHttpClient)
+    : HttpClient(InHttpClient)
+{
+}
+
+FRestaurantRequestScheduler::~FRestaurantRequestScheduler()
+{
+    if (PumpTicker.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(PumpTicker);
+    }
+    if (FailTicker.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(FailTicker);
+    }
+}
+
+void FRestaurantRequestScheduler::Send(const FRestaurantProvider& Provider, ERestaurantRequestPriority Priority, TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request,
+    bool bExtraAttempt, FHttpRequestCompleteDelegate OnComplete)
+{
+    FQueuedRequest Queued;
+    Queued.Request = Request;
+    Queued.Endpoint = Provider.GetName();
+    Queued.QuotaKey = Provider.GetQuotaKey();
+    Queued.Policy = Provider.Policy;
+    Queued.bExtraAttempt = bExtraAttempt;
+    Queued.OnComplete = MoveTemp(OnComplete);
+    Queues[static_cast<int32>(Priority)].Add(MoveTemp(Queued));
+
+    // Usually there is budget and the request leaves right away
+    if (Pump() && !PumpTicker.IsValid())
+    {
+        PumpTicker = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(AsShared(), &FRestaurantRequestScheduler::OnPumpTick), PumpIntervalSeconds);
+    }
+}
+
+void FRestaurantRequestScheduler::Cancel(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request)
+{
+    auto IsRequest = [&Request](const FQueuedRequest& Queued)
+    {
+        return Queued.Request.Get() == &Request.Get();
+    };
+
+    for (TArray<FQueuedRequest>& Queue : Queues)
+    {
+        const int32 Index = Queue.IndexOfByPredicate(IsRequest);
+        if (Index != INDEX_NONE)
+        {
+            const FString Endpoint = Queue[Index].Endpoint;
+            Queue.RemoveAt(Index);
+            ReleaseProbeIfUnqueued(Endpoint);
+            return;
+        }
+    }
+    if (Failed.RemoveAll(IsRequest) > 0)
+    {
+        return;
+    }
+
+    HttpClient->Cancel(Request);
+}
+
+bool FRestaurantRequestScheduler::IsAvailable(const FRestaurantProvider& Provider, ERestaurantRequestPriority Priority)
+{
+    if (!HasDailyQuota(GetKeyBudget(Provider.GetQuotaKey(), Provider.Policy), Priority))
+    {
+        UE_LOG(LogTemp, Verbose, TEXT("%s daily quota is used up for this priority"), *Provider.GetName());
+        return false;
+    }
+    return HttpClient->IsAvailable(Provider.GetName(), Provider.Policy);
+}
+
+void FRestaurantRequestScheduler::GetQuotaStatus(const TArray<TSharedPtr<FRestaurantProvider>>& Providers, TArray<FRestaurantQuotaStatus>& OutStatus)
+{
+    const double Now = FPlatformTime::Seconds();
+    OutStatus.Reset(Providers.Num());
+
+    for (const TSharedPtr<FRestaurantProvider>& Provider : Providers)
+    {
+        FEndpointBudget& Endpoint = GetEndpointBudget(Provider->GetName(), Provider->Policy);
+        FKeyBudget& Key = GetKeyBudget(Provider->GetQuotaKey(), Provider->Policy);
+        Endpoint.Bucket.Refill(Now);
+
+        FRestaurantQuotaStatus& Status = OutStatus.AddDefaulted_GetRef();
+        Status.Provider = Provider->GetName();
+        Status.RateTokens = Endpoint.Bucket.GetTokens();
+        Status.DailyRemaining = Key.DailyQuota > 0 ? FMath::Max(Key.DailyQuota - Key.UsedToday, 0) : -1;
+        Status.BackoffSeconds = static_cast<float>(FMath::Max(Endpoint.BackoffUntil - Now, 0.0));
+
+        for (const TArray<FQueuedRequest>& Queue : Queues)
+        {
+            for (const FQueuedRequest& Queued : Queue)
+            {
+                Status.QueuedRequests += Queued.Endpoint == Status.Provider ? 1 : 0;
+            }
+        }
+    }
+}
+
+FRestaurantRequestScheduler::FEndpointBudget& FRestaurantRequestScheduler::GetEndpointBudget(const FString& Endpoint, const FRestaurantProviderPolicy& Policy)
+{
+    FEndpointBudget& Budget = EndpointBudgets.FindOrAdd(Endpoint);
+    Budget.Bucket.Configure(Policy.RequestsPerSecond, Policy.BurstSize);
+    return Budget;
+}
+
+FRestaurantRequestScheduler::FKeyBudget& FRestaurantRequestScheduler::GetKeyBudget(const FString& QuotaKey, const FRestaurantProviderPolicy& Policy)
+{
+    FKeyBudget& Budget = KeyBudgets.FindOrAdd(QuotaKey);
+    Budget.DailyQuota = Policy.DailyQuota;
+
+    // Provider quotas reset at midnight UTC
+    const FDateTime Today = FDateTime::UtcNow().GetDate();
+    if (Budget.Day != Today)
+    {
+        Budget.Day = Today;
+        Budget.UsedToday = 0;
+    }
+    return Budget;
+}
+
+void FRestaurantRequestScheduler::ReportRateLimited(const FRestaurantProvider& Provider)
+{
+    BackOff(GetEndpointBudget(Provider.GetName(), Provider.Policy), Provider.GetName(), 0.0);
+
+    // The transport saw a success, but for the circuit this is the same as a 429
+    HttpClient->RecordFailure(Provider.GetName(), Provider.Policy);
+}
+
+void FRestaurantRequestScheduler::BackOff(FEndpointBudget& Budget, const FString& Endpoint, double RetryAfterSeconds)
+{
+    // A huge Retry-After would take the provider out of every search, so it is capped
+    double Backoff = 0.0;
+    if (RetryAfterSeconds > 0.0)
+    {
+        Backoff = FMath::Min(RetryAfterSeconds, MaxRetryAfterSeconds);
+    }
+    else
+    {
+        Backoff = FMath::Min(RateLimitBackoffSeconds * FMath::Pow(2.0, Budget.ConsecutiveRateLimits), MaxRateLimitBackoffSeconds);
+    }
+    Budget.ConsecutiveRateLimits++;
+    Budget.BackoffUntil = FPlatformTime::Seconds() + Backoff;
+    UE_LOG(LogTemp, Warning, TEXT("%s is rate limiting, pausing requests for %.1fs"), *Endpoint, Backoff);
+}
+
+bool FRestaurantRequestScheduler::HasDailyQuota(FKeyBudget& Key, ERestaurantRequestPriority Priority) const
+{
+    if (Key.DailyQuota <= 0)
+    {
+        return true;
+    }
+
+    const int32 Reserved = FMath::CeilToInt32(Key.DailyQuota * DailyReserve[static_cast<int32>(Priority)]);
+    return Key.UsedToday < Key.DailyQuota - Reserved;
+}
+
+bool FRestaurantRequestScheduler::OnPumpTick(float DeltaTime)
+{
+    if (Pump())
+    {
+        return true;
+    }
+
+    PumpTicker.Reset();
+    return false;
+}
+
+bool FRestaurantRequestScheduler::Pump()
+{
+    const double Now = FPlatformTime::Seconds();
+    bool bAnyQueued = false;
+
+    // Strictly by priority: nothing lower goes out while a higher request for the same provider waits
+    TSet<FString> BlockedEndpoints;
+    for (int32 Priority = 0; Priority < static_cast<int32>(ERestaurantRequestPriority::Count); Priority++)
+    {
+        TArray<FQueuedRequest>& Queue = Queues[Priority];
+        for (int32 i = 0; i < Queue.Num();)
+        {
+            FQueuedRequest& Queued = Queue[i];
+            FEndpointBudget& Endpoint = GetEndpointBudget(Queued.Endpoint, Queued.Policy);
+            FKeyBudget& Key = GetKeyBudget(Queued.QuotaKey, Queued.Policy);
+
+            if (!HasDailyQuota(Key, static_cast<ERestaurantRequestPriority>(Priority)))
+            {
+                // Waiting will not help before midnight, fail it like any other unavailable request
+                UE_LOG(LogTemp, Warning, TEXT("%s daily quota exhausted, dropping a queued request"), *Queued.Endpoint);
+                FQueuedRequest Dropped = MoveTemp(Queued);
+                Queue.RemoveAt(i);
+                ReleaseProbeIfUnqueued(Dropped.Endpoint);
+                FailLater(MoveTemp(Dropped));
+                continue;
+            }
+
+            Endpoint.Bucket.Refill(Now);
+            const float Reserve = Endpoint.Bucket.GetBurst() * BurstReserve[Priority];
+            if (BlockedEndpoints.Contains(Queued.Endpoint) || Now < Endpoint.BackoffUntil || !Endpoint.Bucket.TryTake(Reserve))
+            {
+                BlockedEndpoints.Add(Queued.Endpoint);
+                bAnyQueued = true;
+                i++;
+                continue;
+            }
+
+            Key.UsedToday++;
+            FQueuedRequest Ready = MoveTemp(Queued);
+            Queue.RemoveAt(i);
+            Dispatch(MoveTemp(Ready));
+        }
+    }
+
+    return bAnyQueued;
+}
+
+void FRestaurantRequestScheduler::ReleaseProbeIfUnqueued(const FString& Endpoint)
+{
+    for (const TArray<FQueuedRequest>& Queue : Queues)
+    {
+        if (Queue.ContainsByPredicate([&Endpoint](const FQueuedRequest& Queued) { return Queued.Endpoint == Endpoint; }))
+        {
+            return;
+        }
+    }
+    HttpClient->ReleaseReservedProbe(Endpoint);
+}
+
+void FRestaurantRequestScheduler::FailLater(FQueuedRequest&& Queued)
+{
+    Failed.Add(MoveTemp(Queued));
+    if (!FailTicker.IsValid())
+    {
+        FailTicker = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(AsShared(), &FRestaurantRequestScheduler::OnFailTick), 0.0f);
+    }
+}
+
+bool FRestaurantRequestScheduler::OnFailTick(float DeltaTime)
+{
+    FailTicker.Reset();
+
+    // Handlers may send or cancel requests, which must not touch the list being walked
+    TArray<FQueuedRequest> Failing = MoveTemp(Failed);
+    for (FQueuedRequest& Queued : Failing)
+    {
+        Queued.OnComplete.ExecuteIfBound(Queued.Request, nullptr, false);
+    }
+    return false;
+}
+
+void FRestaurantRequestScheduler::Dispatch(FQueuedRequest&& Queued)
+{
+    HttpClient->Send(Queued.Endpoint, Queued.Request.ToSharedRef(), Queued.Policy, Queued.bExtraAttempt,
+        FHttpRequestCompleteDelegate::CreateSP(AsShared(), &FRestaurantRequestScheduler::OnRequestComplete, Queued.Endpoint, MoveTemp(Queued.OnComplete)));
+}
+
+void FRestaurantRequestScheduler::OnRequestComplete(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, FString Endpoint, FHttpRequestCompleteDelegate OnComplete)
+{
+    if (FEndpointBudget* Budget = EndpointBudgets.Find(Endpoint))
+    {
+        if (Response.IsValid() && Response->GetResponseCode() == EHttpResponseCodes::TooManyRequests)
+        {
+            // Honour Retry-After when it is given in seconds
+            BackOff(*Budget, Endpoint, FCString::Atod(*Response->GetHeader(TEXT("Retry-After"))));
+        }
+        else if (bWasSuccessful)
+        {
+            Budget->ConsecutiveRateLimits = 0;
+        }
+    }
+
+    OnComplete.ExecuteIfBound(Request, Response, bWasSuccessful);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Containers/Ticker.h"
+#include "RestaurantData.h"
+#include "RestaurantProvider.h"
+
+class FRestaurantHttpClient;
+
+// Who is waiting on a request, most urgent first
+enum class ERestaurantRequestPriority : uint8
+{
+    // A search someone is waiting on
+    Interactive,
+    // Enrichment of results that are already on screen
+    Details,
+    // Further result pages nobody asked for yet
+    Prefetch,
+    // Refreshing cache entries ahead of need
+    CacheWarming,
+    Count
+};
+
+// Refills continuously at Rate per second up to Burst
+class RESTAURANTCONCIERGE_API FRestaurantTokenBucket
+{
+public:
+    void Configure(float InRatePerSecond, float InBurst);
+    void Refill(double Now);
+
+    // Takes one token if at least Reserve would be left afterwards
+    bool TryTake(float Reserve);
+
+    float GetTokens() const { return Tokens; }
+    float GetBurst() const { return Burst; }
+
+private:
+    float Rate = 0.0f;
+    float Burst = 0.0f;
+    float Tokens = 0.0f;
+    double LastRefill = -1.0;
+};
+
+// Sits between the data manager and FRestaurantHttpClient. Every provider
+// request is queued by priority and only sent once the provider's rate bucket
+// and its key's daily quota allow it. Lower priorities may not dip into the
+// share of either that is reserved for higher ones, so prefetching can never
+// rate-limit a live conversation. A 429 pauses the provider for its Retry-After,
+// up to a minute.
+class RESTAURANTCONCIERGE_API FRestaurantRequestScheduler : public TSharedFromThis<FRestaurantRequestScheduler, ESPMode::ThreadSafe>
+{
+public:
+    explicit FRestaurantRequestScheduler(TSharedRef<FRestaurantHttpClient> InHttpClient);
+    ~FRestaurantRequestScheduler();
+
+    // Same contract as FRestaurantHttpClient::Send, except that the request may wait in the queue first
+    void Send(const FRestaurantProvider& Provider, ERestaurantRequestPriority Priority, TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request,
+        bool bExtraAttempt, FHttpRequestCompleteDelegate OnComplete);
+
+    // Drops a queued request or aborts a sent one; OnComplete does not fire
+    void Cancel(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request);
+
+    // False if the provider's circuit is open or its key has no quota left at this priority
+    bool IsAvailable(const FRestaurantProvider& Provider, ERestaurantRequestPriority Priority);
+
+    // A response the provider answered with HTTP 200 turned out to be a rate limit
+    // error; treated like a 429 without Retry-After
+    void ReportRateLimited(const FRestaurantProvider& Provider);
+
+    void GetQuotaStatus(const TArray<TSharedPtr<FRestaurantProvider>>& Providers, TArray<FRestaurantQuotaStatus>& OutStatus);
+
+private:
+    struct FQueuedRequest
+    {
+        TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request;
+        FString Endpoint;
+        FString QuotaKey;
+        FRestaurantProviderPolicy Policy;
+        bool bExtraAttempt = false;
+        FHttpRequestCompleteDelegate OnComplete;
+    };
+
+    // Rate limit and 429 backoff of one provider
+    struct FEndpointBudget
+    {
+        FRestaurantTokenBucket Bucket;
+        double BackoffUntil = 0.0;
+        int32 ConsecutiveRateLimits = 0;
+    };
+
+    // Daily quota of one API key
+    struct FKeyBudget
+    {
+        int32 DailyQuota = 0;
+        int32 UsedToday = 0;
+        FDateTime Day;
+    };
+
+    FEndpointBudget& GetEndpointBudget(const FString& Endpoint, const FRestaurantProviderPolicy& Policy);
+    FKeyBudget& GetKeyBudget(const FString& QuotaKey, const FRestaurantProviderPolicy& Policy);
+
+    // Pauses the endpoint for RetryAfterSeconds, or exponentially longer per consecutive limit if 0
+    void BackOff(FEndpointBudget& Budget, const FString& Endpoint, double RetryAfterSeconds);
+    bool HasDailyQuota(FKeyBudget& Key, ERestaurantRequestPriority Priority) const;
+
+    // Sends whatever the budgets allow; true if anything is still queued
+    bool Pump();
+    bool OnPumpTick(float DeltaTime);
+
+    // Fails requests Pump had to drop. Never from inside Send, whose caller may
+    // not be ready for its OnComplete yet.
+    void FailLater(FQueuedRequest&& Queued);
+
+    // A queued request left without being sent. Unless another request for the
+    // endpoint is still queued to carry it, the probe IsAvailable reserved is given back.
+    void ReleaseProbeIfUnqueued(const FString& Endpoint);
+    bool OnFailTick(float DeltaTime);
+    void Dispatch(FQueuedRequest&& Queued);
+    void OnRequestComplete(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful, FString Endpoint, FHttpRequestCompleteDelegate OnComplete);
+
+    TSharedRef<FRestaurantHttpClient> HttpClient;
+    TMap<FString, FEndpointBudget> EndpointBudgets;
+    TMap<FString, FKeyBudget> KeyBudgets;
+    TArray<FQueuedRequest> Queues[static_cast<int32>(ERestaurantRequestPriority::Count)];
+    FTSTicker::FDelegateHandle PumpTicker;
+
+    // Dropped requests whose OnComplete runs on the next tick
+    TArray<FQueuedRequest> Failed;
+    FTSTicker::FDelegateHandle FailTicker;
+};
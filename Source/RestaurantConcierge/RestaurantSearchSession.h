@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpRequest.h"
+#include "RestaurantData.h"
+#include "RestaurantEntityResolver.h"
+#include "RestaurantProvider.h"
+#include "Engine/TimerHandle.h"
+
+// A caller waiting on a provider search. Coalesced callers share the provider
+// requests but keep their own session id, location and local filters.
+struct FRestaurantSearchSubscriber
+{
+    int32 SessionId = INDEX_NONE;
+    FVector2D Location = FVector2D::ZeroVector;
+    FSearchFilters Filters;
+
+    // Background refresh of stale cached results already delivered to SessionId
+    bool bRevalidation = false;
+
+    // What SessionId was last given, later changes go out through OnSearchRevalidated
+    uint32 DeliveredFingerprint = 0;
+
+    // Progressive delivery: index into the session results -> row hash as last sent
+    TMap<int32, uint32> DeliveredHashes;
+};
+
+// One provider's part of a search. Holds every attempt sent to it (the first
+// request plus hedges and retries); the first successful response wins.
+struct FRestaurantProviderCall
+{
+    TSharedPtr<FRestaurantProvider> Provider;
+
+    TArray<TSharedRef<IHttpRequest, ESPMode::ThreadSafe>> Requests;
+    int32 AttemptsSent = 0;
+    int32 AttemptsInFlight = 0;
+    FTimerHandle HedgeTimer;
+    FTimerHandle RetryTimer;
+
+    // A response was accepted and is being parsed, later responses are ignored
+    bool bResponded = false;
+    bool bComplete = false;
+
+    // The last page was short and had no successor, so every match has arrived
+    bool bExhaustive = false;
+
+    // Background pagination after the first page
+    FString NextPageToken;
+    int32 PagesFetched = 0;
+    FTimerHandle PageTimer;
+    bool bPrefetching = false;
+};
+
+// In-flight provider work for one or more SearchRestaurants calls, identified by
+// the session id of the call that started it. Provider callbacks carry that id,
+// so responses for cancelled or already finished searches are recognised as
+// stale and dropped.
+struct FRestaurantSearchSession
+{
+    int32 SessionId = INDEX_NONE;
+
+    FVector2D Location = FVector2D::ZeroVector;
+
+    // Filters sent to providers, the query class of the first caller
+    FSearchFilters ProviderFilters;
+    FString QueryClass;
+
+    TArray<FRestaurantSearchSubscriber> Subscribers;
+
+    // Merged results of every provider that has answered so far
+    TArray<FRestaurantData> Results;
+    FRestaurantEntityResolver Resolver;
+
+    // One entry per configured provider, in registration order
+    TArray<FRestaurantProviderCall> ProviderCalls;
+
+    // Fires when the search has to answer with whatever has arrived
+    FTimerHandle DeadlineTimer;
+
+    // ARestaurantDataManager's cache generation when the search started. Results
+    // of a search that outlived a ClearCache are delivered but not cached.
+    uint32 CacheGeneration = 0;
+
+    // A provider failed or missed the deadline
+    bool bPartial = false;
+    bool bCancelled = false;
+
+    // Every restaurant the providers know in the circle is here. Only such results
+    // fill cache tiles, a capped answer would hide the rest from other circles.
+    bool IsExhaustive() const
+    {
+        return !bPartial && !ProviderCalls.ContainsByPredicate([](const FRestaurantProviderCall& Call) { return !Call.bExhaustive; });
+    }
+};
@@ -0,0 +1,577 @@
+#include "RestaurantTileCache.h"
+#include "RestaurantGeo.h"
+
+namespace
+{
+    // Pools smaller than this are never worth rebuilding
+    constexpr int32 MinStringsToCompact = 1024;
+
+    // Capped answers kept at once, the least recently used beyond this are dropped
+    constexpr int32 MaxCappedAnswers = 64;
+
+    // Circles whose centers are this close count as the same query
+    constexpr double SameCenterMeters = 1.0;
+}
+
+FRestaurantTileCache::FRestaurantTileCache()
+{
+    Stats.BudgetBytes = BudgetBytes;
+}
+
+FString FRestaurantTileCache::GetQueryClass(const FSearchFilters& Filters)
+{
+    TArray<FString> Cuisines;
+    Cuisines.Reserve(Filters.CuisineTypes.Num());
+    for (const FString& Cuisine : Filters.CuisineTypes)
+    {
+        Cuisines.AddUnique(Cuisine.TrimStartAndEnd().ToLower());
+    }
+    Cuisines.Sort();
+
+    return FString::Printf(TEXT("%s|%d"), *FString::Join(Cuisines, TEXT(",")), Filters.bOpenNow ? 1 : 0);
+}
+
+void FRestaurantTileCache::SetLimits(int64 InBudgetBytes, float InTimeToLiveMinutes)
+{
+    BudgetBytes = FMath::Max<int64>(InBudgetBytes, 0);
+    TimeToLiveMinutes = InTimeToLiveMinutes;
+    Stats.BudgetBytes = BudgetBytes;
+
+    EvictExpired();
+    EvictToFit(BudgetBytes);
+}
+
+SIZE_T FRestaurantTileCache::ComputeTileBytes(const FTile& Tile)
+{
+    // Key and bucket overhead are approximated by the key size
+    return sizeof(FTile) + sizeof(uint64) + Tile.Restaurants.GetAllocatedSize();
+}
+
+SIZE_T FRestaurantTileCache::ComputeAnswerBytes(const FCappedAnswer& Answer)
+{
+    return sizeof(FCappedAnswer) + sizeof(uint64) + Answer.QueryClass.GetAllocatedSize() + Answer.Restaurants.GetAllocatedSize();
+}
+
+bool FRestaurantTileCache::IsCovered(const FTile& Tile, const FVector2D& Center, float RadiusMeters)
+{
+    // A partly covered tile only answers circles inside the one it was fetched for
+    return Tile.Coverage.bFullTile ||
+        FRestaurantGeo::HaversineMeters(Tile.Coverage.Center, Center) + RadiusMeters <= Tile.Coverage.RadiusMeters;
+}
+
+void FRestaurantTileCache::ForEachTile(const FVector2D& Center, float RadiusMeters,
+    TFunctionRef<void(const FIntPoint& Tile, bool bFullyInside)> Visitor)
+{
+    const double CosLat = FMath::Max(FMath::Cos(FMath::DegreesToRadians(static_cast<double>(Center.X))), 0.01);
+    const double DeltaLat = RadiusMeters / FRestaurantGeo::MetersPerDegreeLatitude;
+    const double DeltaLng = RadiusMeters / (FRestaurantGeo::MetersPerDegreeLatitude * CosLat);
+
+    // Tile Y grows southwards, so the north-west corner gives the minimum tile
+    const FIntPoint MinTile = FRestaurantGeo::GetTile(FVector2D(Center.X + DeltaLat, Center.Y - DeltaLng), TileLevel);
+    const FIntPoint MaxTile = FRestaurantGeo::GetTile(FVector2D(Center.X - DeltaLat, Center.Y + DeltaLng), TileLevel);
+
+    for (int32 Y = MinTile.Y; Y <= MaxTile.Y; Y++)
+    {
+        for (int32 X = MinTile.X; X <= MaxTile.X; X++)
+        {
+            const FIntPoint Tile(X, Y);
+            FVector2D Min, Max;
+            FRestaurantGeo::GetTileBounds(Tile, TileLevel, Min, Max);
+
+            const FVector2D Closest(
+                FMath::Clamp(Center.X, Min.X, Max.X),
+                FMath::Clamp(Center.Y, Min.Y, Max.Y));
+            if (FRestaurantGeo::HaversineMeters(Center, Closest) > RadiusMeters)
+            {
+                continue;
+            }
+
+            const bool bFullyInside =
+                FRestaurantGeo::HaversineMeters(Center, Min) <= RadiusMeters &&
+                FRestaurantGeo::HaversineMeters(Center, Max) <= RadiusMeters &&
+                FRestaurantGeo::HaversineMeters(Center, FVector2D(Min.X, Max.Y)) <= RadiusMeters &&
+                FRestaurantGeo::HaversineMeters(Center, FVector2D(Max.X, Min.Y)) <= RadiusMeters;
+
+            Visitor(Tile, bFullyInside);
+        }
+    }
+}
+
+void FRestaurantTileCache::Store(const FVector2D& Center, float RadiusMeters, const FSearchFilters& Filters,
+    const TArray<FRestaurantData>& Results)
+{
+    TMap<uint64, TArray<const FRestaurantData*>> ResultsByTile;
+    for (const FRestaurantData& Restaurant : Results)
+    {
+        if (FRestaurantGeo::IsValidLocation(Restaurant.Location))
+        {
+            ResultsByTile.FindOrAdd(FRestaurantGeo::EncodeMorton(FRestaurantGeo::GetTile(Restaurant.Location, TileLevel))).Add(&Restaurant);
+        }
+    }
+
+    TMap<uint64, FTile>& ClassTiles = Tiles.FindOrAdd(GetQueryClass(Filters));
+    const FDateTime Now = FDateTime::UtcNow();
+    bDirty = true;
+
+    // Fresh results replace whatever the tile held, even if it was complete for more of it.
+    // Tiles without results are stored empty, the providers know nothing there.
+    const TArray<const FRestaurantData*> NoResults;
+    ForEachTile(Center, RadiusMeters, [&](const FIntPoint& Tile, bool bFullyInside)
+    {
+        const uint64 Key = FRestaurantGeo::EncodeMorton(Tile);
+        const TArray<const FRestaurantData*>* TileResults = ResultsByTile.Find(Key);
+        if (!TileResults)
+        {
+            TileResults = &NoResults;
+        }
+
+        FTile* Entry = ClassTiles.Find(Key);
+        if (Entry)
+        {
+            Stats.UsedBytes -= Entry->AllocatedBytes;
+        }
+        else
+        {
+            Entry = &ClassTiles.Add(Key);
+            Stats.NumEntries++;
+        }
+
+        Entry->CachedAt = Now;
+        Entry->LastAccess = ++AccessCounter;
+        Entry->bDirty = true;
+        Entry->Coverage.Center = Center;
+        Entry->Coverage.RadiusMeters = RadiusMeters;
+        Entry->Coverage.bFullTile = bFullyInside;
+        Entry->Restaurants = FRestaurantColumns();
+        Entry->Restaurants.Reserve(TileResults->Num());
+        for (const FRestaurantData* Restaurant : *TileResults)
+        {
+            Entry->Restaurants.Add(*Restaurant, StringPool);
+        }
+        Entry->Restaurants.Shrink();
+
+        Entry->AllocatedBytes = ComputeTileBytes(*Entry);
+        Stats.UsedBytes += Entry->AllocatedBytes;
+    });
+    UpdateStringPoolBytes();
+
+    if (Stats.UsedBytes > BudgetBytes)
+    {
+        // Evict down to a low watermark so the next few stores don't evict again
+        EvictExpired();
+        EvictToFit(BudgetBytes - BudgetBytes / 10);
+    }
+}
+
+void FRestaurantTileCache::StoreCapped(const FVector2D& Center, float RadiusMeters, const FSearchFilters& Filters,
+    const TArray<FRestaurantData>& Results)
+{
+    const FString QueryClass = GetQueryClass(Filters);
+
+    // A later page of the same search replaces the shorter answer
+    for (const TPair<uint64, FCappedAnswer>& Other : CappedAnswers)
+    {
+        if (Other.Value.QueryClass == QueryClass && Other.Value.RadiusMeters == RadiusMeters &&
+            FRestaurantGeo::HaversineMeters(Other.Value.Center, Center) <= SameCenterMeters)
+        {
+            RemoveCappedAnswer(Other.Key);
+            break;
+        }
+    }
+
+    FCappedAnswer& Answer = CappedAnswers.Add(NextCappedAnswerId++);
+    Answer.QueryClass = QueryClass;
+    Answer.CachedAt = FDateTime::UtcNow();
+    Answer.Center = Center;
+    Answer.RadiusMeters = RadiusMeters;
+    Answer.LastAccess = ++AccessCounter;
+    Answer.Restaurants.Reserve(Results.Num());
+    for (const FRestaurantData& Restaurant : Results)
+    {
+        if (FRestaurantGeo::IsValidLocation(Restaurant.Location))
+        {
+            Answer.Restaurants.Add(Restaurant, StringPool);
+        }
+    }
+    Answer.Restaurants.Shrink();
+    Answer.AllocatedBytes = ComputeAnswerBytes(Answer);
+
+    Stats.NumEntries++;
+    Stats.UsedBytes += Answer.AllocatedBytes;
+    UpdateStringPoolBytes();
+
+    if (CappedAnswers.Num() > MaxCappedAnswers)
+    {
+        uint64 OldestId = 0;
+        uint64 OldestAccess = MAX_uint64;
+        for (const TPair<uint64, FCappedAnswer>& Other : CappedAnswers)
+        {
+            if (Other.Value.LastAccess < OldestAccess)
+            {
+                OldestAccess = Other.Value.LastAccess;
+                OldestId = Other.Key;
+            }
+        }
+        RemoveCappedAnswer(OldestId);
+        Stats.Evictions++;
+    }
+
+    if (Stats.UsedBytes > BudgetBytes)
+    {
+        EvictExpired();
+        EvictToFit(BudgetBytes - BudgetBytes / 10);
+    }
+}
+
+void FRestaurantTileCache::RemoveCappedAnswer(uint64 Id)
+{
+    FCappedAnswer Removed;
+    if (CappedAnswers.RemoveAndCopyValue(Id, Removed))
+    {
+        Stats.UsedBytes -= Removed.AllocatedBytes;
+        Stats.NumEntries--;
+    }
+}
+
+bool FRestaurantTileCache::Lookup(const FVector2D& Center, float RadiusMeters, const FSearchFilters& Filters, float MaxAgeMinutes,
+    TArray<FRestaurantData>& OutResults, FTimespan* OutAge)
+{
+    OutResults.Reset();
+
+    const FString QueryClass = GetQueryClass(Filters);
+    const FDateTime Now = FDateTime::UtcNow();
+    FDateTime CachedAt = Now;
+
+    // Complete tiles first, they hold everything the providers know rather than their top results
+    const bool bFound = LookupTiles(QueryClass, Center, RadiusMeters, MaxAgeMinutes, Now, OutResults, CachedAt) ||
+        LookupCapped(QueryClass, Center, RadiusMeters, MaxAgeMinutes, Now, OutResults, CachedAt);
+
+    // Tiles faulted in from the backing store count against the budget as well
+    if (Stats.UsedBytes > BudgetBytes)
+    {
+        EvictToFit(BudgetBytes - BudgetBytes / 10);
+    }
+
+    if (!bFound)
+    {
+        Stats.Misses++;
+        return false;
+    }
+
+    if (OutAge)
+    {
+        *OutAge = Now - CachedAt;
+    }
+
+    Stats.Hits++;
+    return true;
+}
+
+bool FRestaurantTileCache::LookupTiles(const FString& QueryClass, const FVector2D& Center, float RadiusMeters, float MaxAgeMinutes,
+    const FDateTime& Now, TArray<FRestaurantData>& OutResults, FDateTime& OutCachedAt)
+{
+    TMap<uint64, FTile>* ClassTiles = BackingStore ? &Tiles.FindOrAdd(QueryClass) : Tiles.Find(QueryClass);
+    if (!ClassTiles)
+    {
+        return false;
+    }
+
+    const uint64 Access = ++AccessCounter;
+    FDateTime OldestCachedAt = Now;
+    bool bCovered = true;
+
+    ForEachTile(Center, RadiusMeters, [&](const FIntPoint& Tile, bool bFullyInside)
+    {
+        if (!bCovered)
+        {
+            return;
+        }
+
+        const uint64 Key = FRestaurantGeo::EncodeMorton(Tile);
+        FTile* Entry = ClassTiles->Find(Key);
+        if (!Entry && BackingStore)
+        {
+            Entry = FaultInTile(QueryClass, *ClassTiles, Key);
+        }
+
+        if (!Entry || (Now - Entry->CachedAt).GetTotalMinutes() >= MaxAgeMinutes || !IsCovered(*Entry, Center, RadiusMeters))
+        {
+            bCovered = false;
+            return;
+        }
+
+        Entry->LastAccess = Access;
+        OldestCachedAt = FMath::Min(OldestCachedAt, Entry->CachedAt);
+        AppendRowsWithin(Entry->Restaurants, Center, RadiusMeters, OutResults);
+    });
+
+    if (!bCovered)
+    {
+        OutResults.Reset();
+        return false;
+    }
+
+    OutCachedAt = OldestCachedAt;
+    return true;
+}
+
+bool FRestaurantTileCache::LookupCapped(const FString& QueryClass, const FVector2D& Center, float RadiusMeters, float MaxAgeMinutes,
+    const FDateTime& Now, TArray<FRestaurantData>& OutResults, FDateTime& OutCachedAt)
+{
+    // The freshest answer whose circle contains this one
+    FCappedAnswer* Best = nullptr;
+    for (TPair<uint64, FCappedAnswer>& Answer : CappedAnswers)
+    {
+        FCappedAnswer& Candidate = Answer.Value;
+        if (Candidate.QueryClass == QueryClass && (Now - Candidate.CachedAt).GetTotalMinutes() < MaxAgeMinutes &&
+            FRestaurantGeo::HaversineMeters(Candidate.Center, Center) + RadiusMeters <= Candidate.RadiusMeters + SameCenterMeters &&
+            (!Best || Candidate.CachedAt > Best->CachedAt))
+        {
+            Best = &Candidate;
+        }
+    }
+
+    if (!Best)
+    {
+        return false;
+    }
+
+    Best->LastAccess = ++AccessCounter;
+    OutCachedAt = Best->CachedAt;
+    AppendRowsWithin(Best->Restaurants, Center, RadiusMeters, OutResults);
+    return true;
+}
+
+void FRestaurantTileCache::AppendRowsWithin(const FRestaurantColumns& Columns, const FVector2D& Center, float RadiusMeters, TArray<FRestaurantData>& OutResults)
+{
+    // Distances for the whole block in one pass, only rows inside the circle are materialized
+    TArray<float, TInlineAllocator<64>> Distances;
+    Distances.SetNumUninitialized(Columns.Num());
+    FRestaurantGeo::HaversineMetersBatch(Center, Columns.GetLatitudes(), Columns.GetLongitudes(), Columns.Num(), Distances.GetData());
+    for (int32 Row = 0; Row < Columns.Num(); Row++)
+    {
+        if (Distances[Row] <= RadiusMeters)
+        {
+            FRestaurantData& Result = OutResults.AddDefaulted_GetRef();
+            Columns.Materialize(Row, StringPool, Result);
+            Result.DistanceFromUser = Distances[Row];
+        }
+    }
+}
+
+FRestaurantTileCache::FTile* FRestaurantTileCache::FaultInTile(const FString& QueryClass, TMap<uint64, FTile>& ClassTiles, uint64 Key)
+{
+    FDateTime CachedAt;
+    FRestaurantTileCoverage Coverage;
+    TArray<FRestaurantData> Restaurants;
+    if (!BackingStore->LoadTile(QueryClass, Key, CachedAt, Coverage, Restaurants) ||
+        (FDateTime::UtcNow() - CachedAt).GetTotalMinutes() >= TimeToLiveMinutes)
+    {
+        return nullptr;
+    }
+
+    FTile& Entry = ClassTiles.Add(Key);
+    Entry.Restaurants.Reserve(Restaurants.Num());
+    for (const FRestaurantData& Restaurant : Restaurants)
+    {
+        Entry.Restaurants.Add(Restaurant, StringPool);
+    }
+    Entry.Restaurants.Shrink();
+    Entry.CachedAt = CachedAt;
+    Entry.Coverage = Coverage;
+    Entry.AllocatedBytes = ComputeTileBytes(Entry);
+
+    Stats.NumEntries++;
+    Stats.UsedBytes += Entry.AllocatedBytes;
+    UpdateStringPoolBytes();
+
+    return &Entry;
+}
+
+void FRestaurantTileCache::ExportDirtyTiles(TArray<FRestaurantPersistedTile>& OutTiles)
+{
+    OutTiles.Reset();
+    for (TPair<FString, TMap<uint64, FTile>>& Class : Tiles)
+    {
+        for (TPair<uint64, FTile>& Tile : Class.Value)
+        {
+            if (!Tile.Value.bDirty)
+            {
+                continue;
+            }
+
+            FRestaurantPersistedTile& Persisted = OutTiles.AddDefaulted_GetRef();
+            Persisted.QueryClass = Class.Key;
+            Persisted.Key = Tile.Key;
+            Persisted.CachedAt = Tile.Value.CachedAt;
+            Persisted.Coverage = Tile.Value.Coverage;
+            Tile.Value.Restaurants.MaterializeAll(StringPool, Persisted.Restaurants);
+            Tile.Value.bDirty = false;
+        }
+    }
+    bDirty = false;
+}
+
+void FRestaurantTileCache::MarkDirty(const TArray<FRestaurantPersistedTile>& FailedTiles)
+{
+    for (const FRestaurantPersistedTile& Failed : FailedTiles)
+    {
+        TMap<uint64, FTile>* ClassTiles = Tiles.Find(Failed.QueryClass);
+        FTile* Tile = ClassTiles ? ClassTiles->Find(Failed.Key) : nullptr;
+        if (Tile && Tile->CachedAt == Failed.CachedAt)
+        {
+            Tile->bDirty = true;
+            bDirty = true;
+        }
+    }
+}
+
+void FRestaurantTileCache::EvictExpired()
+{
+    const FDateTime Now = FDateTime::UtcNow();
+
+    for (TPair<FString, TMap<uint64, FTile>>& Class : Tiles)
+    {
+        for (auto It = Class.Value.CreateIterator(); It; ++It)
+        {
+            if ((Now - It.Value().CachedAt).GetTotalMinutes() >= TimeToLiveMinutes)
+            {
+                Stats.UsedBytes -= It.Value().AllocatedBytes;
+                Stats.NumEntries--;
+                Stats.Expirations++;
+                It.RemoveCurrent();
+            }
+        }
+    }
+
+    for (auto It = CappedAnswers.CreateIterator(); It; ++It)
+    {
+        if ((Now - It.Value().CachedAt).GetTotalMinutes() >= TimeToLiveMinutes)
+        {
+            Stats.UsedBytes -= It.Value().AllocatedBytes;
+            Stats.NumEntries--;
+            Stats.Expirations++;
+            It.RemoveCurrent();
+        }
+    }
+
+    RemoveEmptyClasses();
+    CompactStringPool();
+}
+
+void FRestaurantTileCache::EvictToFit(int64 TargetBytes)
+{
+    if (Stats.UsedBytes <= TargetBytes)
+    {
+        return;
+    }
+
+    // ClassTiles is null for a capped answer, Key is then its id
+    struct FCandidate
+    {
+        TMap<uint64, FTile>* ClassTiles;
+        uint64 Key;
+        uint64 LastAccess;
+    };
+
+    TArray<FCandidate> Candidates;
+    Candidates.Reserve(Stats.NumEntries);
+    for (TPair<FString, TMap<uint64, FTile>>& Class : Tiles)
+    {
+        for (const TPair<uint64, FTile>& Tile : Class.Value)
+        {
+            Candidates.Add({ &Class.Value, Tile.Key, Tile.Value.LastAccess });
+        }
+    }
+    for (const TPair<uint64, FCappedAnswer>& Answer : CappedAnswers)
+    {
+        Candidates.Add({ nullptr, Answer.Key, Answer.Value.LastAccess });
+    }
+
+    Candidates.Sort([](const FCandidate& A, const FCandidate& B)
+    {
+        return A.LastAccess < B.LastAccess;
+    });
+
+    for (const FCandidate& Candidate : Candidates)
+    {
+        if (Stats.UsedBytes <= TargetBytes)
+        {
+            break;
+        }
+
+        if (!Candidate.ClassTiles)
+        {
+            RemoveCappedAnswer(Candidate.Key);
+            Stats.Evictions++;
+            continue;
+        }
+
+        FTile Removed;
+        if (Candidate.ClassTiles->RemoveAndCopyValue(Candidate.Key, Removed))
+        {
+            Stats.UsedBytes -= Removed.AllocatedBytes;
+            Stats.NumEntries--;
+            Stats.Evictions++;
+        }
+    }
+
+    RemoveEmptyClasses();
+    CompactStringPool();
+}
+
+void FRestaurantTileCache::RemoveEmptyClasses()
+{
+    for (auto It = Tiles.CreateIterator(); It; ++It)
+    {
+        if (It.Value().Num() == 0)
+        {
+            It.RemoveCurrent();
+        }
+    }
+}
+
+void FRestaurantTileCache::CompactStringPool()
+{
+    // Interning never frees, so only a pool that outgrew its last rebuild may hold much garbage
+    if (StringPool.Num() < FMath::Max(2 * CompactedPoolStrings, MinStringsToCompact))
+    {
+        return;
+    }
+
+    FRestaurantStringPool NewPool;
+    for (TPair<FString, TMap<uint64, FTile>>& Class : Tiles)
+    {
+        for (TPair<uint64, FTile>& Tile : Class.Value)
+        {
+            Tile.Value.Restaurants.ReinternStrings(StringPool, NewPool);
+        }
+    }
+    for (TPair<uint64, FCappedAnswer>& Answer : CappedAnswers)
+    {
+        Answer.Value.Restaurants.ReinternStrings(StringPool, NewPool);
+    }
+
+    StringPool = MoveTemp(NewPool);
+    CompactedPoolStrings = StringPool.Num();
+    UpdateStringPoolBytes();
+}
+
+void FRestaurantTileCache::UpdateStringPoolBytes()
+{
+    const SIZE_T PoolBytes = StringPool.GetAllocatedSize();
+    Stats.UsedBytes += static_cast<int64>(PoolBytes) - static_cast<int64>(StringPoolBytes);
+    StringPoolBytes = PoolBytes;
+}
+
+void FRestaurantTileCache::Clear()
+{
+    Tiles.Empty();
+    CappedAnswers.Empty();
+    StringPool = FRestaurantStringPool();
+    StringPoolBytes = 0;
+    CompactedPoolStrings = 0;
+    Stats.NumEntries = 0;
+    Stats.UsedBytes = 0;
+    bDirty = false;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RestaurantData.h"
+#include "RestaurantCacheStore.h"
+#include "RestaurantColumnStore.h"
+
+// Search result cache keyed on Web Mercator tiles (Morton encoded) and a coarse
+// query class. Only provider results known to be complete for their circle are
+// stored. Each tile holding some of them records where it is complete: the whole
+// tile if it lies inside the circle, otherwise the circle itself. A later search
+// is answered locally when every tile its circle touches is complete for it, even
+// if it is a few meters away or uses a smaller radius. Tiles the circle touches
+// without restaurants are stored empty, so they count as covered too.
+//
+// Providers cap their answers (Google at 60 results, Yelp at its result window),
+// so a busy area is rarely known completely. Such a capped answer is kept whole
+// under its own query circle and class instead, and answers that circle and the
+// circles inside it with what the provider returned. Capped answers are not persisted.
+//
+// Tiles keep their restaurants in columnar form (FRestaurantColumns) with the
+// repetitive strings interned in one pool; rows are materialized on lookup.
+//
+// Memory is bounded: every tile and the string pool track the bytes they own,
+// tiles older than the TTL are dropped and the least recently used tiles are
+// evicted once the byte budget is exceeded. The pool is rebuilt from the
+// remaining tiles once evictions may have left it mostly unused. Tiles missing
+// from memory are faulted in from an optional persistent backing store, and only
+// tiles changed since the last save are exported to it again.
+class RESTAURANTCONCIERGE_API FRestaurantTileCache
+{
+public:
+    // ~600 m tiles at the equator, ~400 m at mid latitudes
+    static constexpr int32 TileLevel = 16;
+
+    // Only the filters that change what providers return form the query class,
+    // everything else is applied locally to the cached superset
+    static FString GetQueryClass(const FSearchFilters& Filters);
+
+    FRestaurantTileCache();
+
+    void SetLimits(int64 InBudgetBytes, float InTimeToLiveMinutes);
+
+    // Records the results of a provider search over the given circle. They must be
+    // every restaurant the providers know inside it, not a truncated page.
+    void Store(const FVector2D& Center, float RadiusMeters, const FSearchFilters& Filters, const TArray<FRestaurantData>& Results);
+
+    // Records a provider answer that was cut off by a result cap, replacing an
+    // earlier answer for the same circle
+    void StoreCapped(const FVector2D& Center, float RadiusMeters, const FSearchFilters& Filters, const TArray<FRestaurantData>& Results);
+
+    // Fills OutResults with every cached restaurant within RadiusMeters of Center.
+    // Fails unless every tile the circle touches is complete for it, or a capped answer
+    // contains the circle, and the data is younger than MaxAgeMinutes.
+    // OutAge receives the age of the oldest tile or answer used.
+    bool Lookup(const FVector2D& Center, float RadiusMeters, const FSearchFilters& Filters, float MaxAgeMinutes,
+        TArray<FRestaurantData>& OutResults, FTimespan* OutAge = nullptr);
+
+    // Drops every tile older than the TTL
+    void EvictExpired();
+
+    void Clear();
+
+    // The store is not owned and must outlive the cache or be reset to nullptr
+    void SetBackingStore(FRestaurantCacheStore* InBackingStore) { BackingStore = InBackingStore; }
+
+    // Some tile changed since it was last exported
+    bool IsDirty() const { return bDirty; }
+
+    // Snapshot of the changed tiles for FRestaurantCacheStore::WriteFile, which carries
+    // the rest over from the mapped file. Clears their dirty flags.
+    void ExportDirtyTiles(TArray<FRestaurantPersistedTile>& OutTiles);
+
+    // Hands back the tiles of a save that failed, unless they changed since
+    void MarkDirty(const TArray<FRestaurantPersistedTile>& FailedTiles);
+
+    float GetTimeToLiveMinutes() const { return TimeToLiveMinutes; }
+
+    const FRestaurantCacheStats& GetStats() const { return Stats; }
+
+private:
+    struct FTile
+    {
+        FRestaurantColumns Restaurants;
+        FDateTime CachedAt; // UTC
+        FRestaurantTileCoverage Coverage;
+        uint64 LastAccess = 0;
+        SIZE_T AllocatedBytes = 0;
+        bool bDirty = false; // Not in the backing store yet
+    };
+
+    struct FCappedAnswer
+    {
+        FString QueryClass;
+        FRestaurantColumns Restaurants;
+        FDateTime CachedAt; // UTC
+        FVector2D Center = FVector2D::ZeroVector;
+        float RadiusMeters = 0.0f;
+        uint64 LastAccess = 0;
+        SIZE_T AllocatedBytes = 0;
+    };
+
+    static SIZE_T ComputeTileBytes(const FTile& Tile);
+    static SIZE_T ComputeAnswerBytes(const FCappedAnswer& Answer);
+
+    static bool IsCovered(const FTile& Tile, const FVector2D& Center, float RadiusMeters);
+
+    // Calls Visitor for every tile that intersects the circle
+    static void ForEachTile(const FVector2D& Center, float RadiusMeters,
+        TFunctionRef<void(const FIntPoint& Tile, bool bFullyInside)> Visitor);
+
+    bool LookupTiles(const FString& QueryClass, const FVector2D& Center, float RadiusMeters, float MaxAgeMinutes,
+        const FDateTime& Now, TArray<FRestaurantData>& OutResults, FDateTime& OutCachedAt);
+    bool LookupCapped(const FString& QueryClass, const FVector2D& Center, float RadiusMeters, float MaxAgeMinutes,
+        const FDateTime& Now, TArray<FRestaurantData>& OutResults, FDateTime& OutCachedAt);
+
+    // Materializes the rows within RadiusMeters of Center into OutResults
+    void AppendRowsWithin(const FRestaurantColumns& Columns, const FVector2D& Center, float RadiusMeters, TArray<FRestaurantData>& OutResults);
+
+    void RemoveCappedAnswer(uint64 Id);
+
+    // Evicts least recently used tiles and capped answers until UsedBytes <= TargetBytes
+    void EvictToFit(int64 TargetBytes);
+
+    void RemoveEmptyClasses();
+
+    // Rebuilds StringPool from the live tiles if it doubled since it was last rebuilt
+    void CompactStringPool();
+
+    // Keeps Stats.UsedBytes in step with the pool after interning
+    void UpdateStringPoolBytes();
+
+    FTile* FaultInTile(const FString& QueryClass, TMap<uint64, FTile>& ClassTiles, uint64 Key);
+
+    // Tiles by Morton key, per query class
+    TMap<FString, TMap<uint64, FTile>> Tiles;
+
+    // Capped answers by an id of their own, any query class
+    TMap<uint64, FCappedAnswer> CappedAnswers;
+    uint64 NextCappedAnswerId = 0;
+
+    // Shared by every tile, counted in Stats.UsedBytes
+    FRestaurantStringPool StringPool;
+    SIZE_T StringPoolBytes = 0;
+    int32 CompactedPoolStrings = 0;
+
+    int64 BudgetBytes = 256ll * 1024 * 1024;
+    float TimeToLiveMinutes = 30.0f;
+    uint64 AccessCounter = 0;
+
+    FRestaurantCacheStore* BackingStore = nullptr;
+    bool bDirty = false;
+
+    FRestaurantCacheStats Stats;
+};